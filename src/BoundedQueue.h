@@ -0,0 +1,89 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef BOUNDED_QUEUE_H_
+#define BOUNDED_QUEUE_H_
+
+#include <condition_variable>
+#include <cstddef> /* std::size_t */
+#include <deque>
+#include <mutex>
+#include <utility> /* move */
+
+
+
+namespace GS {
+
+/*******************************************************************************
+ * FIFO with a maximum size, for use by many threads. push() blocks while the
+ * queue is full, so the producers cannot get ahead of the consumers.
+ */
+template<typename T>
+class BoundedQueue {
+public:
+	explicit BoundedQueue(std::size_t maxSize) : maxSize_(maxSize), closed_(false) {}
+	~BoundedQueue() {}
+
+	// Returns false, without adding the item, if the queue has been closed,
+	// even while waiting.
+	bool push(T&& item) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		notFull_.wait(lock, [&]{ return queue_.size() < maxSize_ || closed_; });
+		if (closed_) {
+			return false;
+		}
+		queue_.push_back(std::move(item));
+		notEmpty_.notify_one();
+		return true;
+	}
+
+	// Blocks while the queue is empty.
+	// Returns false if the queue has been closed and is empty.
+	bool pop(T& item) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		notEmpty_.wait(lock, [&]{ return !queue_.empty() || closed_; });
+		if (queue_.empty()) {
+			return false;
+		}
+		item = std::move(queue_.front());
+		queue_.pop_front();
+		notFull_.notify_one();
+		return true;
+	}
+
+	// The items already in the queue can still be removed.
+	void close() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		closed_ = true;
+		notEmpty_.notify_all();
+		notFull_.notify_all();
+	}
+private:
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+	const std::size_t maxSize_;
+	bool closed_;
+	std::deque<T> queue_;
+	std::mutex mutex_;
+	std::condition_variable notEmpty_;
+	std::condition_variable notFull_;
+};
+
+} /* namespace GS */
+
+#endif /* BOUNDED_QUEUE_H_ */
@@ -0,0 +1,95 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef CANCELLATION_TOKEN_H_
+#define CANCELLATION_TOKEN_H_
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+
+#include "Exception.h"
+
+
+
+namespace GS {
+
+/*******************************************************************************
+ * Cooperative cancellation of a synthesis. The synthesis checks the token
+ * between chunks, rule applications and blocks of samples, and throws
+ * CancelledException, or DeadlineExceededException, if the token has been
+ * cancelled or its deadline has passed.
+ *
+ * cancel() and setDeadline() may be called by any thread. The parent must be
+ * set by the thread that checks the token. A token is also cancelled when its
+ * parent is cancelled.
+ */
+class CancellationToken {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	explicit CancellationToken(const CancellationToken* parent = nullptr)
+			: parent_(parent), cancelled_(false), deadline_(NO_DEADLINE) {}
+	~CancellationToken() {}
+
+	void cancel() { cancelled_ = true; }
+	void setDeadline(Clock::time_point deadline) { deadline_ = deadline.time_since_epoch().count(); }
+	void clearDeadline() { deadline_ = NO_DEADLINE; }
+	void setParent(const CancellationToken* parent) { parent_ = parent; }
+
+	// Clears the cancellation and the deadline.
+	// Returns true if cancel() had been called.
+	bool reset() {
+		deadline_ = NO_DEADLINE;
+		return cancelled_.exchange(false);
+	}
+
+	bool cancelled() const {
+		return cancelled_.load(std::memory_order_relaxed) || deadlineExceeded() ||
+			(parent_ != nullptr && parent_->cancelled());
+	}
+
+	void check() const {
+		if (cancelled_.load(std::memory_order_relaxed)) {
+			THROW_EXCEPTION(CancelledException, "Cancelled.");
+		}
+		if (deadlineExceeded()) {
+			THROW_EXCEPTION(DeadlineExceededException, "The deadline has passed.");
+		}
+		if (parent_ != nullptr) {
+			parent_->check();
+		}
+	}
+private:
+	static constexpr Clock::rep NO_DEADLINE = std::numeric_limits<Clock::rep>::max();
+
+	CancellationToken(const CancellationToken&) = delete;
+	CancellationToken& operator=(const CancellationToken&) = delete;
+
+	bool deadlineExceeded() const {
+		const Clock::rep deadline = deadline_.load(std::memory_order_relaxed);
+		return deadline != NO_DEADLINE && Clock::now().time_since_epoch().count() >= deadline;
+	}
+
+	const CancellationToken* parent_;
+	std::atomic<bool> cancelled_;
+	std::atomic<Clock::rep> deadline_; // time since the epoch of the clock
+};
+
+} /* namespace GS */
+
+#endif /* CANCELLATION_TOKEN_H_ */
@@ -17,17 +17,43 @@
 
 #include "Dictionary.h"
 
+#include <cstring> /* memcmp, memcpy */
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <string>
 
 #include "Exception.h"
 #include "Log.h"
+#include "TemporaryFile.h"
 
 
 
+namespace {
+
+const char MAGIC[8] = {'G', 'S', 'D', 'I', 'C', 'T', '\0', '\0'};
+
+template<typename T>
+void
+appendValue(std::vector<char>& buffer, T value)
+{
+	const char* p = reinterpret_cast<const char*>(&value);
+	buffer.insert(buffer.end(), p, p + sizeof(T));
+}
+
+} /* namespace */
+
 namespace GS {
 
 Dictionary::Dictionary()
+		: imageData_(nullptr)
+		, imageSize_(0)
+		, entryList_(nullptr)
+		, numEntries_(0)
+		, slotList_(nullptr)
+		, slotMask_(0)
+		, pool_(nullptr)
+		, version_(nullptr)
 {
 }
 
@@ -35,66 +61,294 @@ Dictionary::~Dictionary()
 {
 }
 
+// FNV-1a.
+std::uint32_t
+Dictionary::hash(std::string_view key)
+{
+	std::uint32_t h = 2166136261U;
+	for (char c : key) {
+		h ^= static_cast<unsigned char>(c);
+		h *= 16777619U;
+	}
+	return h;
+}
+
+void
+Dictionary::clear()
+{
+	file_.close();
+	std::vector<char>().swap(image_);
+	imageData_ = nullptr;
+	imageSize_ = 0;
+	entryList_ = nullptr;
+	numEntries_ = 0;
+	slotList_ = nullptr;
+	slotMask_ = 0;
+	pool_ = nullptr;
+	version_ = nullptr;
+}
+
 void
 Dictionary::load(const char* filePath)
 {
-	map_.clear();
+	clear();
 
-	std::ifstream in(filePath, std::ios_base::in | std::ios_base::binary);
-	if (!in) {
+	if (!file_.open(filePath)) {
 		THROW_EXCEPTION(IOException, "Could not open the file " << filePath << '.');
 	}
 
-	if (!std::getline(in, version_)) {
-		THROW_EXCEPTION(IOException, "Could not read the dictionary version.");
+	try {
+		if (file_.size() >= sizeof MAGIC && std::memcmp(file_.data(), MAGIC, sizeof MAGIC) == 0) {
+			setImage(file_.data(), file_.size());
+		} else {
+			buildImage(file_.data(), file_.size());
+			file_.close();
+			setImage(image_.data(), image_.size());
+		}
+	} catch (...) {
+		clear();
+		throw;
 	}
+
 	LOG_DEBUG("Dictionary version: " << version_);
+}
 
-	std::string line;
-	while (std::getline(in, line)) {
-		auto pos = line.find_first_of(' ');
-		if (pos == std::string::npos) {
-			THROW_EXCEPTION(IOException, "Could not find a space in the line: [" << line << ']');
-		}
+void
+Dictionary::save(const char* filePath) const
+{
+	if (imageData_ == nullptr) {
+		THROW_EXCEPTION(InvalidStateException, "Empty dictionary.");
+	}
 
-		std::string key = line.substr(0, pos);
-		std::string value = line.substr(pos + 1, std::string::npos);
-		//std::cout << "key[" << key << "] value[" << value << ']' << std::endl;
+	// The destination may be the source of the image, or may be mapped by
+	// other processes, so it is replaced and not truncated.
+	TemporaryFile tempFile(filePath);
+	{
+		std::ofstream out(tempFile.path(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (!out) {
+			THROW_EXCEPTION(IOException, "Could not open the file " << tempFile.path() << '.');
+		}
+		out.write(imageData_, imageSize_);
+		out.close();
+		if (!out) {
+			THROW_EXCEPTION(IOException, "Could not write the file " << tempFile.path() << '.');
+		}
+	}
+	tempFile.commit();
+}
 
-		auto iter = map_.find(key);
-		if (iter == map_.end()) {
-			map_[key] = value;
+/*******************************************************************************
+ * Builds the image from a text dictionary.
+ *
+ * The first line contains the version. The other lines contain the word, a
+ * space and the pronunciation. If a word is repeated, only the first entry is
+ * used.
+ */
+void
+Dictionary::buildImage(const char* text, std::size_t size)
+{
+	const char* end = text + size;
+	auto nextLine = [&end](const char*& pos, std::string_view& line) -> bool {
+		if (pos == end) {
+			return false;
+		}
+		const char* lineEnd = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+		if (lineEnd == nullptr) {
+			line = std::string_view(pos, end - pos);
+			pos = end;
 		} else {
+			line = std::string_view(pos, lineEnd - pos);
+			pos = lineEnd + 1;
+		}
+		return true;
+	};
+
+	const char* pos = text;
+	std::string_view line;
+	if (!nextLine(pos, line)) {
+		THROW_EXCEPTION(IOException, "Could not read the dictionary version.");
+	}
+	const std::string_view version = line;
+	const char* firstEntryLine = pos;
+
+	std::size_t numLines = 0;
+	while (nextLine(pos, line)) {
+		++numLines;
+	}
+	std::uint32_t numSlots = 2;
+	while (numSlots < 2 * numLines) {
+		numSlots *= 2;
+	}
+	const std::uint32_t mask = numSlots - 1U;
+
+	std::vector<Entry> entryList;
+	entryList.reserve(numLines);
+	std::vector<std::uint32_t> slotList(numSlots);
+	std::vector<char> pool;
+	pool.reserve(size + numLines);
+	pool.insert(pool.end(), version.begin(), version.end());
+	pool.push_back('\0');
+
+	pos = firstEntryLine;
+	while (nextLine(pos, line)) {
+		auto spacePos = line.find_first_of(' ');
+		if (spacePos == std::string_view::npos) {
+			THROW_EXCEPTION(IOException, "Could not find a space in the line: [" << line << ']');
+		}
+		const std::string_view key = line.substr(0, spacePos);
+		const std::string_view value = line.substr(spacePos + 1);
+
+		std::uint32_t i = hash(key) & mask;
+		bool duplicate = false;
+		while (slotList[i] != 0) {
+			const Entry& entry = entryList[slotList[i] - 1U];
+			if (std::string_view(&pool[entry.keyOffset], entry.keyLength) == key) {
+				duplicate = true;
+				break;
+			}
+			i = (i + 1U) & mask;
+		}
+		if (duplicate) {
 			std::cerr << "Duplicate word: [" << key << ']' << std::endl;
-			//THROW_EXCEPTION(IOException, "Duplicate word: [" << key << ']');
+			continue;
 		}
+
+		Entry entry;
+		entry.keyOffset = pool.size();
+		entry.keyLength = key.size();
+		pool.insert(pool.end(), key.begin(), key.end());
+		pool.push_back('\0');
+		entry.valueOffset = pool.size();
+		pool.insert(pool.end(), value.begin(), value.end());
+		pool.push_back('\0');
+		entryList.push_back(entry);
+		slotList[i] = entryList.size();
 	}
+	if (pool.size() > std::numeric_limits<std::uint32_t>::max()) {
+		THROW_EXCEPTION(IOException, "The dictionary is too big.");
+	}
+
+	image_.clear();
+	image_.reserve(HEADER_SIZE + entryList.size() * sizeof(Entry) + slotList.size() * sizeof(std::uint32_t) + pool.size());
+	image_.insert(image_.end(), MAGIC, MAGIC + sizeof MAGIC);
+	appendValue<std::uint32_t>(image_, FORMAT_VERSION);
+	appendValue<std::uint32_t>(image_, BYTE_ORDER_TAG);
+	appendValue<std::uint32_t>(image_, entryList.size());
+	appendValue<std::uint32_t>(image_, numSlots);
+	appendValue<std::uint32_t>(image_, pool.size());
+	appendValue<std::uint32_t>(image_, 0); // version offset
+	for (const Entry& entry : entryList) {
+		appendValue(image_, entry);
+	}
+	for (std::uint32_t slot : slotList) {
+		appendValue(image_, slot);
+	}
+	image_.insert(image_.end(), pool.begin(), pool.end());
+}
+
+/*******************************************************************************
+ * Validates the image and sets the pointers to its sections.
+ */
+void
+Dictionary::setImage(const char* data, std::size_t size)
+{
+	if (size < HEADER_SIZE) {
+		THROW_EXCEPTION(InvalidFileException, "Invalid dictionary: truncated header.");
+	}
+	std::uint32_t header[6];
+	std::memcpy(header, data + sizeof MAGIC, sizeof header);
+	const std::uint32_t formatVersion = header[0];
+	const std::uint32_t byteOrderTag  = header[1];
+	const std::uint32_t numEntries    = header[2];
+	const std::uint32_t numSlots      = header[3];
+	const std::uint32_t poolSize      = header[4];
+	const std::uint32_t versionOffset = header[5];
+	if (formatVersion != FORMAT_VERSION) {
+		THROW_EXCEPTION(InvalidFileException, "Invalid dictionary format version: " << formatVersion << '.');
+	}
+	if (byteOrderTag != BYTE_ORDER_TAG) {
+		THROW_EXCEPTION(InvalidFileException, "Invalid dictionary byte order.");
+	}
+	if (numSlots < 2 || (numSlots & (numSlots - 1U)) != 0 || numSlots <= numEntries) {
+		THROW_EXCEPTION(InvalidFileException, "Invalid number of dictionary slots: " << numSlots << '.');
+	}
+	const std::size_t entriesSize = std::size_t(numEntries) * sizeof(Entry);
+	const std::size_t slotsSize = std::size_t(numSlots) * sizeof(std::uint32_t);
+	if (size != HEADER_SIZE + entriesSize + slotsSize + poolSize) {
+		THROW_EXCEPTION(InvalidFileException, "Invalid dictionary size.");
+	}
+
+	const auto* entryList = reinterpret_cast<const Entry*>(data + HEADER_SIZE);
+	const auto* slotList = reinterpret_cast<const std::uint32_t*>(data + HEADER_SIZE + entriesSize);
+	const char* pool = data + HEADER_SIZE + entriesSize + slotsSize;
+
+	// All the strings are null-terminated.
+	if (poolSize == 0 || pool[poolSize - 1U] != '\0' || versionOffset >= poolSize) {
+		THROW_EXCEPTION(InvalidFileException, "Invalid dictionary string pool.");
+	}
+	for (std::uint32_t i = 0; i < numEntries; ++i) {
+		const Entry& entry = entryList[i];
+		if (entry.keyOffset >= poolSize || entry.keyLength >= poolSize - entry.keyOffset ||
+				pool[entry.keyOffset + entry.keyLength] != '\0' || entry.valueOffset >= poolSize) {
+			THROW_EXCEPTION(InvalidFileException, "Invalid dictionary entry: " << i << '.');
+		}
+	}
+	// The lookup stops at an empty slot, so the table must have at least one.
+	std::uint32_t numEmptySlots = 0;
+	for (std::uint32_t i = 0; i < numSlots; ++i) {
+		if (slotList[i] > numEntries) {
+			THROW_EXCEPTION(InvalidFileException, "Invalid dictionary slot: " << i << '.');
+		}
+		if (slotList[i] == 0) {
+			++numEmptySlots;
+		}
+	}
+	if (numEmptySlots == 0) {
+		THROW_EXCEPTION(InvalidFileException, "Invalid dictionary: no empty slot.");
+	}
+
+	imageData_ = data;
+	imageSize_ = size;
+	entryList_ = entryList;
+	numEntries_ = numEntries;
+	slotList_ = slotList;
+	slotMask_ = numSlots - 1U;
+	pool_ = pool;
+	version_ = pool + versionOffset;
 }
 
 const char*
 Dictionary::getEntry(const char* word) const
 {
-	if (map_.empty()) {
+	return getEntry(std::string_view(word));
+}
+
+const char*
+Dictionary::getEntry(std::string_view word) const
+{
+	if (numEntries_ == 0) {
 		return nullptr;
 	}
 
-	std::string key(word);
-	auto iter = map_.find(key);
-	if (iter == map_.end()) {
-		return nullptr;
-	} else {
-		return iter->second.c_str();
+	std::uint32_t i = hash(word) & slotMask_;
+	while (slotList_[i] != 0) {
+		const Entry& entry = entryList_[slotList_[i] - 1U];
+		if (entry.keyLength == word.size() && std::memcmp(pool_ + entry.keyOffset, word.data(), word.size()) == 0) {
+			return pool_ + entry.valueOffset;
+		}
+		i = (i + 1U) & slotMask_;
 	}
+	return nullptr;
 }
 
 const char*
 Dictionary::version() const
 {
-	if (map_.empty()) {
+	if (numEntries_ == 0) {
 		return "None";
 	}
 
-	return version_.c_str();
+	return version_;
 }
 
 } /* namespace GS */
@@ -18,25 +18,79 @@
 #ifndef DICTIONARY_H_
 #define DICTIONARY_H_
 
-#include <string>
-#include <unordered_map>
+#include <cstddef> /* std::size_t */
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.h"
 
 namespace GS {
 
+/*******************************************************************************
+ * Pronunciation dictionary.
+ *
+ * The entries are kept in a single image, with a hash index and a string pool.
+ * The image is built when a text dictionary is loaded, and can be saved to a
+ * binary file, which is memory-mapped when it is loaded. The binary file uses
+ * the native byte order.
+ *
+ * Image:
+ *     char[8] magic
+ *     uint32  format version
+ *     uint32  byte order tag
+ *     uint32  number of entries
+ *     uint32  number of slots (power of two)
+ *     uint32  size of the string pool
+ *     uint32  offset of the version string in the pool
+ *     Entry[number of entries]
+ *     uint32[number of slots]  (entry index + 1, or 0 if the slot is empty)
+ *     char[size of the string pool]  (null-terminated strings)
+ */
 class Dictionary {
 public:
 	Dictionary();
 	~Dictionary();
 
+	// Loads a text dictionary, or a binary dictionary created by save().
 	void load(const char* filePath);
+	void save(const char* filePath) const;
+
+	// The returned string is valid until the dictionary is modified.
 	const char* getEntry(const char* word) const;
+	const char* getEntry(std::string_view word) const;
 	const char* version() const;
+	std::size_t size() const { return numEntries_; }
 private:
+	enum {
+		FORMAT_VERSION = 1,
+		BYTE_ORDER_TAG = 0x01020304,
+		HEADER_SIZE = 8 + 6 * 4
+	};
+	struct Entry {
+		std::uint32_t keyOffset;
+		std::uint32_t keyLength;
+		std::uint32_t valueOffset;
+	};
+
 	Dictionary(const Dictionary&) = delete;
 	Dictionary& operator=(const Dictionary&) = delete;
 
-	std::unordered_map<std::string, std::string> map_;
-	std::string version_;
+	static std::uint32_t hash(std::string_view key);
+	void clear();
+	void buildImage(const char* text, std::size_t size);
+	void setImage(const char* data, std::size_t size);
+
+	MappedFile file_;
+	std::vector<char> image_; // used if the dictionary was loaded from a text file
+	const char* imageData_;
+	std::size_t imageSize_;
+	const Entry* entryList_;
+	std::uint32_t numEntries_;
+	const std::uint32_t* slotList_;
+	std::uint32_t slotMask_;
+	const char* pool_;
+	const char* version_;
 };
 
 } /* namespace GS */
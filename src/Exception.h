@@ -169,6 +169,8 @@ protected:
 	ExceptionString message_;
 };
 
+class CancelledException                : public Exception {};
+class DeadlineExceededException         : public CancelledException {};
 class EndOfBufferException              : public Exception {};
 class ExternalProgramExecutionException : public Exception {};
 class InvalidCallException              : public Exception {};
@@ -0,0 +1,95 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "MappedFile.h"
+
+#include <fstream>
+#include <iterator> /* istreambuf_iterator */
+
+#ifdef _MSC_VER
+# define GS_MAPPED_FILE_NO_MMAP
+#else
+# include <fcntl.h> /* open */
+# include <sys/mman.h> /* mmap, munmap */
+# include <sys/stat.h> /* fstat */
+# include <unistd.h> /* close */
+#endif
+
+
+
+namespace GS {
+
+MappedFile::MappedFile()
+		: data_(nullptr)
+		, size_(0)
+		, mapped_(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool
+MappedFile::open(const std::string& filePath)
+{
+	close();
+
+#ifndef GS_MAPPED_FILE_NO_MMAP
+	int fd = ::open(filePath.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED) {
+			data_ = static_cast<const char*>(p);
+			size_ = st.st_size;
+			mapped_ = true;
+			::close(fd);
+			return true;
+		}
+	}
+	::close(fd);
+#endif
+	std::ifstream in(filePath, std::ios_base::in | std::ios_base::binary);
+	if (!in) {
+		return false;
+	}
+	buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	data_ = buffer_.data();
+	size_ = buffer_.size();
+	return true;
+}
+
+void
+MappedFile::close()
+{
+#ifndef GS_MAPPED_FILE_NO_MMAP
+	if (mapped_) {
+		munmap(const_cast<char*>(data_), size_);
+	}
+#endif
+	data_ = nullptr;
+	size_ = 0;
+	mapped_ = false;
+	std::vector<char>().swap(buffer_);
+}
+
+} /* namespace GS */
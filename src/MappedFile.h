@@ -0,0 +1,58 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef> /* std::size_t */
+#include <string>
+#include <vector>
+
+
+
+namespace GS {
+
+/*******************************************************************************
+ * Read-only view of the contents of a file.
+ *
+ * The file is memory-mapped if the platform supports it, otherwise it is
+ * read into memory.
+ */
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+
+	// Returns false if the file could not be opened.
+	bool open(const std::string& filePath);
+	void close();
+
+	const char* data() const { return data_; }
+	std::size_t size() const { return size_; }
+private:
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const char* data_;
+	std::size_t size_;
+	bool mapped_;
+	std::vector<char> buffer_; // used if the file is not mapped
+};
+
+} /* namespace GS */
+
+#endif /* MAPPED_FILE_H_ */
@@ -0,0 +1,100 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef SPSC_RING_BUFFER_H_
+#define SPSC_RING_BUFFER_H_
+
+#include <algorithm> /* min */
+#include <atomic>
+#include <cstddef> /* std::size_t */
+#include <cstring> /* memcpy */
+#include <type_traits>
+#include <vector>
+
+
+
+namespace GS {
+
+/*******************************************************************************
+ * Lock-free FIFO for one producer thread and one consumer thread. The memory
+ * is allocated by the constructor, so write() and read() do not allocate
+ * memory, lock or make system calls, and may be called by a real-time thread.
+ *
+ * The capacity is rounded up to a power of two.
+ */
+template<typename T>
+class SPSCRingBuffer {
+	static_assert(std::is_trivially_copyable<T>::value, "The elements must be trivially copyable.");
+public:
+	explicit SPSCRingBuffer(std::size_t capacity) : writePos_(0), readPos_(0) {
+		std::size_t size = 1;
+		while (size < capacity) {
+			size *= 2;
+		}
+		buffer_.resize(size);
+		mask_ = size - 1U;
+	}
+	~SPSCRingBuffer() {}
+
+	std::size_t capacity() const { return buffer_.size(); }
+
+	// Called by the producer.
+	std::size_t writeAvailable() const {
+		return buffer_.size() - (writePos_.load(std::memory_order_relaxed) - readPos_.load(std::memory_order_acquire));
+	}
+
+	// Called by the consumer.
+	std::size_t readAvailable() const {
+		return writePos_.load(std::memory_order_acquire) - readPos_.load(std::memory_order_relaxed);
+	}
+
+	// Called by the producer. Returns the number of elements written.
+	std::size_t write(const T* data, std::size_t count) {
+		const std::size_t pos = writePos_.load(std::memory_order_relaxed);
+		count = std::min(count, buffer_.size() - (pos - readPos_.load(std::memory_order_acquire)));
+		const std::size_t begin = pos & mask_;
+		const std::size_t count1 = std::min(count, buffer_.size() - begin);
+		std::memcpy(&buffer_[begin], data, count1 * sizeof(T));
+		std::memcpy(&buffer_[0], data + count1, (count - count1) * sizeof(T));
+		writePos_.store(pos + count, std::memory_order_release);
+		return count;
+	}
+
+	// Called by the consumer. Returns the number of elements read.
+	std::size_t read(T* data, std::size_t count) {
+		const std::size_t pos = readPos_.load(std::memory_order_relaxed);
+		count = std::min(count, writePos_.load(std::memory_order_acquire) - pos);
+		const std::size_t begin = pos & mask_;
+		const std::size_t count1 = std::min(count, buffer_.size() - begin);
+		std::memcpy(data, &buffer_[begin], count1 * sizeof(T));
+		std::memcpy(data + count1, &buffer_[0], (count - count1) * sizeof(T));
+		readPos_.store(pos + count, std::memory_order_release);
+		return count;
+	}
+private:
+	SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+	SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+
+	std::vector<T> buffer_;
+	std::size_t mask_;
+	alignas(64) std::atomic<std::size_t> writePos_; // modified only by the producer
+	alignas(64) std::atomic<std::size_t> readPos_;  // modified only by the consumer
+};
+
+} /* namespace GS */
+
+#endif /* SPSC_RING_BUFFER_H_ */
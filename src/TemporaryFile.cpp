@@ -0,0 +1,91 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "TemporaryFile.h"
+
+#include <cerrno>
+#include <cstdio> /* remove, rename */
+#include <cstring> /* strerror */
+#include <vector>
+
+#ifdef _MSC_VER
+# include <fcntl.h> /* _O_CREAT, _O_EXCL */
+# include <io.h> /* _close, _mktemp_s, _open */
+# include <sys/stat.h> /* _S_IREAD, _S_IWRITE */
+#else
+# include <stdlib.h> /* mkstemp */
+# include <sys/stat.h> /* fchmod */
+# include <unistd.h> /* close */
+#endif
+
+#include "Exception.h"
+
+
+
+namespace GS {
+
+TemporaryFile::TemporaryFile(const std::string& destinationPath)
+		: destinationPath_(destinationPath)
+		, committed_(false)
+{
+	std::string pattern = destinationPath + ".XXXXXX";
+	std::vector<char> name(pattern.begin(), pattern.end());
+	name.push_back('\0');
+#ifdef _MSC_VER
+	int fd = -1;
+	if (_mktemp_s(name.data(), name.size()) == 0) {
+		fd = _open(name.data(), _O_CREAT | _O_EXCL | _O_WRONLY, _S_IREAD | _S_IWRITE);
+	}
+	if (fd == -1) {
+		THROW_EXCEPTION(IOException, "Could not create a temporary file for " << destinationPath
+				<< ": " << std::strerror(errno) << '.');
+	}
+	_close(fd);
+#else
+	const int fd = mkstemp(name.data());
+	if (fd == -1) {
+		THROW_EXCEPTION(IOException, "Could not create a temporary file for " << destinationPath
+				<< ": " << std::strerror(errno) << '.');
+	}
+	// mkstemp uses 0600, but the file replaces a shared cache file.
+	fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	::close(fd);
+#endif
+	path_ = name.data();
+}
+
+TemporaryFile::~TemporaryFile()
+{
+	if (!committed_) {
+		std::remove(path_.c_str());
+	}
+}
+
+void
+TemporaryFile::commit()
+{
+	if (std::rename(path_.c_str(), destinationPath_.c_str()) != 0) {
+		// Some platforms don't replace the destination file.
+		std::remove(destinationPath_.c_str());
+		if (std::rename(path_.c_str(), destinationPath_.c_str()) != 0) {
+			THROW_EXCEPTION(IOException, "Could not rename the file " << path_ << " to " << destinationPath_ << '.');
+		}
+	}
+	committed_ = true;
+}
+
+} /* namespace GS */
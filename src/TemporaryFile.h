@@ -0,0 +1,53 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef TEMPORARY_FILE_H_
+#define TEMPORARY_FILE_H_
+
+#include <string>
+
+
+
+namespace GS {
+
+/*******************************************************************************
+ * File with a unique name, created in the directory of a destination file.
+ *
+ * The contents are written to path() and then commit() renames the file to
+ * the destination, so concurrent writers never share a temporary file and
+ * readers never see a partial file. If commit() is not called, the file is
+ * removed by the destructor.
+ */
+class TemporaryFile {
+public:
+	explicit TemporaryFile(const std::string& destinationPath);
+	~TemporaryFile();
+
+	const std::string& path() const { return path_; }
+	void commit();
+private:
+	TemporaryFile(const TemporaryFile&) = delete;
+	TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+	std::string destinationPath_;
+	std::string path_;
+	bool committed_;
+};
+
+} /* namespace GS */
+
+#endif /* TEMPORARY_FILE_H_ */
@@ -30,13 +30,13 @@
 
 
 #define BITS_PER_SAMPLE 16
+#define SAMPLE_SCALE INT16_MAX
 
 
 
 namespace GS {
 
 WAVEFileWriter::WAVEFileWriter(const char* filePath, int channels, int numberSamples, float outputRate)
-		: sampleScale_(INT16_MAX)
 {
 	stream_ = fopen(filePath, "wb"); // the b is for non-POSIX systems
 	if (stream_ == NULL) {
@@ -51,6 +51,31 @@ WAVEFileWriter::~WAVEFileWriter()
 	fclose(stream_);
 }
 
+/******************************************************************************
+*
+*       function:       writeFile
+*
+*       purpose:        Writes the header and the samples to a new file.
+*
+*       buffer: [-1.0, 1.0], interleaved if there are two channels
+*
+******************************************************************************/
+void
+WAVEFileWriter::writeFile(const char* filePath, const std::vector<float>& buffer, int channels, float outputRate)
+{
+	const int numberSamples = buffer.size() / channels;
+	WAVEFileWriter fileWriter(filePath, channels, numberSamples, outputRate);
+	if (channels == 1) {
+		for (float sample : buffer) {
+			fileWriter.writeSample(sample);
+		}
+	} else {
+		for (int i = 0; i < numberSamples; ++i) {
+			fileWriter.writeStereoSamples(buffer[2 * i], buffer[2 * i + 1]);
+		}
+	}
+}
+
 /******************************************************************************
 *
 *       function:       writeWaveFileHeader
@@ -60,6 +85,21 @@ WAVEFileWriter::~WAVEFileWriter()
 ******************************************************************************/
 void
 WAVEFileWriter::writeWaveFileHeader(int channels, int numberSamples, float outputRate)
+{
+	std::string header;
+	appendHeader(header, channels, numberSamples, outputRate);
+	fwrite(header.data(), sizeof(char), header.size(), stream_);
+}
+
+/******************************************************************************
+*
+*       function:       appendHeader
+*
+*       purpose:        Appends the header in WAVE format to the data.
+*
+******************************************************************************/
+void
+WAVEFileWriter::appendHeader(std::string& data, int channels, int numberSamples, float outputRate)
 {
 	int dataChunkSize = channels * numberSamples * sizeof(std::int16_t);
 	int formSize = 4 + 24 + (8 + dataChunkSize);
@@ -67,43 +107,79 @@ WAVEFileWriter::writeWaveFileHeader(int channels, int numberSamples, float outpu
 	int bytesPerSecond = static_cast<int>(std::ceil(outputRate * frameSize));
 
 	/*  Form container identifier  */
-	fputs("RIFF", stream_);
+	data += "RIFF";
 
 	/*  Form size  */
-	writeUInt32LE(formSize);
+	appendUInt32LE(data, formSize);
 
 	/*  Form container type  */
-	fputs("WAVE", stream_);
+	data += "WAVE";
 
 	/*  Format chunk identifier (Note: space after 't' needed)  */
-	fputs("fmt ", stream_);
+	data += "fmt ";
 
 	/*  Chunk size (fixed at 16 bytes)  */
-	writeUInt32LE(16);
+	appendUInt32LE(data, 16);
 
 	/*  Compression code: 1 = PCM  */
-	writeUInt16LE(1);
+	appendUInt16LE(data, 1);
 
 	/*  Number of channels  */
-	writeUInt16LE(channels);
+	appendUInt16LE(data, channels);
 
 	/*  Output Sample Rate  */
-	writeUInt32LE(static_cast<int>(std::round(outputRate)));
+	appendUInt32LE(data, static_cast<int>(std::round(outputRate)));
 
 	/*  Bytes per second  */
-	writeUInt32LE(bytesPerSecond);
+	appendUInt32LE(data, bytesPerSecond);
 
 	/*  Block alignment (frame size)  */
-	writeUInt16LE(frameSize);
+	appendUInt16LE(data, frameSize);
 
 	/*  Bits per sample  */
-	writeUInt16LE(BITS_PER_SAMPLE);
+	appendUInt16LE(data, BITS_PER_SAMPLE);
 
 	/*  Sound Data chunk identifier  */
-	fputs("data", stream_);
+	data += "data";
 
 	/*  Chunk size  */
-	writeUInt32LE(dataChunkSize);
+	appendUInt32LE(data, dataChunkSize);
+}
+
+/******************************************************************************
+*
+*       function:       appendSamples
+*
+*       purpose:        Scales the samples, rounds them to a short (16-bit)
+*                       integer, and appends them to the data in
+*                       little-endian format.
+*
+*       samples: [-1.0, 1.0]
+*
+******************************************************************************/
+void
+WAVEFileWriter::appendSamples(std::string& data, const float* samples, std::size_t size)
+{
+	data.reserve(data.size() + size * sizeof(std::int16_t));
+	for (std::size_t i = 0; i < size; ++i) {
+		appendUInt16LE(data, sampleValue(samples[i]));
+	}
+}
+
+/******************************************************************************
+*
+*       function:       sampleValue
+*
+*       purpose:        Scales the sample and rounds it to a short (16-bit)
+*                       integer.
+*
+*       sample: [-1.0, 1.0]
+*
+******************************************************************************/
+int
+WAVEFileWriter::sampleValue(float sample)
+{
+	return static_cast<int>(std::round(sample * SAMPLE_SCALE));
 }
 
 /******************************************************************************
@@ -121,7 +197,7 @@ WAVEFileWriter::writeWaveFileHeader(int channels, int numberSamples, float outpu
 void
 WAVEFileWriter::writeSample(float sample)
 {
-	writeUInt16LE(static_cast<int>(std::round(sample * sampleScale_)));
+	writeUInt16LE(sampleValue(sample));
 }
 
 /******************************************************************************
@@ -139,31 +215,44 @@ WAVEFileWriter::writeSample(float sample)
 void
 WAVEFileWriter::writeStereoSamples(float leftSample, float rightSample)
 {
-	writeUInt16LE(static_cast<int>(std::round(leftSample * sampleScale_)));
-	writeUInt16LE(static_cast<int>(std::round(rightSample * sampleScale_)));
+	writeUInt16LE(sampleValue(leftSample));
+	writeUInt16LE(sampleValue(rightSample));
 }
 
 /******************************************************************************
 *
-*       function:       writeUInt32LE
+*       function:       appendUInt32LE
 *
-*       purpose:        Writes a 4-byte integer to the file stream, starting
+*       purpose:        Appends a 4-byte integer to the data, starting
 *                       with the least significant byte (i.e. writes the int
 *                       in little-endian form).  This routine will work on both
 *                       big-endian and little-endian architectures.
 *
 ******************************************************************************/
 void
-WAVEFileWriter::writeUInt32LE(int data)
+WAVEFileWriter::appendUInt32LE(std::string& data, int value)
 {
-	unsigned char array[4];
-
-	array[0] =  data        & 0xff;
-	array[1] = (data >> 8)  & 0xff;
-	array[2] = (data >> 16) & 0xff;
-	array[3] = (data >> 24) & 0xff;
+	data += static_cast<char>( value        & 0xff);
+	data += static_cast<char>((value >> 8)  & 0xff);
+	data += static_cast<char>((value >> 16) & 0xff);
+	data += static_cast<char>((value >> 24) & 0xff);
+}
 
-	fwrite(array, sizeof(unsigned char), 4, stream_);
+/******************************************************************************
+*
+*       function:       appendUInt16LE
+*
+*       purpose:        Appends a 2-byte integer to the data, starting
+*                       with the least significant byte (i.e. writes the int
+*                       in little-endian form). This routine will work on both
+*                       big-endian and little-endian architectures.
+*
+******************************************************************************/
+void
+WAVEFileWriter::appendUInt16LE(std::string& data, int value)
+{
+	data += static_cast<char>( value       & 0xff);
+	data += static_cast<char>((value >> 8) & 0xff);
 }
 
 /******************************************************************************
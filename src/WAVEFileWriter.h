@@ -23,7 +23,10 @@
 #ifndef WAVE_FILE_WRITER_H_
 #define WAVE_FILE_WRITER_H_
 
+#include <cstddef> /* std::size_t */
 #include <cstdio>
+#include <string>
+#include <vector>
 
 
 
@@ -38,16 +41,25 @@ public:
 
 	void writeSample(float sample);
 	void writeStereoSamples(float leftSample, float rightSample);
+
+	// Writes the samples, interleaved if there are two channels, to a file.
+	static void writeFile(const char* filePath, const std::vector<float>& buffer, int channels, float outputRate);
+
+	// Append the same data as the file writer to a memory buffer.
+	// The samples are interleaved if there are two channels.
+	static void appendHeader(std::string& data, int channels, int numberSamples, float outputRate);
+	static void appendSamples(std::string& data, const float* samples, std::size_t size);
 private:
 	WAVEFileWriter(const WAVEFileWriter&) = delete;
 	WAVEFileWriter& operator=(const WAVEFileWriter&) = delete;
 
 	void writeWaveFileHeader(int channels, int numberSamples, float outputRate);
-	void writeUInt32LE(int data);
 	void writeUInt16LE(int data);
+	static int sampleValue(float sample);
+	static void appendUInt32LE(std::string& data, int value);
+	static void appendUInt16LE(std::string& data, int value);
 
 	FILE* stream_;
-	float sampleScale_;
 };
 
 } /* namespace GS */
@@ -0,0 +1,307 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "batch/BatchCoordinator.h"
+
+#ifndef GS_NO_WORKER_PROCESSES
+
+#include <algorithm> /* none_of, remove */
+#include <cerrno>
+#include <cstring> /* strerror */
+#include <exception>
+#include <iostream>
+#include <sstream>
+
+#include <poll.h> /* poll */
+#include <signal.h> /* kill */
+#include <sys/wait.h> /* waitpid */
+#include <unistd.h> /* close, fork, pipe, read */
+
+#include "batch/BatchSynthesis.h"
+#include "batch/PipeBatchListener.h"
+#include "Exception.h"
+#include "Log.h"
+
+
+
+namespace {
+
+const unsigned int MAX_ITEM_ATTEMPTS   = 2; // an utterance fails if it is being synthesized in this number of crashes
+const unsigned int MAX_WORKER_RESTARTS = 3; // consecutive restarts without progress
+const double PROGRESS_INTERVAL = 10.0; // seconds
+
+} /* namespace */
+
+namespace GS {
+
+BatchCoordinator::BatchCoordinator(const char* configDirPath, const BatchResources& resources, const std::vector<BatchItem>& itemList,
+					unsigned int numThreads, BatchListener& listener)
+		: configDirPath_(configDirPath)
+		, resources_(resources)
+		, itemList_(itemList)
+		, numThreads_(numThreads)
+		, listener_(listener)
+		, stateList_(itemList.size(), ITEM_DONE)
+		, attemptsList_(itemList.size())
+		, numItems_(0)
+		, numDone_(0)
+{
+}
+
+// Only reached with running workers if an exception was thrown.
+BatchCoordinator::~BatchCoordinator()
+{
+	for (Worker& worker : workerList_) {
+		if (worker.fd >= 0) {
+			close(worker.fd);
+		}
+		if (worker.pid > 0) {
+			kill(worker.pid, SIGKILL);
+			waitpid(worker.pid, nullptr, 0);
+		}
+	}
+}
+
+void
+BatchCoordinator::run(const std::vector<std::size_t>& indexList, unsigned int numProcesses)
+{
+	numItems_ = indexList.size();
+	if (numProcesses > numItems_) {
+		numProcesses = std::max<std::size_t>(numItems_, 1);
+	}
+	workerList_.resize(numProcesses);
+	for (Worker& worker : workerList_) {
+		worker.pid = 0;
+		worker.fd = -1;
+		worker.progress = false;
+		worker.restarts = 0;
+	}
+	for (std::size_t i = 0; i < indexList.size(); ++i) {
+		stateList_[indexList[i]] = ITEM_PENDING;
+		workerList_[i % numProcesses].shard.push_back(indexList[i]);
+	}
+	lastReportTime_ = std::chrono::steady_clock::now();
+	for (Worker& worker : workerList_) {
+		startWorker(worker);
+	}
+
+	std::vector<pollfd> pollList;
+	std::vector<Worker*> pollWorkerList;
+	for (;;) {
+		pollList.clear();
+		pollWorkerList.clear();
+		for (Worker& worker : workerList_) {
+			if (worker.fd >= 0) {
+				pollfd p;
+				p.fd = worker.fd;
+				p.events = POLLIN;
+				p.revents = 0;
+				pollList.push_back(p);
+				pollWorkerList.push_back(&worker);
+			}
+		}
+		if (pollList.empty()) break;
+
+		if (poll(pollList.data(), pollList.size(), -1) < 0) {
+			if (errno == EINTR) continue;
+			THROW_EXCEPTION(IOException, "Could not wait for the worker processes: " << std::strerror(errno) << '.');
+		}
+		for (std::size_t i = 0; i < pollList.size(); ++i) {
+			if (pollList[i].revents != 0) {
+				receive(*pollWorkerList[i]);
+			}
+		}
+		reportProgress();
+	}
+}
+
+bool
+BatchCoordinator::startWorker(Worker& worker)
+{
+	std::vector<std::size_t> indexList;
+	for (std::size_t item : worker.shard) {
+		if (stateList_[item] == ITEM_PENDING) {
+			indexList.push_back(item);
+		}
+	}
+	if (indexList.empty()) {
+		return false;
+	}
+
+	int fds[2];
+	if (pipe(fds) < 0) {
+		THROW_EXCEPTION(UnavailableResourceException, "Could not create a pipe: " << std::strerror(errno) << '.');
+	}
+	std::cout.flush();
+	std::cerr.flush();
+	const pid_t pid = fork();
+	if (pid < 0) {
+		const int error = errno;
+		close(fds[0]);
+		close(fds[1]);
+		THROW_EXCEPTION(UnavailableResourceException, "Could not create a worker process: " << std::strerror(error) << '.');
+	}
+	if (pid == 0) {
+		/*** Worker process ***/
+		close(fds[0]);
+		for (const Worker& other : workerList_) {
+			if (other.fd >= 0) {
+				close(other.fd);
+			}
+		}
+		int exitStatus = 0;
+		try {
+			PipeBatchListener listener(fds[1]);
+			synthesizeItems(configDirPath_, resources_, itemList_, indexList, numThreads_, listener);
+		} catch (std::exception& e) {
+			std::cerr << "Caught an exception in a worker process: " << e.what() << std::endl;
+			exitStatus = 1;
+		}
+		_exit(exitStatus);
+	}
+
+	close(fds[1]);
+	worker.pid = pid;
+	worker.fd = fds[0];
+	worker.progress = false;
+	if (Log::debugEnabled) {
+		std::cout << "Started the worker process " << pid << " with " << indexList.size() << " utterances." << std::endl;
+	}
+	return true;
+}
+
+void
+BatchCoordinator::receive(Worker& worker)
+{
+	char buffer[4096];
+	const ssize_t n = read(worker.fd, buffer, sizeof buffer);
+	if (n < 0) {
+		if (errno == EINTR) return;
+		THROW_EXCEPTION(IOException, "Could not read from a worker process: " << std::strerror(errno) << '.');
+	}
+	if (n > 0) {
+		worker.input.append(buffer, n);
+		std::size_t begin = 0;
+		for (std::size_t end; (end = worker.input.find('\n', begin)) != std::string::npos; begin = end + 1) {
+			handleMessage(worker, worker.input.substr(begin, end - begin));
+		}
+		worker.input.erase(0, begin);
+		return;
+	}
+
+	/*** End of file: the worker has finished or crashed ***/
+	close(worker.fd);
+	worker.fd = -1;
+	worker.input.clear();
+	int status;
+	while (waitpid(worker.pid, &status, 0) < 0) {
+		if (errno != EINTR) {
+			THROW_EXCEPTION(IOException, "Could not wait for a worker process: " << std::strerror(errno) << '.');
+		}
+	}
+	worker.pid = 0;
+	handleExit(worker, status);
+}
+
+void
+BatchCoordinator::handleMessage(Worker& worker, const std::string& message)
+{
+	std::istringstream in(message);
+	char type;
+	std::size_t item;
+	if (!(in >> type >> item) || item >= itemList_.size() || stateList_[item] == ITEM_DONE) {
+		std::cerr << "Invalid message from a worker process: [" << message << "]." << std::endl;
+		return;
+	}
+	if (type == 'S') {
+		stateList_[item] = ITEM_RUNNING;
+		worker.runningList.push_back(item);
+		return;
+	}
+
+	worker.runningList.erase(std::remove(worker.runningList.begin(), worker.runningList.end(), item), worker.runningList.end());
+	stateList_[item] = ITEM_DONE;
+	++numDone_;
+	worker.progress = true;
+	if (type == 'D') {
+		double audioSeconds = 0.0;
+		in >> audioSeconds;
+		listener_.finished(item, audioSeconds);
+	} else {
+		std::string text;
+		in.get(); // space
+		std::getline(in, text);
+		listener_.failed(item, text.c_str());
+	}
+}
+
+void
+BatchCoordinator::handleExit(Worker& worker, int status)
+{
+	std::ostringstream description;
+	if (WIFSIGNALED(status)) {
+		description << "The worker process was terminated by the signal " << WTERMSIG(status) << '.';
+	} else {
+		description << "The worker process exited with the status " << WEXITSTATUS(status) << '.';
+	}
+
+	for (std::size_t item : worker.runningList) {
+		if (++attemptsList_[item] >= MAX_ITEM_ATTEMPTS) {
+			stateList_[item] = ITEM_DONE;
+			++numDone_;
+			worker.progress = true;
+			listener_.failed(item, description.str().c_str());
+		} else {
+			stateList_[item] = ITEM_PENDING;
+		}
+	}
+	worker.runningList.clear();
+
+	const bool complete = std::none_of(worker.shard.begin(), worker.shard.end(),
+						[&](std::size_t item) { return stateList_[item] == ITEM_PENDING; });
+	if (complete) {
+		return;
+	}
+	std::cerr << description.str() << std::endl;
+
+	worker.restarts = worker.progress ? 0 : worker.restarts + 1;
+	if (worker.restarts > MAX_WORKER_RESTARTS) {
+		for (std::size_t item : worker.shard) {
+			if (stateList_[item] == ITEM_PENDING) {
+				stateList_[item] = ITEM_DONE;
+				++numDone_;
+				listener_.failed(item, description.str().c_str());
+			}
+		}
+		return;
+	}
+	startWorker(worker);
+}
+
+void
+BatchCoordinator::reportProgress()
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (std::chrono::duration<double>(now - lastReportTime_).count() >= PROGRESS_INTERVAL) {
+		lastReportTime_ = now;
+		std::cout << "Progress: " << numDone_ << '/' << numItems_ << " utterances" << std::endl;
+	}
+}
+
+} /* namespace GS */
+
+#endif /* GS_NO_WORKER_PROCESSES */
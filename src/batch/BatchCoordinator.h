@@ -0,0 +1,99 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef BATCH_BATCH_COORDINATOR_H_
+#define BATCH_BATCH_COORDINATOR_H_
+
+#include "global.h"
+
+#ifndef GS_NO_WORKER_PROCESSES
+
+#include <chrono>
+#include <cstddef> /* std::size_t */
+#include <string>
+#include <vector>
+
+#include <sys/types.h> /* pid_t */
+
+#include "batch/BatchItem.h"
+#include "batch/BatchListener.h"
+#include "batch/BatchResources.h"
+
+
+
+namespace GS {
+
+/*******************************************************************************
+ * Distributes the utterances among worker processes, in interleaved shards.
+ * The workers are created with fork after the model and the dictionaries have
+ * been loaded, so their pages are shared with the coordinator (the binary
+ * files are also mapped in memory). Each worker synthesizes its shard with
+ * synthesizeItems, and sends its progress through a pipe.
+ *
+ * If a worker crashes, the utterances that it was synthesizing are retried,
+ * and a new worker continues with the rest of the shard.
+ */
+class BatchCoordinator {
+public:
+	BatchCoordinator(const char* configDirPath, const BatchResources& resources, const std::vector<BatchItem>& itemList,
+				unsigned int numThreads, BatchListener& listener);
+	~BatchCoordinator();
+
+	void run(const std::vector<std::size_t>& indexList, unsigned int numProcesses);
+private:
+	enum ItemState {
+		ITEM_PENDING,
+		ITEM_RUNNING,
+		ITEM_DONE
+	};
+	struct Worker {
+		pid_t pid;
+		int fd;
+		std::vector<std::size_t> shard;
+		std::vector<std::size_t> runningList;
+		std::string input;
+		bool progress; // since the last start
+		unsigned int restarts;
+	};
+
+	BatchCoordinator(const BatchCoordinator&) = delete;
+	BatchCoordinator& operator=(const BatchCoordinator&) = delete;
+
+	bool startWorker(Worker& worker);
+	void receive(Worker& worker);
+	void handleMessage(Worker& worker, const std::string& message);
+	void handleExit(Worker& worker, int status);
+	void reportProgress();
+
+	const char* configDirPath_;
+	const BatchResources& resources_;
+	const std::vector<BatchItem>& itemList_;
+	const unsigned int numThreads_;
+	BatchListener& listener_;
+	std::vector<ItemState> stateList_;
+	std::vector<unsigned int> attemptsList_;
+	std::vector<Worker> workerList_;
+	std::size_t numItems_;
+	std::size_t numDone_;
+	std::chrono::steady_clock::time_point lastReportTime_;
+};
+
+} /* namespace GS */
+
+#endif /* GS_NO_WORKER_PROCESSES */
+
+#endif /* BATCH_BATCH_COORDINATOR_H_ */
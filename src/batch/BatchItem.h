@@ -0,0 +1,36 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef BATCH_BATCH_ITEM_H_
+#define BATCH_BATCH_ITEM_H_
+
+#include <string>
+
+
+
+namespace GS {
+
+// An utterance of the manifest.
+struct BatchItem {
+	std::string id;
+	std::string text;
+	std::string outputFile;
+};
+
+} /* namespace GS */
+
+#endif /* BATCH_BATCH_ITEM_H_ */
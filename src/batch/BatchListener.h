@@ -1,6 +1,5 @@
 /***************************************************************************
- *  Copyright 1991, 1992, 1993, 1994, 1995, 1996, 2001, 2002               *
- *    David R. Hill, Leonard Manzara, Craig Schock                         *
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
  *                                                                         *
  *  This program is free software: you can redistribute it and/or modify   *
  *  it under the terms of the GNU General Public License as published by   *
@@ -15,42 +14,29 @@
  *  You should have received a copy of the GNU General Public License      *
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
  ***************************************************************************/
-// 2014-09
-// This file was copied from Gnuspeech and modified by Marcelo Y. Matuda.
 
-#include "en/letter_to_sound/member.h"
+#ifndef BATCH_BATCH_LISTENER_H_
+#define BATCH_BATCH_LISTENER_H_
+
+#include <cstddef> /* std::size_t */
 
 
 
 namespace GS {
-namespace En {
-
-/******************************************************************************
-*
-*	function:	member
-*
-*	purpose:	Return true if element in set, false otherwise.
-*			
-*       arguments:      element, set
-*                       
-*	internal
-*	functions:	none
-*
-*	library
-*	functions:	none
-*
-******************************************************************************/
-int
-member(char element, const char* set)
-{
-	while (*set) {
-		if (element == *set++) {
-			return 1;
-		}
-	}
-
-	return 0;
-}
-
-} /* namespace En */
+
+/*******************************************************************************
+ * Receives the progress of the synthesis of a batch. The items are indexes in
+ * the manifest. The calls are serialized.
+ */
+class BatchListener {
+public:
+	virtual ~BatchListener() {}
+
+	virtual void started(std::size_t item) = 0;
+	virtual void finished(std::size_t item, double audioSeconds) = 0;
+	virtual void failed(std::size_t item, const char* message) = 0;
+};
+
 } /* namespace GS */
+
+#endif /* BATCH_BATCH_LISTENER_H_ */
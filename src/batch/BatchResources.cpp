@@ -0,0 +1,46 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "batch/BatchResources.h"
+
+#include "global.h"
+#include "TRMControlModelConfiguration.h"
+
+
+
+namespace GS {
+
+void
+BatchResources::load(const char* configDirPath)
+{
+	TRMControlModel::Configuration trmControlConfig;
+	trmControlConfig.load(std::string(configDirPath) + TRM_CONTROL_MODEL_CONFIGURATION_FILE);
+	model.setBinaryCacheEnabled(trmControlConfig.modelCacheEnabled);
+	model.load(configDirPath, TRM_CONTROL_MODEL_CONFIG_FILE);
+
+	textParser.reset(new En::TextParser(configDirPath,
+					trmControlConfig.dictionary1File,
+					trmControlConfig.dictionary2File,
+					trmControlConfig.dictionary3File));
+	textParser->setModel(model);
+	if (trmControlConfig.pronunciationCacheFile != "none") {
+		pronunciationCacheFile = std::string(configDirPath) + '/' + trmControlConfig.pronunciationCacheFile;
+		textParser->loadPronunciationCache(pronunciationCacheFile);
+	}
+}
+
+} /* namespace GS */
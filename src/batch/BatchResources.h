@@ -0,0 +1,46 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef BATCH_BATCH_RESOURCES_H_
+#define BATCH_BATCH_RESOURCES_H_
+
+#include <memory>
+#include <string>
+
+#include "Model.h"
+#include "en/text_parser/TextParser.h"
+
+
+
+namespace GS {
+
+/*******************************************************************************
+ * The model and the text parser are shared by all the threads and, in the
+ * multi-process mode, by all the worker processes.
+ */
+struct BatchResources {
+	// Loads the model, the dictionaries and the pronunciation cache.
+	void load(const char* configDirPath);
+
+	TRMControlModel::Model model;
+	std::unique_ptr<En::TextParser> textParser;
+	std::string pronunciationCacheFile; // empty if the cache is disabled
+};
+
+} /* namespace GS */
+
+#endif /* BATCH_BATCH_RESOURCES_H_ */
@@ -0,0 +1,60 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "batch/BatchSummary.h"
+
+#include <iostream>
+
+
+
+namespace GS {
+
+BatchSummary::BatchSummary(const std::vector<BatchItem>& itemList, std::ofstream* indexOut)
+		: itemList_(itemList)
+		, indexOut_(indexOut)
+		, failures_(0)
+		, audioSeconds_(0.0)
+{
+}
+
+BatchSummary::~BatchSummary()
+{
+}
+
+void
+BatchSummary::started(std::size_t /*item*/)
+{
+}
+
+void
+BatchSummary::finished(std::size_t item, double audioSeconds)
+{
+	audioSeconds_ += audioSeconds;
+	if (indexOut_ != nullptr) {
+		const BatchItem& batchItem = itemList_[item];
+		*indexOut_ << batchItem.id << '\t' << batchItem.outputFile << std::endl;
+	}
+}
+
+void
+BatchSummary::failed(std::size_t item, const char* message)
+{
+	++failures_;
+	std::cerr << "Error in " << itemList_[item].id << ": " << message << std::endl;
+}
+
+} /* namespace GS */
@@ -0,0 +1,59 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef BATCH_BATCH_SUMMARY_H_
+#define BATCH_BATCH_SUMMARY_H_
+
+#include <cstddef> /* std::size_t */
+#include <fstream>
+#include <vector>
+
+#include "batch/BatchItem.h"
+#include "batch/BatchListener.h"
+
+
+
+namespace GS {
+
+/*******************************************************************************
+ * Writes the index, counts the failures and the duration of the audio.
+ */
+class BatchSummary : public BatchListener {
+public:
+	// indexOut may be nullptr.
+	BatchSummary(const std::vector<BatchItem>& itemList, std::ofstream* indexOut);
+	virtual ~BatchSummary();
+
+	virtual void started(std::size_t item);
+	virtual void finished(std::size_t item, double audioSeconds);
+	virtual void failed(std::size_t item, const char* message);
+
+	unsigned long failures() const { return failures_; }
+	double audioSeconds() const { return audioSeconds_; }
+private:
+	BatchSummary(const BatchSummary&) = delete;
+	BatchSummary& operator=(const BatchSummary&) = delete;
+
+	const std::vector<BatchItem>& itemList_;
+	std::ofstream* indexOut_;
+	unsigned long failures_;
+	double audioSeconds_;
+};
+
+} /* namespace GS */
+
+#endif /* BATCH_BATCH_SUMMARY_H_ */
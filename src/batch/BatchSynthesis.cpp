@@ -0,0 +1,263 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "batch/BatchSynthesis.h"
+
+#include <algorithm> /* max */
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility> /* move */
+
+#include "batch/BatchCoordinator.h"
+#include "batch/BatchSummary.h"
+#include "BoundedQueue.h"
+#include "en/Synthesizer.h"
+#include "Log.h"
+#include "WAVEFileWriter.h"
+
+
+
+namespace {
+
+struct BatchOutput {
+	std::size_t item;
+	std::vector<float> buffer;
+	int channels;
+	float outputRate;
+};
+
+} /* namespace */
+
+namespace GS {
+
+/*******************************************************************************
+ * Each line of the manifest contains an id, the text and the output file,
+ * separated by tabs.
+ */
+bool
+readManifest(const char* manifestFile, std::vector<BatchItem>& itemList, unsigned long& invalidLines)
+{
+	std::ifstream in(manifestFile, std::ios_base::in | std::ios_base::binary);
+	if (!in) {
+		std::cerr << "Could not open the file " << manifestFile << '.' << std::endl;
+		return false;
+	}
+	std::string line;
+	for (unsigned long lineNumber = 1; std::getline(in, line); ++lineNumber) {
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		if (line.empty()) continue;
+		const std::size_t tab1 = line.find('\t');
+		const std::size_t tab2 = (tab1 == std::string::npos) ? tab1 : line.find('\t', tab1 + 1);
+		if (tab2 == std::string::npos || line.find('\t', tab2 + 1) != std::string::npos || tab2 + 1 == line.size()) {
+			std::cerr << "Invalid line in the manifest: " << lineNumber << '.' << std::endl;
+			++invalidLines;
+			continue;
+		}
+		itemList.emplace_back();
+		BatchItem& item = itemList.back();
+		item.id = line.substr(0, tab1);
+		item.text = line.substr(tab1 + 1, tab2 - tab1 - 1);
+		item.outputFile = line.substr(tab2 + 1);
+	}
+	return true;
+}
+
+/*******************************************************************************
+ * Each line of the index contains the id and the output file of a finished
+ * utterance, separated by a tab. The lines are appended after the files have
+ * been written. An incomplete last line, left by an interrupted run, is
+ * ignored, and the function returns true.
+ */
+bool
+readIndex(const char* indexFile, std::unordered_set<std::string>& finishedSet)
+{
+	std::ifstream in(indexFile, std::ios_base::in | std::ios_base::binary);
+	std::string line;
+	while (std::getline(in, line)) {
+		if (in.eof()) {
+			return true;
+		}
+		finishedSet.insert(line);
+	}
+	return false;
+}
+
+/*******************************************************************************
+ * Each thread has its own synthesizer, and takes the next utterance from the
+ * list when it finishes the previous one. The files are written by another
+ * thread.
+ */
+void
+synthesizeItems(const char* configDirPath, const BatchResources& resources, const std::vector<BatchItem>& itemList,
+		const std::vector<std::size_t>& indexList, unsigned int numThreads, BatchListener& listener)
+{
+	if (numThreads > indexList.size()) {
+		numThreads = std::max<std::size_t>(indexList.size(), 1);
+	}
+	std::vector<std::unique_ptr<En::Synthesizer>> synthesizerList;
+	for (unsigned int i = 0; i < numThreads; ++i) {
+		synthesizerList.emplace_back(new En::Synthesizer(configDirPath, resources.model, *resources.textParser));
+	}
+
+	std::mutex listenerMutex;
+	auto reportError = [&](std::size_t item, const char* message) {
+		std::lock_guard<std::mutex> lock(listenerMutex);
+		listener.failed(item, message);
+	};
+
+	// The synthesized utterances wait here to be written.
+	BoundedQueue<BatchOutput> outputQueue(2 * numThreads);
+	std::thread writerThread([&]() {
+		BatchOutput output;
+		while (outputQueue.pop(output)) {
+			try {
+				WAVEFileWriter::writeFile(itemList[output.item].outputFile.c_str(), output.buffer, output.channels, output.outputRate);
+			} catch (std::exception& e) {
+				reportError(output.item, e.what());
+				continue;
+			}
+			std::lock_guard<std::mutex> lock(listenerMutex);
+			listener.finished(output.item, output.buffer.size() / (output.channels * static_cast<double>(output.outputRate)));
+		}
+	});
+
+	std::atomic<std::size_t> nextIndex(0);
+	std::vector<std::thread> threadList;
+	for (auto& synthesizer : synthesizerList) {
+		threadList.emplace_back([&, synth = synthesizer.get()]() {
+			for (std::size_t i = nextIndex++; i < indexList.size(); i = nextIndex++) {
+				BatchOutput output;
+				output.item = indexList[i];
+				{
+					std::lock_guard<std::mutex> lock(listenerMutex);
+					listener.started(output.item);
+				}
+				try {
+					synth->synthesize(itemList[output.item].text, output.buffer);
+				} catch (std::exception& e) {
+					reportError(output.item, e.what());
+					continue;
+				}
+				output.channels = synth->channels();
+				output.outputRate = synth->outputRate();
+				outputQueue.push(std::move(output));
+			}
+		});
+	}
+	for (auto& thread : threadList) {
+		thread.join();
+	}
+	outputQueue.close();
+	writerThread.join();
+}
+
+/*******************************************************************************
+ * The model, the dictionaries and the configuration are loaded once.
+ *
+ * If an index file is used, the utterances that are already in the index, and
+ * whose output files exist, are skipped.
+ */
+int
+synthesizeBatch(const char* configDirPath, const char* manifestFile, const char* indexFile,
+		unsigned int numProcesses, unsigned int numThreads)
+{
+	std::vector<BatchItem> itemList;
+	unsigned long invalidLines = 0;
+	if (!readManifest(manifestFile, itemList, invalidLines)) {
+		return 1;
+	}
+
+	std::vector<std::size_t> indexList;
+	std::ofstream indexOut;
+	if (indexFile != nullptr) {
+		std::unordered_set<std::string> finishedSet;
+		const bool incompleteLine = readIndex(indexFile, finishedSet);
+		for (std::size_t i = 0; i < itemList.size(); ++i) {
+			const BatchItem& item = itemList[i];
+			if (finishedSet.count(item.id + '\t' + item.outputFile) == 0 ||
+					!std::ifstream(item.outputFile, std::ios_base::in | std::ios_base::binary)) {
+				indexList.push_back(i);
+			}
+		}
+		if (indexList.size() < itemList.size()) {
+			std::cout << "Skipping " << itemList.size() - indexList.size() << " utterances that are in the index." << std::endl;
+		}
+		indexOut.open(indexFile, std::ios_base::out | std::ios_base::binary | std::ios_base::app);
+		if (!indexOut) {
+			std::cerr << "Could not open the file " << indexFile << '.' << std::endl;
+			return 1;
+		}
+		if (incompleteLine) {
+			indexOut << '\n';
+		}
+	} else {
+		for (std::size_t i = 0; i < itemList.size(); ++i) {
+			indexList.push_back(i);
+		}
+	}
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	BatchResources resources;
+	resources.load(configDirPath);
+
+	BatchSummary summary(itemList, indexFile != nullptr ? &indexOut : nullptr);
+	if (numProcesses > 1) {
+		// The pronunciation cache is not saved, because the words added by
+		// the worker processes are lost.
+#ifndef GS_NO_WORKER_PROCESSES
+		BatchCoordinator coordinator(configDirPath, resources, itemList, numThreads, summary);
+		coordinator.run(indexList, numProcesses);
+#endif
+	} else {
+		synthesizeItems(configDirPath, resources, itemList, indexList, numThreads, summary);
+
+		if (Log::debugEnabled) {
+			resources.textParser->printPronunciationCacheStatistics();
+		}
+		if (!resources.pronunciationCacheFile.empty()) {
+			try {
+				resources.textParser->savePronunciationCache(resources.pronunciationCacheFile);
+			} catch (std::exception& e) {
+				std::cerr << "Could not save the pronunciation cache: " << e.what() << std::endl;
+			}
+		}
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	const unsigned long failures = summary.failures() + invalidLines;
+	const std::size_t numUtterances = indexList.size() + invalidLines;
+	std::cout << "Utterances: " << numUtterances << "  Failures: " << failures;
+	if (numProcesses > 1) {
+		std::cout << "  Processes: " << numProcesses;
+	}
+	std::cout << "  Threads: " << numThreads << "  Time: " << seconds << " s\n"
+		<< "Utterances/s: " << (numUtterances - failures) / seconds
+		<< "  Audio-seconds/s: " << summary.audioSeconds() / seconds << std::endl;
+
+	return (failures == 0) ? 0 : 1;
+}
+
+} /* namespace GS */
@@ -0,0 +1,50 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef BATCH_BATCH_SYNTHESIS_H_
+#define BATCH_BATCH_SYNTHESIS_H_
+
+#include <cstddef> /* std::size_t */
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "batch/BatchItem.h"
+#include "batch/BatchListener.h"
+#include "batch/BatchResources.h"
+
+
+
+namespace GS {
+
+// Each line of the manifest contains an id, the text and the output file,
+// separated by tabs. The invalid lines are counted and skipped.
+bool readManifest(const char* manifestFile, std::vector<BatchItem>& itemList, unsigned long& invalidLines);
+// Returns true if the last line of the index is incomplete.
+bool readIndex(const char* indexFile, std::unordered_set<std::string>& finishedSet);
+
+// Synthesizes the items in indexList, in this process.
+void synthesizeItems(const char* configDirPath, const BatchResources& resources, const std::vector<BatchItem>& itemList,
+		const std::vector<std::size_t>& indexList, unsigned int numThreads, BatchListener& listener);
+
+// Synthesizes the manifest, and returns the exit status of the program.
+int synthesizeBatch(const char* configDirPath, const char* manifestFile, const char* indexFile,
+		unsigned int numProcesses, unsigned int numThreads);
+
+} /* namespace GS */
+
+#endif /* BATCH_BATCH_SYNTHESIS_H_ */
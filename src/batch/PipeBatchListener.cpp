@@ -0,0 +1,85 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "batch/PipeBatchListener.h"
+
+#ifndef GS_NO_WORKER_PROCESSES
+
+#include <algorithm> /* replace */
+#include <cerrno>
+#include <sstream>
+
+#include <unistd.h> /* _exit, write */
+
+
+
+namespace GS {
+
+PipeBatchListener::PipeBatchListener(int fd)
+		: fd_(fd)
+{
+}
+
+PipeBatchListener::~PipeBatchListener()
+{
+}
+
+void
+PipeBatchListener::started(std::size_t item)
+{
+	std::ostringstream out;
+	out << "S " << item << '\n';
+	send(out.str());
+}
+
+void
+PipeBatchListener::finished(std::size_t item, double audioSeconds)
+{
+	std::ostringstream out;
+	out.precision(17);
+	out << "D " << item << ' ' << audioSeconds << '\n';
+	send(out.str());
+}
+
+void
+PipeBatchListener::failed(std::size_t item, const char* message)
+{
+	std::string text = message;
+	std::replace(text.begin(), text.end(), '\n', ' ');
+	std::ostringstream out;
+	out << "F " << item << ' ' << text << '\n';
+	send(out.str());
+}
+
+// If the coordinator is gone, there is nothing left to do.
+void
+PipeBatchListener::send(const std::string& data)
+{
+	std::size_t pos = 0;
+	while (pos < data.size()) {
+		const ssize_t n = write(fd_, data.data() + pos, data.size() - pos);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			_exit(1);
+		}
+		pos += n;
+	}
+}
+
+} /* namespace GS */
+
+#endif /* GS_NO_WORKER_PROCESSES */
@@ -0,0 +1,62 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef BATCH_PIPE_BATCH_LISTENER_H_
+#define BATCH_PIPE_BATCH_LISTENER_H_
+
+#include "global.h"
+
+#ifndef GS_NO_WORKER_PROCESSES
+
+#include <cstddef> /* std::size_t */
+#include <string>
+
+#include "batch/BatchListener.h"
+
+
+
+namespace GS {
+
+/*******************************************************************************
+ * Sends the progress of a worker process to the coordinator, one line per
+ * event:
+ *     S item
+ *     D item audio_seconds
+ *     F item message
+ */
+class PipeBatchListener : public BatchListener {
+public:
+	explicit PipeBatchListener(int fd);
+	virtual ~PipeBatchListener();
+
+	virtual void started(std::size_t item);
+	virtual void finished(std::size_t item, double audioSeconds);
+	virtual void failed(std::size_t item, const char* message);
+private:
+	PipeBatchListener(const PipeBatchListener&) = delete;
+	PipeBatchListener& operator=(const PipeBatchListener&) = delete;
+
+	void send(const std::string& data);
+
+	const int fd_;
+};
+
+} /* namespace GS */
+
+#endif /* GS_NO_WORKER_PROCESSES */
+
+#endif /* BATCH_PIPE_BATCH_LISTENER_H_ */
@@ -0,0 +1,233 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "en/RealTimeSynthesizer.h"
+
+#include <algorithm> /* fill */
+#include <chrono>
+#include <exception>
+
+#include "Exception.h"
+#include "Log.h"
+
+#define TEXT_QUEUE_SIZE 16
+#define WARM_UP_TEXT "Hello."
+#define WRITE_RETRY_INTERVAL_MS 1
+
+
+
+namespace GS {
+namespace En {
+
+RealTimeSynthesizer::RealTimeSynthesizer(const char* configDirPath, const TRMControlModel::Model& model,
+				const TextParser& textParser, const TRMControlModel::VoiceSet& voiceSet, double bufferSeconds)
+		: RealTimeSynthesizer(configDirPath, model, textParser, voiceSet, nullptr, bufferSeconds)
+{
+}
+
+RealTimeSynthesizer::RealTimeSynthesizer(const char* configDirPath, const TRMControlModel::Model& model,
+				const TextParser& textParser, const TRMControlModel::VoiceSet& voiceSet,
+				const Synthesizer::Parameters& parameters, double bufferSeconds)
+		: RealTimeSynthesizer(configDirPath, model, textParser, voiceSet, &parameters, bufferSeconds)
+{
+}
+
+RealTimeSynthesizer::RealTimeSynthesizer(const char* configDirPath, const TRMControlModel::Model& model,
+				const TextParser& textParser, const TRMControlModel::VoiceSet& voiceSet,
+				const Synthesizer::Parameters* parameters, double bufferSeconds)
+		: synthesizer_(configDirPath, model, textParser, voiceSet)
+		, outputRate_(warmUp(parameters))
+		, channels_(synthesizer_.channels())
+		, ringBuffer_(ringBufferSize(bufferSeconds))
+		, textQueue_(TEXT_QUEUE_SIZE)
+		, pendingTexts_(0)
+		, writing_(false)
+		, stopped_(false)
+		, latencyFirst_(false)
+		, pulledFrames_(0)
+		, underruns_(0)
+		, underrunFrames_(0)
+		, lateSegments_(0)
+		, errors_(0)
+		, texts_(0)
+		, totalFirstAudioLatency_(0)
+		, maxFirstAudioLatency_(0)
+{
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "The counters must be lock-free.");
+	static_assert(std::atomic<bool>::is_always_lock_free, "The flags must be lock-free.");
+
+	synthesizer_.setCancellationToken(&cancellationToken_);
+	workerThread_ = std::thread(&RealTimeSynthesizer::run, this);
+}
+
+RealTimeSynthesizer::~RealTimeSynthesizer()
+{
+	stop();
+}
+
+// Sets the parameters, and synthesizes a short text, to get the output
+// format and to allocate the buffers before the real-time processing.
+float
+RealTimeSynthesizer::warmUp(const Synthesizer::Parameters* parameters)
+{
+	if (parameters != nullptr) {
+		synthesizer_.setParameters(*parameters);
+	}
+	synthesizer_.synthesize(WARM_UP_TEXT, buffer_);
+	return synthesizer_.outputRate();
+}
+
+std::size_t
+RealTimeSynthesizer::ringBufferSize(double bufferSeconds) const
+{
+	if (!(bufferSeconds > 0.0)) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid buffer duration: " << bufferSeconds << '.');
+	}
+	return static_cast<std::size_t>(bufferSeconds * outputRate_) * channels_;
+}
+
+void
+RealTimeSynthesizer::speak(const std::string& text)
+{
+	if (stopped_) {
+		THROW_EXCEPTION(InvalidStateException, "The synthesizer has been stopped.");
+	}
+	++pendingTexts_;
+	if (!textQueue_.push(Text{text, std::chrono::steady_clock::now()})) {
+		--pendingTexts_;
+		THROW_EXCEPTION(InvalidStateException, "The synthesizer has been stopped.");
+	}
+}
+
+void
+RealTimeSynthesizer::pull(float* out, std::size_t numFrames)
+{
+	const std::size_t numSamples = numFrames * channels_;
+	const std::size_t n = ringBuffer_.read(out, numSamples);
+	if (n < numSamples) {
+		std::fill(out + n, out + numSamples, 0.0f);
+		if (writing_.load(std::memory_order_acquire)) {
+			underruns_.fetch_add(1, std::memory_order_relaxed);
+			underrunFrames_.fetch_add((numSamples - n) / channels_, std::memory_order_relaxed);
+		}
+	}
+	pulledFrames_.fetch_add(numFrames, std::memory_order_relaxed);
+}
+
+bool
+RealTimeSynthesizer::idle() const
+{
+	return pendingTexts_.load(std::memory_order_acquire) == 0 && ringBuffer_.readAvailable() == 0;
+}
+
+RealTimeSynthesizer::Statistics
+RealTimeSynthesizer::statistics() const
+{
+	Statistics s;
+	s.pulledFrames   = pulledFrames_.load(std::memory_order_relaxed);
+	s.underruns      = underruns_.load(std::memory_order_relaxed);
+	s.underrunFrames = underrunFrames_.load(std::memory_order_relaxed);
+	s.lateSegments   = lateSegments_.load(std::memory_order_relaxed);
+	s.errors         = errors_.load(std::memory_order_relaxed);
+	s.texts          = texts_.load(std::memory_order_relaxed);
+	s.meanFirstAudioLatency = (s.texts == 0) ? 0.0 :
+					1.0e-6 * totalFirstAudioLatency_.load(std::memory_order_relaxed) / s.texts;
+	s.maxFirstAudioLatency  = 1.0e-6 * maxFirstAudioLatency_.load(std::memory_order_relaxed);
+	return s;
+}
+
+void
+RealTimeSynthesizer::stop()
+{
+	if (!workerThread_.joinable()) {
+		return;
+	}
+
+	stopped_ = true;
+	cancellationToken_.cancel();
+	textQueue_.close();
+	workerThread_.join();
+}
+
+void
+RealTimeSynthesizer::run()
+{
+	Text text;
+	while (textQueue_.pop(text)) {
+		if (!stopped_) {
+			try {
+				bool firstSegment = true;
+				synthesizer_.setLatencyFirst(latencyFirst_);
+				synthesizer_.synthesizeSegments(text.text, buffer_,
+					[&](const std::vector<float>& buffer) -> bool {
+						if (firstSegment) {
+							addFirstAudioLatency(text.time);
+						} else if (ringBuffer_.readAvailable() == 0) {
+							lateSegments_.fetch_add(1, std::memory_order_relaxed);
+						}
+						firstSegment = false;
+						writing_.store(true, std::memory_order_release);
+						return writeSegment(buffer);
+					});
+			} catch (CancelledException&) {
+				// stopped
+			} catch (std::exception& e) {
+				errors_.fetch_add(1, std::memory_order_relaxed);
+				LOG_ERROR("[RealTimeSynthesizer] Error: " << e.what());
+			}
+		}
+		writing_.store(false, std::memory_order_release);
+		--pendingTexts_;
+	}
+}
+
+void
+RealTimeSynthesizer::addFirstAudioLatency(std::chrono::steady_clock::time_point speakTime)
+{
+	const std::uint64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(
+					std::chrono::steady_clock::now() - speakTime).count();
+	texts_.fetch_add(1, std::memory_order_relaxed);
+	totalFirstAudioLatency_.fetch_add(latency, std::memory_order_relaxed);
+	if (latency > maxFirstAudioLatency_.load(std::memory_order_relaxed)) {
+		maxFirstAudioLatency_.store(latency, std::memory_order_relaxed); // only the worker modifies the value
+	}
+}
+
+// Returns false if the synthesizer has been stopped.
+bool
+RealTimeSynthesizer::writeSegment(const std::vector<float>& buffer)
+{
+	const float* data = buffer.data();
+	std::size_t remaining = buffer.size();
+	for (;;) {
+		// The buffer holds whole frames, and the reads remove whole frames,
+		// so only whole frames are written.
+		const std::size_t n = ringBuffer_.write(data, remaining);
+		data += n;
+		remaining -= n;
+		if (remaining == 0) {
+			return true;
+		}
+		if (stopped_) {
+			return false;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(WRITE_RETRY_INTERVAL_MS));
+	}
+}
+
+} /* namespace En */
+} /* namespace GS */
@@ -0,0 +1,149 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef EN_REAL_TIME_SYNTHESIZER_H_
+#define EN_REAL_TIME_SYNTHESIZER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef> /* std::size_t */
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.h"
+#include "CancellationToken.h"
+#include "Model.h"
+#include "SPSCRingBuffer.h"
+#include "VoiceSet.h"
+#include "en/Synthesizer.h"
+#include "en/text_parser/TextParser.h"
+
+
+
+namespace GS {
+namespace En {
+
+/*******************************************************************************
+ * Synthesizes text in a worker thread, a little ahead of a real-time consumer
+ * (e.g. an audio callback) that pulls the samples with pull().
+ *
+ * pull() does not allocate memory, lock or make system calls.
+ *
+ * Each sentence is synthesized as a separate utterance (see
+ * Synthesizer::synthesizeSegments), because the tube outputs the samples only
+ * after the whole utterance has been synthesized. The sentences are scaled by
+ * the same factor, so the loudness is stable.
+ */
+class RealTimeSynthesizer {
+public:
+	struct Statistics {
+		std::uint64_t pulledFrames;
+		std::uint64_t underruns;      // calls to pull() that did not get all the frames of an utterance
+		std::uint64_t underrunFrames; // silent frames inserted in the utterances
+		std::uint64_t lateSegments;   // sentences that were ready after the buffer had been emptied
+		std::uint64_t errors;
+		// Time from speak() until the first samples of the text were synthesized.
+		std::uint64_t texts;
+		double meanFirstAudioLatency; // seconds
+		double maxFirstAudioLatency;  // seconds
+	};
+
+	// bufferSeconds: maximum time that the synthesis may run ahead of the consumer.
+	// The default parameters of the configuration are used.
+	RealTimeSynthesizer(const char* configDirPath, const TRMControlModel::Model& model, const TextParser& textParser,
+			const TRMControlModel::VoiceSet& voiceSet, double bufferSeconds);
+	RealTimeSynthesizer(const char* configDirPath, const TRMControlModel::Model& model, const TextParser& textParser,
+			const TRMControlModel::VoiceSet& voiceSet, const Synthesizer::Parameters& parameters,
+			double bufferSeconds);
+	~RealTimeSynthesizer();
+
+	// Adds the text to the synthesis queue.
+	// Blocks if there are too many texts waiting. Throws
+	// InvalidStateException if the synthesizer has been stopped, also
+	// while blocked.
+	void speak(const std::string& text);
+
+	// Enables the latency-first mode of the synthesizer (see
+	// Synthesizer::setLatencyFirst) for the next texts.
+	void setLatencyFirst(bool enabled) { latencyFirst_ = enabled; }
+
+	// Copies the next numFrames frames to out. If the synthesis is late,
+	// the missing frames are filled with zeros.
+	// Must be called by only one thread.
+	void pull(float* out, std::size_t numFrames);
+
+	// Returns true if all the texts have been synthesized and pulled.
+	bool idle() const;
+	// Returns true while there are texts waiting or being synthesized.
+	bool synthesizing() const { return pendingTexts_.load(std::memory_order_acquire) > 0; }
+	// Number of frames that can be pulled without an underrun.
+	std::size_t availableFrames() const { return ringBuffer_.readAvailable() / channels_; }
+
+	Statistics statistics() const;
+	float outputRate() const { return outputRate_; }
+	int channels() const { return channels_; }
+
+	// Stops the worker thread. The synthesis in progress is cancelled, and
+	// the texts still in the queue are discarded.
+	void stop();
+private:
+	RealTimeSynthesizer(const RealTimeSynthesizer&) = delete;
+	RealTimeSynthesizer& operator=(const RealTimeSynthesizer&) = delete;
+
+	struct Text {
+		std::string text;
+		std::chrono::steady_clock::time_point time; // when speak() was called
+	};
+
+	RealTimeSynthesizer(const char* configDirPath, const TRMControlModel::Model& model, const TextParser& textParser,
+			const TRMControlModel::VoiceSet& voiceSet, const Synthesizer::Parameters* parameters,
+			double bufferSeconds);
+
+	float warmUp(const Synthesizer::Parameters* parameters);
+	std::size_t ringBufferSize(double bufferSeconds) const;
+	void run();
+	void addFirstAudioLatency(std::chrono::steady_clock::time_point speakTime);
+	bool writeSegment(const std::vector<float>& buffer);
+
+	CancellationToken cancellationToken_;
+	Synthesizer synthesizer_;
+	std::vector<float> buffer_;
+	float outputRate_;
+	int channels_;
+	SPSCRingBuffer<float> ringBuffer_;
+	BoundedQueue<Text> textQueue_;
+	std::atomic<int> pendingTexts_;
+	std::atomic<bool> writing_; // true while the worker is writing an utterance
+	std::atomic<bool> stopped_;
+	std::atomic<bool> latencyFirst_;
+	std::atomic<std::uint64_t> pulledFrames_;
+	std::atomic<std::uint64_t> underruns_;
+	std::atomic<std::uint64_t> underrunFrames_;
+	std::atomic<std::uint64_t> lateSegments_;
+	std::atomic<std::uint64_t> errors_;
+	std::atomic<std::uint64_t> texts_;
+	std::atomic<std::uint64_t> totalFirstAudioLatency_; // microseconds
+	std::atomic<std::uint64_t> maxFirstAudioLatency_;   // microseconds
+	std::thread workerThread_;
+};
+
+} /* namespace En */
+} /* namespace GS */
+
+#endif /* EN_REAL_TIME_SYNTHESIZER_H_ */
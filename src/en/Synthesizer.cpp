@@ -0,0 +1,215 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "en/Synthesizer.h"
+
+#include "Exception.h"
+
+
+
+namespace {
+
+// Synthesized with each voice to find the reference sample value of the
+// segments. The peaks of other sentences may be higher.
+const char* const CALIBRATION_TEXT = "The quick brown fox jumps over the lazy dog.";
+const double CALIBRATION_HEADROOM = 1.25;
+
+GS::En::Synthesizer::Parameters
+getParameters(const GS::TRMControlModel::Configuration& config)
+{
+	GS::En::Synthesizer::Parameters parameters;
+	parameters.voiceName   = config.voiceName;
+	parameters.tempo       = config.tempo;
+	parameters.pitchOffset = config.pitchOffset;
+	parameters.intonation  = config.intonation;
+	return parameters;
+}
+
+void
+checkTextParser(const GS::En::TextParser& textParser, const GS::TRMControlModel::Model& model)
+{
+	if (textParser.model() != &model) {
+		THROW_EXCEPTION(GS::InvalidParameterException, "The text parser does not use the model of the synthesizer.");
+	}
+}
+
+} /* namespace */
+
+namespace GS {
+namespace En {
+
+Synthesizer::Synthesizer(const char* configDirPath, const TRMControlModel::Model& model, const TextParser& textParser)
+		: textParser_(textParser)
+		, controller_(configDirPath, model)
+		, phoneticStringParser_(configDirPath, controller_)
+		, defaultConfig_(controller_.trmControlModelConfiguration())
+		, defaultParameters_(getParameters(defaultConfig_))
+		, voiceName_(defaultConfig_.voiceName)
+		, referenceSampleValue_(0.0)
+		, latencyFirst_(false)
+		, cancellationToken_(nullptr)
+{
+	checkTextParser(textParser, model);
+}
+
+Synthesizer::Synthesizer(const char* configDirPath, const TRMControlModel::Model& model, const TextParser& textParser,
+				const TRMControlModel::VoiceSet& voiceSet)
+		: textParser_(textParser)
+		, controller_(configDirPath, model, voiceSet)
+		, phoneticStringParser_(configDirPath, controller_)
+		, defaultConfig_(controller_.trmControlModelConfiguration())
+		, defaultParameters_(getParameters(defaultConfig_))
+		, voiceName_(defaultConfig_.voiceName)
+		, referenceSampleValue_(0.0)
+		, latencyFirst_(false)
+		, cancellationToken_(nullptr)
+{
+	checkTextParser(textParser, model);
+}
+
+Synthesizer::~Synthesizer()
+{
+}
+
+void
+Synthesizer::resetConfiguration()
+{
+	setVoice(defaultConfig_.voiceName);
+	configuration() = defaultConfig_;
+}
+
+void
+Synthesizer::setVoice(const std::string& voiceName)
+{
+	if (voiceName == voiceName_) {
+		configuration().voiceName = voiceName_;
+		return;
+	}
+	voiceName_.clear(); // in case of error
+	controller_.setVoice(voiceName);
+	voiceName_ = voiceName;
+}
+
+void
+Synthesizer::setCancellationToken(const CancellationToken* token)
+{
+	cancellationToken_ = token;
+	controller_.setCancellationToken(token);
+	trm_.setCancellationToken(token);
+}
+
+void
+Synthesizer::synthesize(const std::string& text, std::vector<float>& buffer)
+{
+	std::istringstream textIn(text);
+	TextSegmenter textSegmenter(textIn);
+	if (!textSegmenter.getSegment(inputText_)) {
+		THROW_EXCEPTION(InvalidValueException, "Empty text.");
+	}
+
+	trmParamStream_.str(std::string());
+	trmParamStream_.clear();
+	bool hasSegment = true;
+	controller_.synthesizeTokenLists(phoneticStringParser_,
+		[&]() -> const PhoneticTokenList* {
+			if (!hasSegment) {
+				return nullptr;
+			}
+			checkCancellation();
+			textParser_.parseText(inputText_.c_str(), textParserContext_, tokenList_);
+			hasSegment = textSegmenter.getSegment(inputText_);
+			return &tokenList_;
+		},
+		trmParamStream_);
+
+	trm_.setReferenceSampleValue(0.0);
+	trm_.synthesizeToBuffer(trmParamStream_, buffer);
+}
+
+void
+Synthesizer::setParameters(const Parameters& parameters)
+{
+	if (parameters.tempo <= 0.0) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid tempo: " << parameters.tempo << '.');
+	}
+	setVoice(parameters.voiceName);
+	TRMControlModel::Configuration& config = configuration();
+	config.tempo       = parameters.tempo;
+	config.pitchOffset = parameters.pitchOffset;
+	config.intonation  = parameters.intonation;
+}
+
+void
+Synthesizer::synthesize(const std::string& text, const Parameters& parameters, std::vector<float>& buffer)
+{
+	setParameters(parameters);
+	synthesize(text, buffer);
+}
+
+// The segments are scaled by a reference sample value, found for each voice
+// by the synthesis of a calibration text.
+void
+Synthesizer::prepareSegmentScale(std::vector<float>& buffer)
+{
+	if (referenceVoiceName_ != voiceName_ || referenceSampleValue_ <= 0.0) {
+		trm_.setReferenceSampleValue(0.0);
+		textParser_.parseText(CALIBRATION_TEXT, textParserContext_, tokenList_);
+		synthesizeTokenList(tokenList_, buffer);
+		referenceSampleValue_ = trm_.maximumSampleValue() * CALIBRATION_HEADROOM;
+		referenceVoiceName_ = voiceName_;
+	}
+	trm_.setReferenceSampleValue(referenceSampleValue_);
+}
+
+// Synthesizes the text in inputText_. If splitFirstToneGroup is true, and the
+// text contains more than one tone group, only the first tone group is
+// synthesized, and the rest of the tokens are stored in remainingTokenList_.
+void
+Synthesizer::synthesizeSegment(std::vector<float>& buffer, bool splitFirstToneGroup)
+{
+	checkCancellation();
+	textParser_.parseText(inputText_.c_str(), textParserContext_, tokenList_);
+	if (splitFirstToneGroup &&
+			tokenList_.splitFirstToneGroup(firstToneGroup_, remainingTokenList_)) {
+		synthesizeTokenList(firstToneGroup_, buffer);
+	} else {
+		synthesizeTokenList(tokenList_, buffer);
+	}
+}
+
+// Synthesizes the token list as one utterance.
+void
+Synthesizer::synthesizeTokenList(const PhoneticTokenList& tokenList, std::vector<float>& buffer)
+{
+	trmParamStream_.str(std::string());
+	trmParamStream_.clear();
+	bool hasList = true;
+	controller_.synthesizeTokenLists(phoneticStringParser_,
+		[&]() -> const PhoneticTokenList* {
+			if (!hasList) {
+				return nullptr;
+			}
+			hasList = false;
+			return &tokenList;
+		},
+		trmParamStream_);
+
+	trm_.synthesizeToBuffer(trmParamStream_, buffer);
+}
+
+} /* namespace En */
+} /* namespace GS */
@@ -0,0 +1,170 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef EN_SYNTHESIZER_H_
+#define EN_SYNTHESIZER_H_
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CancellationToken.h"
+#include "Controller.h"
+#include "Exception.h"
+#include "Model.h"
+#include "TRMControlModelConfiguration.h"
+#include "Tube.h"
+#include "VoiceSet.h"
+#include "en/phonetic_string_parser/PhoneticStringParser.h"
+#include "en/text_parser/TextParser.h"
+#include "en/text_parser/TextSegmenter.h"
+
+
+
+namespace GS {
+namespace En {
+
+/*******************************************************************************
+ * Converts text to audio samples, without intermediate files.
+ *
+ * The model, the text parser and the voice set may be shared by many
+ * synthesizers, each one used by a different thread. The model of the text
+ * parser must be the model of the synthesizer.
+ */
+class Synthesizer {
+public:
+	// Parameters that may change in each call to synthesize.
+	struct Parameters {
+		std::string voiceName;
+		double tempo;
+		double pitchOffset;
+		int intonation; // TRMControlModel::Configuration::Intonation flags
+	};
+
+	Synthesizer(const char* configDirPath, const TRMControlModel::Model& model, const TextParser& textParser);
+	// The voices are switched without loading files.
+	Synthesizer(const char* configDirPath, const TRMControlModel::Model& model, const TextParser& textParser,
+			const TRMControlModel::VoiceSet& voiceSet);
+	~Synthesizer();
+
+	// The configuration is used by the next calls to synthesize.
+	TRMControlModel::Configuration& configuration() { return controller_.trmControlModelConfiguration(); }
+	// Restores the configuration loaded by the constructor, including the voice.
+	void resetConfiguration();
+	// The voice is loaded only if it has changed.
+	void setVoice(const std::string& voiceName);
+
+	// The parameters in the configuration loaded by the constructor.
+	const Parameters& defaultParameters() const { return defaultParameters_; }
+	// Sets the parameters in the configuration.
+	void setParameters(const Parameters& parameters);
+
+	// If enabled, synthesizeSegments synthesizes the first tone group of the
+	// text as a separate utterance, to reduce the time to the first samples.
+	void setLatencyFirst(bool enabled) { latencyFirst_ = enabled; }
+	bool latencyFirst() const { return latencyFirst_; }
+
+	// The token is checked before each sentence, each chunk, each rule
+	// application and each control period of the tube. A cancelled synthesis
+	// throws CancelledException or DeadlineExceededException. May be nullptr.
+	void setCancellationToken(const CancellationToken* token);
+
+	// The text is parsed sentence by sentence. The samples are scaled to the
+	// range [-1.0, 1.0], and are interleaved if the output has two channels.
+	void synthesize(const std::string& text, std::vector<float>& buffer);
+	// Sets the parameters in the configuration, and synthesizes the text.
+	void synthesize(const std::string& text, const Parameters& parameters, std::vector<float>& buffer);
+	// Synthesizes each sentence as a separate utterance, and calls
+	// outputSegment(buffer) after each one. All the segments are scaled by the
+	// same factor, which depends only on the voice, so the loudness does not
+	// jump between sentences; the rare peaks above the range are clipped.
+	// Returns false if outputSegment returned false, which stops the
+	// synthesis.
+	// In the latency-first mode, the first sentence is output in two parts.
+	template<typename F> bool synthesizeSegments(const std::string& text, std::vector<float>& buffer, F outputSegment);
+
+	// These values are valid after the synthesis.
+	float outputRate() const { return trm_.outputRate(); }
+	int channels() const { return trm_.channels(); }
+private:
+	Synthesizer(const Synthesizer&) = delete;
+	Synthesizer& operator=(const Synthesizer&) = delete;
+
+	void prepareSegmentScale(std::vector<float>& buffer);
+	void synthesizeSegment(std::vector<float>& buffer, bool splitFirstToneGroup);
+	void synthesizeTokenList(const PhoneticTokenList& tokenList, std::vector<float>& buffer);
+	void checkCancellation() const {
+		if (cancellationToken_ != nullptr) {
+			cancellationToken_->check();
+		}
+	}
+
+	const TextParser& textParser_;
+	TRMControlModel::Controller controller_;
+	PhoneticStringParser phoneticStringParser_;
+	TextParser::Context textParserContext_;
+	TRM::Tube trm_;
+	const TRMControlModel::Configuration defaultConfig_;
+	const Parameters defaultParameters_;
+	std::string voiceName_; // voice loaded in the controller
+	std::string referenceVoiceName_;
+	double referenceSampleValue_; // of the segments, for referenceVoiceName_
+	std::stringstream trmParamStream_;
+	std::string inputText_;
+	PhoneticTokenList tokenList_;
+	PhoneticTokenList firstToneGroup_;
+	PhoneticTokenList remainingTokenList_; // rest of a split segment
+	bool latencyFirst_;
+	const CancellationToken* cancellationToken_;
+};
+
+
+
+template<typename F>
+bool
+Synthesizer::synthesizeSegments(const std::string& text, std::vector<float>& buffer, F outputSegment)
+{
+	std::istringstream textIn(text);
+	TextSegmenter textSegmenter(textIn);
+	if (!textSegmenter.getSegment(inputText_)) {
+		THROW_EXCEPTION(InvalidValueException, "Empty text.");
+	}
+
+	remainingTokenList_.clear(); // in case the previous call was interrupted
+	prepareSegmentScale(buffer);
+	bool firstSegment = true;
+	do {
+		synthesizeSegment(buffer, firstSegment && latencyFirst_);
+		firstSegment = false;
+		if (!outputSegment(const_cast<const std::vector<float>&>(buffer))) {
+			return false;
+		}
+		if (!remainingTokenList_.empty()) {
+			synthesizeTokenList(remainingTokenList_, buffer);
+			remainingTokenList_.clear();
+			if (!outputSegment(const_cast<const std::vector<float>&>(buffer))) {
+				return false;
+			}
+		}
+	} while (textSegmenter.getSegment(inputText_));
+	return true;
+}
+
+} /* namespace En */
+} /* namespace GS */
+
+#endif /* EN_SYNTHESIZER_H_ */
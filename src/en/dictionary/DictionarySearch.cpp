@@ -20,7 +20,11 @@
 
 #include "DictionarySearch.h"
 
+#include <algorithm> /* min */
 #include <cstring>
+#include <string_view>
+#include <utility> /* pair */
+#include <vector>
 
 #include "en/dictionary/suffix_list.h"
 
@@ -28,38 +32,102 @@
 
 namespace {
 
+constexpr unsigned int SUFFIX_LIST_SIZE = sizeof(suffix_list) / sizeof(suffix_list[0]) - 1U; // without the end marker
+
 /**************************************************************************
 *
-*       function:   word_has_suffix
+*       class:      SuffixTrie
 *
-*       purpose:    Returns position of suffix if word has suffix which
-*                   matches, else returns NULL.
+*       purpose:    Trie of the reversed suffixes of suffix_list. A walk
+*                   from the end of a word finds all the suffixes of the
+*                   word.
 *
 **************************************************************************/
-const char*
-word_has_suffix(const char* word, const char* suffix)
+class SuffixTrie {
+public:
+	SuffixTrie();
+
+	// Stores in indexList the indexes in suffix_list of the suffixes of
+	// the word, in list order. Suffixes that are not shorter than the
+	// word are ignored. indexList must have SUFFIX_LIST_SIZE elements.
+	unsigned int findSuffixes(std::string_view word, unsigned int* indexList) const;
+private:
+	struct Node {
+		std::vector<std::pair<char, unsigned int>> childList; // (character, node index)
+		std::vector<unsigned int> suffixIndexList; // indexes in suffix_list of the suffixes that end here
+	};
+
+	const Node* child(const Node& node, char c) const;
+
+	std::vector<Node> nodeList_; // the root is the first node
+};
+
+SuffixTrie::SuffixTrie()
+		: nodeList_(1)
 {
-	int word_length, suffix_length;
-	const char* suffix_position;
-
-	/*  GET LENGTH OF WORD AND SUFFIX  */
-	word_length = strlen(word);
-	suffix_length = strlen(suffix);
+	for (unsigned int i = 0; i < SUFFIX_LIST_SIZE; ++i) {
+		const char* suffix = suffix_list[i].suffix;
+		unsigned int nodeIndex = 0;
+		for (const char* p = suffix + std::strlen(suffix); p != suffix; ) {
+			const char c = *--p;
+			unsigned int childIndex = 0;
+			for (const auto& item : nodeList_[nodeIndex].childList) {
+				if (item.first == c) {
+					childIndex = item.second;
+					break;
+				}
+			}
+			if (childIndex == 0) {
+				childIndex = nodeList_.size();
+				nodeList_[nodeIndex].childList.emplace_back(c, childIndex);
+				nodeList_.emplace_back();
+			}
+			nodeIndex = childIndex;
+		}
+		nodeList_[nodeIndex].suffixIndexList.push_back(i);
+	}
+}
 
-	/*  DON'T ALLOW SUFFIX TO BE LONGER THAN THE WORD, OR THE WHOLE WORD  */
-	if (suffix_length >= word_length) {
-		return nullptr;
+const SuffixTrie::Node*
+SuffixTrie::child(const Node& node, char c) const
+{
+	for (const auto& item : node.childList) {
+		if (item.first == c) {
+			return &nodeList_[item.second];
+		}
 	}
+	return nullptr;
+}
 
-	/*  FIND POSITION OF SUFFIX IN WORD  */
-	suffix_position = word + word_length - suffix_length;
+unsigned int
+SuffixTrie::findSuffixes(std::string_view word, unsigned int* indexList) const
+{
+	unsigned int n = 0;
+	const Node* node = &nodeList_[0];
 
-	/*  RETURN SUFFIX POSITION IF THE SUFFIX MATCHES, ELSE RETURN NULL  */
-	if (!strcmp(suffix_position, suffix)) {
-		return suffix_position;
-	} else {
-		return nullptr;
+	/*  DON'T ALLOW SUFFIX TO BE LONGER THAN THE WORD, OR THE WHOLE WORD  */
+	for (std::size_t length = 1; length < word.size(); ++length) {
+		node = child(*node, word[word.size() - length]);
+		if (!node) {
+			break;
+		}
+		for (unsigned int suffixIndex : node->suffixIndexList) {
+			// Insertion sort.
+			unsigned int i = n++;
+			for ( ; i > 0 && indexList[i - 1] > suffixIndex; --i) {
+				indexList[i] = indexList[i - 1];
+			}
+			indexList[i] = suffixIndex;
+		}
 	}
+	return n;
+}
+
+const SuffixTrie&
+suffixTrie()
+{
+	static const SuffixTrie trie;
+	return trie;
 }
 
 } /* namespace */
@@ -69,16 +137,8 @@ word_has_suffix(const char* word, const char* suffix)
 namespace GS {
 namespace En {
 
-void
-DictionarySearch::clearBuffers()
-{
-	buffer_.fill('\0');
-	wordTypeBuffer_.fill('\0');
-}
-
 DictionarySearch::DictionarySearch()
 {
-	clearBuffers();
 }
 
 DictionarySearch::~DictionarySearch()
@@ -92,13 +152,13 @@ DictionarySearch::load(const char* dictionaryPath)
 }
 
 const char*
-DictionarySearch::getEntry(const char* word)
+DictionarySearch::getEntry(const char* word, Buffer& buffer) const
 {
-	return augmentedSearch(word);
+	return augmentedSearch(word, buffer);
 }
 
 const char*
-DictionarySearch::version()
+DictionarySearch::version() const
 {
 	return dict_.version();
 }
@@ -117,50 +177,61 @@ DictionarySearch::version()
 *
 **************************************************************************/
 const char*
-DictionarySearch::augmentedSearch(const char* orthography)
+DictionarySearch::augmentedSearch(const char* orthography, Buffer& buffer) const
 {
 	const char* word;
-	const char* pt;
-	char* word_type_pos;
-	const suffix_list_t* list_ptr;
-
-	clearBuffers();
 
 	/*  RETURN IMMEDIATELY IF WORD FOUND IN DICTIONARY  */
-	if ( (word = dict_.getEntry(orthography)) ) {
+	const std::string_view orthographyView(orthography);
+	if ( (word = dict_.getEntry(orthographyView)) ) {
 		return word;
 	}
 
-	/*  LOOP THROUGH SUFFIX LIST  */
-	for (list_ptr = suffix_list; list_ptr->suffix; list_ptr++) {
-		if ( (pt = word_has_suffix(orthography, list_ptr->suffix)) ) {
-			/*  TACK ON REPLACEMENT ENDING  */
-			strcpy(&buffer_[0], orthography);
-			*(&buffer_[0] + (pt - orthography)) = '\0';
-			strcat(&buffer_[0], list_ptr->replacement);
+	/*  FIND ALL THE SUFFIXES OF THE WORD, IN LIST ORDER  */
+	std::array<unsigned int, SUFFIX_LIST_SIZE> suffixIndexList;
+	const unsigned int numSuffixes = suffixTrie().findSuffixes(orthographyView, suffixIndexList.data());
 
-			/*  IF WORD FOUND WITH REPLACEMENT ENDING  */
-			if ( (word = dict_.getEntry(&buffer_[0])) ) {
-				/*  PUT THE FOUND PRONUNCIATION IN THE BUFFER  */
-				strcpy(&buffer_[0], word);
+	for (unsigned int i = 0; i < numSuffixes; ++i) {
+		const suffix_list_t& entry = suffix_list[suffixIndexList[i]];
 
-				/*  FIND THE WORD-TYPE INFO  */
-				for (word_type_pos = &buffer_[0]; *word_type_pos && (*word_type_pos != '%'); word_type_pos++)
-					;
+		/*  TACK ON REPLACEMENT ENDING  */
+		const std::size_t stemLength = orthographyView.size() - std::strlen(entry.suffix);
+		const std::size_t replacementLength = std::strlen(entry.replacement);
+		if (stemLength + replacementLength >= MAXLEN) {
+			continue;
+		}
+		std::memcpy(&buffer[0], orthography, stemLength);
+		std::memcpy(&buffer[stemLength], entry.replacement, replacementLength);
+
+		/*  IF WORD FOUND WITH REPLACEMENT ENDING  */
+		if ( (word = dict_.getEntry(std::string_view(&buffer[0], stemLength + replacementLength))) ) {
+			/*  FIND THE WORD-TYPE INFO  */
+			const char* wordTypePos = std::strchr(word, '%');
+			if (!wordTypePos) {
+				wordTypePos = word + std::strlen(word);
+			}
+			const std::size_t pronunciationLength = wordTypePos - word;
+			const std::size_t suffixPronunciationLength = std::strlen(entry.pronunciation);
+			const std::size_t wordTypeLength = std::min<std::size_t>(std::strlen(wordTypePos), WORD_TYPE_BUF_SIZE);
+			if (pronunciationLength + suffixPronunciationLength + wordTypeLength >= MAXLEN) {
+				continue;
+			}
 
-				/*  SAVE IT INTO WORD TYPE BUFFER  */
-				strcpy(&wordTypeBuffer_[0], word_type_pos);
+			/*  PUT THE FOUND PRONUNCIATION IN THE BUFFER  */
+			char* p = &buffer[0];
+			std::memcpy(p, word, pronunciationLength);
+			p += pronunciationLength;
 
-				/*  APPEND SUFFIX PRONUNCIATION TO WORD  */
-				*word_type_pos = '\0';
-				strcat(&buffer_[0], list_ptr->pronunciation);
+			/*  APPEND SUFFIX PRONUNCIATION TO WORD  */
+			std::memcpy(p, entry.pronunciation, suffixPronunciationLength);
+			p += suffixPronunciationLength;
 
-				/*  AND PUT BACK THE WORD TYPE  */
-				strncat(&buffer_[0], &wordTypeBuffer_[0], WORD_TYPE_BUF_SIZE);
+			/*  AND PUT BACK THE WORD TYPE  */
+			std::memcpy(p, wordTypePos, wordTypeLength);
+			p[wordTypeLength] = '\0';
 
-				/*  RETURN WORD WITH SUFFIX AND ORIGINAL WORD TYPE  */
-				return &buffer_[0];
-			}
+			/*  RETURN WORD WITH SUFFIX AND ORIGINAL WORD TYPE  */
+			return &buffer[0];
 		}
 	}
 
@@ -32,31 +32,35 @@ namespace En {
 
 class DictionarySearch {
 public:
+	enum {
+		WORD_TYPE_BUF_SIZE = 32,
+		MAXLEN = 1024
+	};
+	// Caller-owned storage for the entries built from a word with a suffix.
+	typedef std::array<char, MAXLEN> Buffer;
+
 	DictionarySearch();
 	~DictionarySearch();
 
 	void load(const char* dictionaryPath);
 
-	// The returned string is invalidated if the dictionary is changed.
-	const char* getEntry(const char* word);
+	// The returned string points to the dictionary or to buffer. It is
+	// invalidated if the dictionary or the buffer is changed.
+	// May be called concurrently, with different buffers.
+	const char* getEntry(const char* word, Buffer& buffer) const;
 
 	// The returned string is invalidated if the dictionary is changed.
-	const char* version();
-private:
-	enum {
-		WORD_TYPE_BUF_SIZE = 32,
-		MAXLEN = 1024
-	};
+	const char* version() const;
 
+	// Number of entries in the dictionary.
+	unsigned int size() const { return dict_.size(); }
+private:
 	DictionarySearch(const DictionarySearch&) = delete;
 	DictionarySearch& operator=(const DictionarySearch&) = delete;
 
-	void clearBuffers();
-	const char* augmentedSearch(const char* orthography);
+	const char* augmentedSearch(const char* orthography, Buffer& buffer) const;
 
 	Dictionary dict_;
-	std::array<char, MAXLEN> buffer_;
-	std::array<char, WORD_TYPE_BUF_SIZE> wordTypeBuffer_;
 };
 
 } /* namespace En */
@@ -25,10 +25,9 @@
 *
 ******************************************************************************/
 
-#include "en/letter_to_sound/letter_to_sound.h"
+#include "en/letter_to_sound/LetterToSound.h"
 
 #include <string.h>
-#include <stdio.h>
 
 #include "en/letter_to_sound/word_to_patphone.h"
 #include "en/letter_to_sound/isp_trans.h"
@@ -41,8 +40,7 @@
 /*  LOCAL DEFINES  ***********************************************************/
 #define WORD_TYPE_UNKNOWN          "j"
 #define WORD_TYPE_DELIMITER        '%'
-#define MAX_WORD_LENGTH            1024
-#define MAX_PRONUNCIATION_LENGTH   8192
+#define WORD_BUFFER_MARGIN         64  /*  THE RULES MAY INSERT MARKS IN THE WORD  */
 #define MAX(a,b)                   (a > b ? a : b)
 #define WORDEND(word,string)       (!strcmp(MAX(word+strlen(word)-strlen(string),word),string))
 
@@ -92,50 +90,59 @@ word_type(const char* word)
 namespace GS {
 namespace En {
 
+LetterToSound::LetterToSound()
+{
+}
+
+LetterToSound::~LetterToSound()
+{
+}
+
 /******************************************************************************
 *
-*	function:	letter_to_sound
+*	function:	getPronunciation
 *
 *	purpose:	Returns pronunciation of word based on letter-to-sound
-*                       rules.  Returns NULL if any error (rare).
+*                       rules.  Returns an empty pronunciation if any error
+*                       (rare).
 *
 ******************************************************************************/
 void
-letter_to_sound(const char* word, std::vector<char>& pronunciation)
+LetterToSound::getPronunciation(const char* word, std::vector<char>& pronunciation)
 {
-	char buffer[MAX_WORD_LENGTH + 3];
+	const size_t word_length = strlen(word);
 	int number_of_syllables = 0;
 
-	pronunciation.assign(MAX_PRONUNCIATION_LENGTH + 1, '\0');
-
 	/*  FORMAT WORD  */
-	sprintf(buffer, "#%s#", word);
+	wordBuffer_.assign(2 * word_length + WORD_BUFFER_MARGIN, '\0');
+	wordBuffer_[0] = '#';
+	memcpy(&wordBuffer_[1], word, word_length);
+	wordBuffer_[word_length + 1] = '#';
 
 	/*  CONVERT WORD TO PRONUNCIATION  */
-	if (!word_to_patphone(buffer)) {
-		isp_trans(buffer, &pronunciation[0]);
+	const int result = word_to_patphone(&wordBuffer_[0], pronunciation);
+	if (!result) {
+		isp_trans(&wordBuffer_[0], ruleStack_, pronunciation);
 		/*  ATTEMPT TO MARK SYLL/STRESS  */
-		number_of_syllables = syllabify(&pronunciation[0]);
+		number_of_syllables = syllabify(&pronunciation[0], cvSignature_);
+		pronunciation.push_back('\0'); /*  ROOM FOR THE STRESS MARK  */
 		if (apply_stress(&pronunciation[0], word)) { // error
 			pronunciation.clear();
 			return;
 		}
-	} else {
-		strcpy(&pronunciation[0], buffer);
+	} else if (result == 1) {
+		/*  FOUND IN THE WORD LIST  */
+		pronunciation.assign(&wordBuffer_[0], &wordBuffer_[0] + strlen(&wordBuffer_[0]) + 1);
 	}
+	/*  ELSE THE WORD WAS SPELLED INTO pronunciation  */
 
 	/*  APPEND WORD_TYPE_DELIMITER  */
-	pronunciation[strlen(&pronunciation[0]) - 1] = WORD_TYPE_DELIMITER;
+	pronunciation.resize(strlen(&pronunciation[0]));
+	pronunciation.back() = WORD_TYPE_DELIMITER;
 
 	/*  GUESS TYPE OF WORD  */
-	if (number_of_syllables != 1) {
-		strcat(&pronunciation[0], word_type(word));
-	} else {
-		strcat(&pronunciation[0], WORD_TYPE_UNKNOWN);
-	}
-
-	/*  RETURN RESULTING PRONUNCIATION  */
-	return;
+	const char* type = (number_of_syllables != 1) ? word_type(word) : WORD_TYPE_UNKNOWN;
+	pronunciation.insert(pronunciation.end(), type, type + strlen(type) + 1);
 }
 
 } /* namespace En */
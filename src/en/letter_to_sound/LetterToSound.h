@@ -28,7 +28,24 @@
 namespace GS {
 namespace En {
 
-void letter_to_sound(const char* word, std::vector<char>& pronunciation);
+class LetterToSound {
+public:
+	LetterToSound();
+	~LetterToSound();
+
+	// Stores in pronunciation the null-terminated pronunciation of the word,
+	// based on letter-to-sound rules. The pronunciation is empty if an error
+	// occurred (rare).
+	void getPronunciation(const char* word, std::vector<char>& pronunciation);
+private:
+	LetterToSound(const LetterToSound&) = delete;
+	LetterToSound& operator=(const LetterToSound&) = delete;
+
+	// Work buffers, reused between calls.
+	std::vector<char> wordBuffer_;
+	std::vector<char> ruleStack_;
+	std::vector<char> cvSignature_;
+};
 
 } /* namespace En */
 } /* namespace GS */
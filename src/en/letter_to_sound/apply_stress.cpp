@@ -158,6 +158,9 @@ apply_stress(char* buffer, const char* orthography)
 	for (index = 0, spt = buffer; *spt; spt++) {
 		if (last_was_break) {
 			last_was_break = 0;
+			if (index == MAX_SYLLS) {
+				return 1;
+			}
 			syll_array[index++] = spt;
 		}
 		if (*spt == '.') {
@@ -165,10 +168,6 @@ apply_stress(char* buffer, const char* orthography)
 		}
 	}
 
-	if (index > MAX_SYLLS) {
-		return 1;
-	}
-
 	/*  RETURNS SYLLABLE NO. (FROM THE END) THAT IS THE START OF A STRESS-AFFECTING
 	SUFFIX, 0 IF NONE; AND TYPE  */
 	t = stress_suffix(orthography, &type);
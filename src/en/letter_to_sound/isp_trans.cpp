@@ -859,68 +859,77 @@ namespace En {
 *
 *	function:	isp_trans
 *
-*	purpose:	
-*                       
-*			
-*       arguments:      string, result
-*                       
+*	purpose:	Applies the rewrite rules to string, writing the
+*                       pronunciation to result (null-terminated).  At each
+*                       step the longest rule that matches the start of the
+*                       remaining input is applied:  the part of its
+*                       replacement before the 'X' is output, and the part
+*                       after the 'X' is pushed back to the input.
+*
+*                       The remaining input is kept reversed in stack, so
+*                       a step only touches the matched and the pushed-back
+*                       characters.
+*
+*       arguments:      string, stack, result
+*
 *	internal
 *	functions:	(INDEX)
 *
 *	library
-*	functions:	strcpy
+*	functions:	none
 *
 ******************************************************************************/
 void
-isp_trans(char *string, char *result)
+isp_trans(const char* string, std::vector<char>& stack, std::vector<char>& result)
 {
-    int                 i = 0, term = 0, tmp;
-    const char* k;
-    char *rc = NULL, tstr[1024], mstr[1024];
-
-
-    strcpy(tstr, string);
-    while (1) {
-	if (*string && (trie[INDEX(*string) + i].val == *string)) {
-	    tmp = trie[INDEX(*string) + i].term_state;
-	    if (tmp) {
-		term = tmp;
-		rc = string + 1;
-	    }
-	    i = trie[INDEX(*string++) + i].next_org;
-	    if (i)
-		continue;
+	stack.clear();
+	for (const char* p = string + strlen(string); p != string; ) {
+		stack.push_back(*--p);
 	}
+	result.clear();
 
-	if (!term) {
-	    *result = 0;
-	    return;
-	}
-
-	strcpy(mstr, rc);
-	rc = mstr;
-	k = m_string[term - 1];
-
-	while (*k && (*k != 'X'))
-	    *result++ = *k++;
+	while (true) {
+		int i = 0, term = 0;
+		std::size_t matchLength = 0; // length of the longest match
 
-	string = tstr;
+		/*  FIND THE LONGEST MATCH  */
+		for (std::size_t n = 1; n <= stack.size(); ++n) {
+			const char c = stack[stack.size() - n];
+			const int index = INDEX(c) + i;
+			if (index < 0 || index >= TRIE_NODES || trie[index].val != c) {
+				break;
+			}
+			if (trie[index].term_state) {
+				term = trie[index].term_state;
+				matchLength = n;
+			}
+			i = trie[index].next_org;
+			if (!i) {
+				break;
+			}
+		}
 
-	if (*k)
-	    k++;
-	else
-	    *result++ = '_';
+		if (!term) {
+			result.push_back('\0');
+			return;
+		}
+		stack.resize(stack.size() - matchLength);
 
-	while (*k)
-	    *string++ = *k++;
+		/*  OUTPUT THE REPLACEMENT UP TO THE 'X'  */
+		const char* k = m_string[term - 1];
+		while (*k && (*k != 'X')) {
+			result.push_back(*k++);
+		}
 
-	while (*rc)
-	    *string++ = *rc++;
-
-	*string = 0;
-	string = tstr;
-	term = i = 0;
-    }
+		/*  PUSH BACK THE REST  */
+		if (*k) {
+			for (const char* p = k + strlen(k); p != k + 1; ) {
+				stack.push_back(*--p);
+			}
+		} else {
+			result.push_back('_');
+		}
+	}
 }
 
 } /* namespace En */
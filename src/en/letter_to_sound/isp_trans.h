@@ -21,12 +21,15 @@
 #ifndef EN_ISP_TRANS_H_
 #define EN_ISP_TRANS_H_
 
+#include <vector>
+
 
 
 namespace GS {
 namespace En {
 
-void isp_trans(char *string, char *result);
+// stack is a work buffer.
+void isp_trans(const char* string, std::vector<char>& stack, std::vector<char>& result);
 
 } /* namespace En */
 } /* namespace GS */
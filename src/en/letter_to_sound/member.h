@@ -26,7 +26,33 @@
 namespace GS {
 namespace En {
 
-int member(char element, const char* set);
+/******************************************************************************
+*
+*	function:	member
+*
+*	purpose:	Return true if element in set, false otherwise.
+*			
+*       arguments:      element, set
+*                       
+*	internal
+*	functions:	none
+*
+*	library
+*	functions:	none
+*
+******************************************************************************/
+inline
+int
+member(char element, const char* set)
+{
+	while (*set) {
+		if (element == *set++) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
 
 } /* namespace En */
 } /* namespace GS */
@@ -21,8 +21,8 @@
 #include "en/letter_to_sound/syllabify.h"
 
 #include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
 #include "en/letter_to_sound/clusters.h"
@@ -30,7 +30,6 @@
 
 
 /*  LOCAL DEFINES  ***********************************************************/
-#define MAX_LEN    1024
 #define isvowel(c) ((c)=='a' || (c)=='e' || (c)=='i' || (c)=='o' || (c)=='u' )
 #define LEFT       begin_syllable
 #define RIGHT      end_syllable
@@ -42,12 +41,25 @@ namespace {
 /*  DATA TYPES  **************************************************************/
 typedef char phone_type;
 
-int syllable_break(const char* cluster);
-void create_cv_signature(char *ptr, phone_type *arr);
+/*  SET OF THE CLUSTERS IN A NULL-TERMINATED LIST  */
+class ClusterSet {
+public:
+	explicit ClusterSet(const char** list) {
+		for ( ; *list; list++) {
+			set_.insert(*list);
+		}
+	}
+	bool contains(std::string_view cluster) const { return set_.count(cluster) > 0; }
+private:
+	std::unordered_set<std::string_view> set_;
+};
+
+int syllable_break(std::string_view cluster);
+void create_cv_signature(char *ptr, std::vector<phone_type>& arr);
 char *add_1_phone(char *t);
-void extract_consonant_cluster(char* ptr, phone_type* type, std::vector<char>& cluster);
+std::string_view extract_consonant_cluster(char* ptr, phone_type* type);
 int next_consonant_cluster(phone_type *pt);
-int check_cluster(const char* p, const char** match_array);
+int check_cluster(std::string_view p, const ClusterSet& match_set);
 
 
 
@@ -64,32 +76,27 @@ int check_cluster(const char* p, const char** match_array);
 *	functions:	check_cluster
 *
 *	library
-*	functions:	strlen, strcpy
+*	functions:	none
 *
 ******************************************************************************/
 int
-syllable_break(const char* cluster)
+syllable_break(std::string_view cluster)
 {
-	const char* left_cluster;
-	const char* right_cluster;
-	char temp[MAX_LEN];
+	static const ClusterSet left_set(LEFT);
+	static const ClusterSet right_set(RIGHT);
+	std::string_view left_cluster, right_cluster;
 	int offset, length;
 
 	/*  GET LENGTH OF CLUSTER  */
-	length = strlen(cluster);
+	length = cluster.size();
 
 	/*  INITIALLY WE SHALL RETURN THE FIRST 'POSSIBLE' MATCH  */
 	for (offset = -1; (offset <= length); offset++) {
 		if (offset == -1 || offset == length || cluster[offset] == '_' || cluster[offset] == '.') {
-			strcpy(temp, cluster);
-			if (offset >= 0) {
-				temp[offset] = 0;
-			}
-			left_cluster = (offset < 0 ? temp : offset == length ? temp + length : temp + (offset + 1));
-			/*  POINTS TO BEGINNING OR NULL  */
-			right_cluster = (offset >= 0 ? temp : temp + length);
-			/*  NOW THEY POINT TO EITHER A LEFT/RIGHT HANDED CLUSTER OR A NULL STRING  */
-			if (check_cluster(left_cluster, LEFT) && check_cluster(right_cluster, RIGHT)) {
+			/*  EITHER A LEFT/RIGHT HANDED CLUSTER OR AN EMPTY STRING  */
+			left_cluster = (offset < 0 ? cluster : offset == length ? std::string_view() : cluster.substr(offset + 1));
+			right_cluster = (offset >= 0 ? cluster.substr(0, offset) : std::string_view());
+			if (check_cluster(left_cluster, left_set) && check_cluster(right_cluster, right_set)) {
 				/*  IF THIS IS A POSSIBLE BREAK */
 				/*  TEMPORARY:  WILL STORE LIST OF POSSIBLES AND PICK A 'BEST' ONE  */
 				return offset;
@@ -118,16 +125,14 @@ syllable_break(const char* cluster)
 *
 ******************************************************************************/
 void
-create_cv_signature(char *ptr, phone_type *arr)
+create_cv_signature(char *ptr, std::vector<phone_type>& arr)
 {
-    phone_type         *arr_next;
-
-    arr_next = arr;
+    arr.clear();
     while (*ptr) {
-	*arr_next++ = isvowel(*ptr) ? 'v' : 'c';
+	arr.push_back(isvowel(*ptr) ? 'v' : 'c');
 	ptr = add_1_phone(ptr);
     }
-    *arr_next = 0;
+    arr.push_back(0);
 }
 
 /******************************************************************************
@@ -162,9 +167,12 @@ add_1_phone(char *t)
 *
 *	function:	extract_consonant_cluster
 *
+*	purpose:	Returns the consonant cluster that starts at ptr,
+*                       without the last separator.
+*
 ******************************************************************************/
-void
-extract_consonant_cluster(char* ptr, phone_type* type, std::vector<char>& cluster)
+std::string_view
+extract_consonant_cluster(char* ptr, phone_type* type)
 {
 	char* newptr = ptr;
 
@@ -173,17 +181,15 @@ extract_consonant_cluster(char* ptr, phone_type* type, std::vector<char>& cluste
 		newptr = add_1_phone(newptr);
 	}
 
-	cluster.assign(strlen(ptr) + 1, '\0');
-	strcpy(&cluster[0], ptr);
 	int offset = newptr - ptr - 1;
 
 	if (offset >= 0) {
-		cluster[offset] = '\0';
+		return std::string_view(ptr, offset);
 	} else {
 		fprintf(stderr, "offset error\n");  // what's this??
+		return std::string_view(ptr);
 	}
 }
-
 /******************************************************************************
 *
 *	function:	next_consonant_cluster
@@ -233,31 +239,23 @@ next_consonant_cluster(phone_type *pt)
 *	purpose:	Returns 1 if it is a possible match, 0 otherwise.
 *
 *
-*       arguments:      p, match_array
+*       arguments:      p, match_set
 *
 *	internal
 *	functions:	none
 *
 *	library
-*	functions:	strcmp
+*	functions:	none
 *
 ******************************************************************************/
 int
-check_cluster(const char *p, const char** match_array)
+check_cluster(std::string_view p, const ClusterSet& match_set)
 {
-	const char** i;
-
 	/*  EMPTY COUNTS AS A MATCH  */
-	if (!*p)
+	if (p.empty())
 		return 1;
 
-	i = match_array;
-	while (*i) {
-		if (!strcmp(*i, p))
-			return 1;
-		i++;
-	}
-	return 0;
+	return match_set.contains(p);
 }
 
 } /* namespace */
@@ -277,7 +275,7 @@ namespace En {
 *                       (again taking the longest possible.)  Changes '_' to
 *                       '.' where it occurs between syllable end and start.
 *
-*       arguments:      word
+*       arguments:      word, cv_signature (work buffer)
 *                       
 *	internal
 *	functions:	create_cv_signature, next_consonant_cluster,
@@ -288,17 +286,16 @@ namespace En {
 *
 ******************************************************************************/
 int
-syllabify(char* word)
+syllabify(char* word, std::vector<char>& cv_signature)
 {
 	int        i, n, temp, number_of_syllables = 0;
-	phone_type cv_signature[MAX_LEN], *current_type;
+	phone_type *current_type;
 	char *ptr;
-	std::vector<char> cluster;
 
 	/*  INITIALIZE THIS ARRAY TO 'c' (CONSONANT), 'v' (VOWEL), 0 (END)  */
 	ptr = word;
 	create_cv_signature(ptr, cv_signature);
-	current_type = cv_signature;
+	current_type = &cv_signature[0];
 
 	/*  WHILE THERE IS ANOTHER CONSONANT CLUSTER (NOT THE LAST)  */
 	while ( (temp = next_consonant_cluster(current_type)) ) {
@@ -312,11 +309,8 @@ syllabify(char* word)
 			ptr = add_1_phone(ptr);
 		}
 
-		/*  EXTRACT THE CLUSTER INTO A SEPARATE STRING  */
-		extract_consonant_cluster(ptr, current_type, cluster);
-
 		/*  DETERMINE WHERE THE PERIOD GOES (OFFSET FROM PTR, WHICH COULD BE -1)  */
-		n = syllable_break(&cluster[0]);
+		n = syllable_break(extract_consonant_cluster(ptr, current_type));
 
 		/*  MARK THE SYLLABLE IF POSSIBLE  */
 		if (n != -2) {
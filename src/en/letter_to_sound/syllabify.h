@@ -21,12 +21,15 @@
 #ifndef EN_SYLLABIFY_H_
 #define EN_SYLLABIFY_H_
 
+#include <vector>
+
 
 
 namespace GS {
 namespace En {
 
-int syllabify(char* word);
+// cv_signature is a work buffer.
+int syllabify(char* word, std::vector<char>& cv_signature);
 
 } /* namespace En */
 } /* namespace GS */
@@ -20,7 +20,6 @@
 
 #include "en/letter_to_sound/word_to_patphone.h"
 
-#include <array>
 #include <string.h>
 
 #include "en/letter_to_sound/vowel_before.h"
@@ -35,14 +34,9 @@
 
 
 
-/*  LOCAL DEFINES  ***********************************************************/
-#define SPELL_STRING_LEN   8192
-
-
-
 namespace {
 
-int spell_it(char* word);
+int spell_it(const char* word, std::vector<char>& spelling);
 int all_caps(char* in);
 
 
@@ -67,27 +61,24 @@ const char* letters[] = {
 *
 *	function:	spell_it
 *
-*	purpose:
-*
+*	purpose:	Stores the spelling of the word in spelling
+*                       (null-terminated).
 *
-*       arguments:      word
+*       arguments:      word, spelling
 *
 *	internal
 *	functions:	none
 *
 *	library
-*	functions:	strcpy
+*	functions:	strlen
 *
 ******************************************************************************/
 int
-spell_it(char* word)
+spell_it(const char* word, std::vector<char>& spelling)
 {
-	std::array<char, SPELL_STRING_LEN> spell_string;
-	spell_string.fill(0);
-
-	char* s = &spell_string[0];
 	const char* t;
-	char* hold = word;
+
+	spelling.clear();
 
 	/*  EAT THE '#'  */
 	word++;
@@ -103,14 +94,10 @@ spell_it(char* word)
 			t = letters[*word - ' '];
 		}
 		word++;
-		while (*t) {
-			*s++ = *t++;
-		}
+		spelling.insert(spelling.end(), t, t + strlen(t));
 	} while (*word != '#');
 
-	*s = 0;
-
-	strcpy(hold, &spell_string[0]);
+	spelling.push_back('\0');
 	return 2;
 }
 
@@ -166,7 +153,7 @@ namespace En {
 *	purpose:	
 *                       
 *			
-*       arguments:      word
+*       arguments:      word, spelling
 *                       
 *	internal
 *	functions:	all_caps, spell_it, vowel_before, check_word_list,
@@ -178,7 +165,7 @@ namespace En {
 *
 ******************************************************************************/
 int
-word_to_patphone(char *word)
+word_to_patphone(char *word, std::vector<char>& spelling)
 {
     char *end_of_word;
     char replace_s = 0;
@@ -190,15 +177,15 @@ word_to_patphone(char *word)
 
     /*  IF NO LITTLE LETTERS SPELL THE WORD  */
     if (all_caps(word))
-	return(spell_it(word));
+	return(spell_it(word, spelling));
 
     /*  IF SINGLE LETTER, SPELL IT  */
     if (end_of_word == (word + 2))
-	return(spell_it(word));
+	return(spell_it(word, spelling));
 
     /*  IF NO VOWELS SPELL THE WORD  */
     if (!vowel_before(word, end_of_word))
-	return(spell_it(word));
+	return(spell_it(word, spelling));
 
     /*  SEE IF IT IS IN THE EXCEPTION LIST  */
     if (check_word_list(word, &end_of_word)) {
@@ -21,12 +21,15 @@
 #ifndef EN_WORD_TO_PATPHONE_H_
 #define EN_WORD_TO_PATPHONE_H_
 
+#include <vector>
+
 
 
 namespace GS {
 namespace En {
 
-int word_to_patphone(char *word);
+// If the word is spelled (return value 2), the spelling is stored in spelling.
+int word_to_patphone(char *word, std::vector<char>& spelling);
 
 } /* namespace En */
 } /* namespace GS */
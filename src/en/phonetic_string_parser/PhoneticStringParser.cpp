@@ -39,6 +39,7 @@ namespace En {
 PhoneticStringParser::PhoneticStringParser(const char* configDirPath, TRMControlModel::Controller& controller)
 		: model_(controller.model())
 		, eventList_(controller.eventList())
+		, tokenizer_(model_)
 {
 	category_[0] = getCategory("stopped");
 	category_[1] = getCategory("affricate");
@@ -68,6 +69,15 @@ PhoneticStringParser::PhoneticStringParser(const char* configDirPath, TRMControl
 	returnPhone_[5] = getPosture("qs");
 	returnPhone_[6] = getPosture("qz");
 
+	silencePosture_       = getPosture("^");
+	endPosture_           = getPosture("#");
+	lPosture_[0]          = getPosture("l");
+	lPosture_[1]          = getPosture("l'");
+	llPosture_[0]         = getPosture("ll");
+	llPosture_[1]         = getPosture("ll'");
+	transitionPosture_[0] = getPosture("gs");
+	transitionPosture_[1] = getPosture("r");
+
 	initVowelTransitions(configDirPath);
 }
 
@@ -218,9 +228,9 @@ PhoneticStringParser::rewrite(const TRMControlModel::Posture& nextPosture, int w
 				break;
 			case 6:
 				if (strchr(nextPosture.name().c_str(), '\'')) {
-					tempPosture = model_.postureList().find("l'");
+					tempPosture = lPosture_[1];
 				} else {
-					tempPosture = model_.postureList().find("l");
+					tempPosture = lPosture_[0];
 				}
 
 				eventList_.replaceCurrentPostureWith(*tempPosture);
@@ -251,9 +261,9 @@ PhoneticStringParser::rewrite(const TRMControlModel::Posture& nextPosture, int w
 				}
 
 				if (strchr(nextPosture.name().c_str(), '\'')) {
-					tempPosture = model_.postureList().find("ll'");
+					tempPosture = llPosture_[1];
 				} else {
-					tempPosture = model_.postureList().find("ll");
+					tempPosture = llPosture_[0];
 				}
 
 				//printf("Replacing with ll\n");
@@ -269,188 +279,88 @@ PhoneticStringParser::rewrite(const TRMControlModel::Posture& nextPosture, int w
 	return returnValue;
 }
 
-int
-PhoneticStringParser::parseString(const char* string)
+/*******************************************************************************
+ * The first chunk also contains the tokens before the first /c.
+ */
+void
+PhoneticStringParser::parseChunk(const PhoneticTokenList& tokenList, int chunk)
 {
+	typedef PhoneticTokenList::Token Token;
 	const TRMControlModel::Posture* tempPosture;
-	const TRMControlModel::Posture* tempPosture1;
-	int length;
-	int index = 0, bufferIndex = 0;
-	int chunk = 0;
-	char buffer[128];
-	int lastFoot = 0, markedFoot = 0, wordMarker = 0;
-	double footTempo = 1.0;
+	int lastFoot = 0, wordMarker = 0;
 	double ruleTempo = 1.0;
 	double postureTempo = 1.0;
 	RewriterData rewriterData;
 
-	length = strlen(string);
-
-	tempPosture = model_.postureList().find("^");
-	eventList_.newPostureWithObject(*tempPosture);
-
-	while (index < length) {
-		while ((isspace(string[index]) || (string[index] == '_')) && (index<length)) index++;
-		if (index > length) break;
+	const std::size_t begin = tokenList.chunkBegin(chunk);
+	const std::size_t end = tokenList.chunkEnd(chunk);
 
-		memset(buffer, 0, 128);
-		bufferIndex = 0;
+	eventList_.newPostureWithObject(*silencePosture_);
 
-		switch (string[index]) {
-		case '/': /* Handle "/" escape sequences */
-			index++;
-			switch(string[index]) {
-			case '0': /* Tone group 0. Statement */
-				index++;
-				eventList_.setCurrentToneGroupType(TONE_GROUP_TYPE_STATEMENT);
-				break;
-			case '1': /* Tone group 1. Exclamation */
-				index++;
-				eventList_.setCurrentToneGroupType(TONE_GROUP_TYPE_EXCLAMATION);
-				break;
-			case '2': /* Tone group 2. Question */
-				index++;
-				eventList_.setCurrentToneGroupType(TONE_GROUP_TYPE_QUESTION);
-				break;
-			case '3': /* Tone group 3. Continuation */
-				index++;
-				eventList_.setCurrentToneGroupType(TONE_GROUP_TYPE_CONTINUATION);
-				break;
-			case '4': /* Tone group 4. Semi-colon */
-				index++;
-				eventList_.setCurrentToneGroupType(TONE_GROUP_TYPE_SEMICOLON);
-				break;
-			case ' ':
-			case '_': /* New foot */
-				eventList_.newFoot();
-				if (lastFoot) {
-					eventList_.setCurrentFootLast();
-				}
-				footTempo = 1.0;
-				lastFoot = 0;
-				markedFoot = 0;
-				index++;
-				break;
-			case '*': /* New Marked foot */
-				eventList_.newFoot();
-				eventList_.setCurrentFootMarked();
-				if (lastFoot) {
-					eventList_.setCurrentFootLast();
-				}
-				footTempo = 1.0;
-				lastFoot = 0;
-				markedFoot = 1;
-				index++;
-				break;
-			case '/': /* New Tone Group */
-				index++;
-				eventList_.newToneGroup();
-				break;
-			case 'c': /* New Chunk */
-				if (chunk) {
-					tempPosture = model_.postureList().find("#");
-					eventList_.newPostureWithObject(*tempPosture);
-					tempPosture = model_.postureList().find("^");
-					eventList_.newPostureWithObject(*tempPosture);
-					index--;
-					return index;
-				} else {
-					chunk++;
-					index++;
-				}
-				break;
-			case 'l': /* Last Foot in tone group marker */
-				index++;
-				lastFoot = 1;
-				break;
-			case 'w': /* word marker */
-				index++;
-				wordMarker = 1;
-				break;
-			case 'f': /* Foot tempo indicator */
-				index++;
-				while ((isspace(string[index]) || (string[index] == '_')) && (index < length)) {
-					index++;
-				}
-				if (index > length) {
-					break;
-				}
-				while (isdigit(string[index]) || (string[index] == '.')) {
-					buffer[bufferIndex++] = string[index++];
-				}
-				footTempo = atof(buffer);
-				eventList_.setCurrentFootTempo(footTempo);
-				break;
-			case 'r': /* Foot tempo indicator */
-				index++;
-				while ((isspace(string[index]) || (string[index] == '_')) && (index < length)) {
-					index++;
-				}
-				if (index > length) {
-					break;
-				}
-				while (isdigit(string[index]) || (string[index] == '.')) {
-					buffer[bufferIndex++] = string[index++];
-				}
-				ruleTempo = atof(buffer);
-				break;
-			default:
-				index++;
-				//printf("Unknown \"/\" escape sequence :%c\n", string[index]);
-				break;
+	for (std::size_t i = begin; i < end; ++i) {
+		const Token& token = tokenList[i];
+		switch (token.type) {
+		case Token::TONE_GROUP_TYPE:
+			eventList_.setCurrentToneGroupType(token.toneGroupType);
+			break;
+		case Token::NEW_FOOT:
+			eventList_.newFoot();
+			if (lastFoot) {
+				eventList_.setCurrentFootLast();
+			}
+			lastFoot = 0;
+			break;
+		case Token::NEW_MARKED_FOOT:
+			eventList_.newFoot();
+			eventList_.setCurrentFootMarked();
+			if (lastFoot) {
+				eventList_.setCurrentFootLast();
 			}
+			lastFoot = 0;
+			break;
+		case Token::NEW_TONE_GROUP:
+			eventList_.newToneGroup();
+			break;
+		case Token::NEW_CHUNK:
 			break;
-		case '.': /* Syllable Marker */
+		case Token::LAST_FOOT:
+			lastFoot = 1;
+			break;
+		case Token::WORD_MARKER:
+			wordMarker = 1;
+			break;
+		case Token::FOOT_TEMPO:
+			eventList_.setCurrentFootTempo(token.tempo);
+			break;
+		case Token::RULE_TEMPO:
+			ruleTempo = token.tempo;
+			break;
+		case Token::SYLLABLE:
 			eventList_.setCurrentPostureSyllable();
-			index++;
 			break;
-
-		case '0':
-		case '1':
-		case '2':
-		case '3':
-		case '4':
-		case '5':
-		case '6':
-		case '7':
-		case '8':
-		case '9':
-			while (isdigit(string[index]) || (string[index] == '.')) {
-				buffer[bufferIndex++] = string[index++];
-			}
-			postureTempo = atof(buffer);
+		case Token::POSTURE_TEMPO:
+			postureTempo = token.tempo;
 			break;
-
-		default:
-			if (isalpha(string[index]) || (string[index] == '^') || (string[index] == '\'')
-					|| (string[index] == '#') ) {
-				while ( (isalpha(string[index])||(string[index] == '^')||(string[index] == '\'')
-						||(string[index] == '#')) && (index < length)) {
-					buffer[bufferIndex++] = string[index++];
-				}
-				if (markedFoot) {
-					strcat(buffer,"'");
-				}
-				tempPosture = model_.postureList().find(buffer);
+		case Token::POSTURE:
+			if (token.posture) {
+				tempPosture = rewrite(*token.posture, wordMarker, rewriterData);
 				if (tempPosture) {
-					tempPosture1 = rewrite(*tempPosture, wordMarker, rewriterData);
-					if (tempPosture1) {
-						eventList_.newPostureWithObject(*tempPosture1);
-					}
 					eventList_.newPostureWithObject(*tempPosture);
-					eventList_.setCurrentPostureTempo(postureTempo);
-					eventList_.setCurrentPostureRuleTempo((float) ruleTempo);
 				}
-				postureTempo = 1.0;
-				ruleTempo = 1.0;
-				wordMarker = 0;
-			} else {
-				//printf("Unknown character %c\n", string[index++]);
-				break;
+				eventList_.newPostureWithObject(*token.posture);
+				eventList_.setCurrentPostureTempo(postureTempo);
+				eventList_.setCurrentPostureRuleTempo((float) ruleTempo);
 			}
+			postureTempo = 1.0;
+			ruleTempo = 1.0;
+			wordMarker = 0;
+			break;
 		}
 	}
-	return 0;
+
+	/*  END OF CHUNK  */
+	eventList_.newPostureWithObject(*endPosture_);
+	eventList_.newPostureWithObject(*silencePosture_);
 }
 
 const TRMControlModel::Posture*
@@ -498,8 +408,8 @@ PhoneticStringParser::calcVowelTransition(const TRMControlModel::Posture& nextPo
 	default:
 	case 0:
 		return nullptr;
-	case 1: return model_.postureList().find("gs");
-	case 2: return model_.postureList().find("r");
+	case 1: return transitionPosture_[0];
+	case 2: return transitionPosture_[1];
 	}
 }
 
@@ -24,18 +24,33 @@
 #include <memory>
 
 #include "Controller.h"
+#include "en/phonetic_string_parser/PhoneticStringTokenizer.h"
+#include "en/phonetic_string_parser/PhoneticTokenList.h"
 
 
 
 namespace GS {
 namespace En {
 
+/*******************************************************************************
+ * The chunks of a phonetic token list, produced by the text parser or by
+ * tokenize(), are added to the event list.
+ */
 class PhoneticStringParser {
 public:
+	typedef PhoneticTokenList TokenList;
+
 	PhoneticStringParser(const char* configDirPath, TRMControlModel::Controller& controller);
 	~PhoneticStringParser();
 
-	int parseString(const char* string);
+	// Converts a phonetic string from an external source, or written for
+	// debugging, to tokens.
+	void tokenize(const char* phoneticString, PhoneticTokenList& tokenList) const {
+		tokenizer_.tokenize(phoneticString, tokenList);
+	}
+
+	// Adds the postures of the chunk to the event list.
+	void parseChunk(const PhoneticTokenList& tokenList, int chunk);
 private:
 	PhoneticStringParser(const PhoneticStringParser&) = delete;
 	PhoneticStringParser& operator=(const PhoneticStringParser&) = delete;
@@ -55,8 +70,14 @@ private:
 
 	const TRMControlModel::Model& model_;
 	TRMControlModel::EventList& eventList_;
+	const PhoneticStringTokenizer tokenizer_;
 	std::shared_ptr<const TRMControlModel::Category> category_[18];
 	const TRMControlModel::Posture* returnPhone_[7];
+	const TRMControlModel::Posture* silencePosture_;    // "^"
+	const TRMControlModel::Posture* endPosture_;        // "#"
+	const TRMControlModel::Posture* lPosture_[2];       // "l", "l'"
+	const TRMControlModel::Posture* llPosture_[2];      // "ll", "ll'"
+	const TRMControlModel::Posture* transitionPosture_[2]; // "gs", "r"
 	int vowelTransitions_[13][13];
 };
 
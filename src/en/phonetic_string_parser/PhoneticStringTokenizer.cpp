@@ -0,0 +1,199 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "en/phonetic_string_parser/PhoneticStringTokenizer.h"
+
+#include <cctype> /* isalpha, isdigit, isspace */
+#include <cstdlib> /* atof */
+#include <cstring> /* strlen */
+
+#include "EventList.h"
+#include "Model.h"
+#include "Posture.h"
+
+
+
+namespace GS {
+namespace En {
+
+PhoneticStringTokenizer::PhoneticStringTokenizer(const TRMControlModel::Model& model)
+		: model_(model)
+{
+	const TRMControlModel::PostureList& postureList = model.postureList();
+
+	postureMap_.reserve(postureList.size());
+	for (TRMControlModel::PostureList::size_type i = 0; i < postureList.size(); ++i) {
+		const TRMControlModel::Posture& posture = postureList[i];
+		postureMap_[posture.name()] = &posture;
+	}
+}
+
+PhoneticStringTokenizer::~PhoneticStringTokenizer()
+{
+}
+
+/******************************************************************************
+*
+*       function:       tokenize
+*
+*       purpose:        Converts the phonetic string to typed tokens, finding
+*                       the postures in the table built by the constructor.  The
+*                       marked feet use the stressed form of the postures.
+*
+******************************************************************************/
+void
+PhoneticStringTokenizer::tokenize(const char* phoneticString, PhoneticTokenList& tokenList) const
+{
+	typedef PhoneticTokenList::Token Token;
+	const char* string = phoneticString;
+	int length;
+	int index = 0, bufferIndex = 0;
+	char buffer[128];
+	int markedFoot = 0;
+
+	tokenList.clear(string);
+
+	length = strlen(string);
+
+	while (index < length) {
+		while ((isspace(string[index]) || (string[index] == '_')) && (index<length)) index++;
+		if (index >= length) break;
+
+		bufferIndex = 0;
+		const int position = index;
+
+		switch (string[index]) {
+		case '/': /* Handle "/" escape sequences */
+			index++;
+			switch(string[index]) {
+			case '0': /* Tone group 0. Statement */
+				index++;
+				tokenList.add(Token::TONE_GROUP_TYPE, position, TONE_GROUP_TYPE_STATEMENT);
+				break;
+			case '1': /* Tone group 1. Exclamation */
+				index++;
+				tokenList.add(Token::TONE_GROUP_TYPE, position, TONE_GROUP_TYPE_EXCLAMATION);
+				break;
+			case '2': /* Tone group 2. Question */
+				index++;
+				tokenList.add(Token::TONE_GROUP_TYPE, position, TONE_GROUP_TYPE_QUESTION);
+				break;
+			case '3': /* Tone group 3. Continuation */
+				index++;
+				tokenList.add(Token::TONE_GROUP_TYPE, position, TONE_GROUP_TYPE_CONTINUATION);
+				break;
+			case '4': /* Tone group 4. Semi-colon */
+				index++;
+				tokenList.add(Token::TONE_GROUP_TYPE, position, TONE_GROUP_TYPE_SEMICOLON);
+				break;
+			case ' ':
+			case '_': /* New foot */
+				tokenList.add(Token::NEW_FOOT, position);
+				markedFoot = 0;
+				index++;
+				break;
+			case '*': /* New Marked foot */
+				tokenList.add(Token::NEW_MARKED_FOOT, position);
+				markedFoot = 1;
+				index++;
+				break;
+			case '/': /* New Tone Group */
+				index++;
+				tokenList.add(Token::NEW_TONE_GROUP, position);
+				break;
+			case 'c': /* New Chunk */
+				/*  EACH CHUNK STARTS WITH A NEW STATE  */
+				tokenList.add(Token::NEW_CHUNK, position);
+				markedFoot = 0;
+				index++;
+				break;
+			case 'l': /* Last Foot in tone group marker */
+				index++;
+				tokenList.add(Token::LAST_FOOT, position);
+				break;
+			case 'w': /* word marker */
+				index++;
+				tokenList.add(Token::WORD_MARKER, position);
+				break;
+			case 'f': /* Foot tempo indicator */
+			case 'r': /* Rule tempo indicator */
+				{
+					const Token::Type type = (string[index] == 'f') ? Token::FOOT_TEMPO : Token::RULE_TEMPO;
+					index++;
+					while ((isspace(string[index]) || (string[index] == '_')) && (index < length)) {
+						index++;
+					}
+					while ((isdigit(string[index]) || (string[index] == '.')) && (bufferIndex < 127)) {
+						buffer[bufferIndex++] = string[index++];
+					}
+					buffer[bufferIndex] = '\0';
+					tokenList.add(type, position, 0, atof(buffer));
+				}
+				break;
+			default:
+				index++;
+				break;
+			}
+			break;
+		case '.': /* Syllable Marker */
+			tokenList.add(Token::SYLLABLE, position);
+			index++;
+			break;
+
+		case '0':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		case '8':
+		case '9':
+			while ((isdigit(string[index]) || (string[index] == '.')) && (bufferIndex < 127)) {
+				buffer[bufferIndex++] = string[index++];
+			}
+			buffer[bufferIndex] = '\0';
+			tokenList.add(Token::POSTURE_TEMPO, position, 0, atof(buffer));
+			break;
+
+		default:
+			if (isalpha(string[index]) || (string[index] == '^') || (string[index] == '\'')
+					|| (string[index] == '#') ) {
+				while ( (isalpha(string[index])||(string[index] == '^')||(string[index] == '\'')
+						||(string[index] == '#')) && (index < length)) {
+					if (bufferIndex < 126) {
+						buffer[bufferIndex++] = string[index];
+					}
+					index++;
+				}
+				if (markedFoot) {
+					buffer[bufferIndex++] = '\'';
+				}
+				const auto iter = postureMap_.find(std::string_view(buffer, bufferIndex));
+				tokenList.add(Token::POSTURE, position, 0, 1.0,
+						(iter == postureMap_.end()) ? nullptr : iter->second);
+			} else {
+				index++;
+			}
+			break;
+		}
+	}
+}
+
+} /* namespace En */
+} /* namespace GS */
@@ -0,0 +1,64 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef EN_PHONETIC_STRING_TOKENIZER_H_
+#define EN_PHONETIC_STRING_TOKENIZER_H_
+
+#include <string_view>
+#include <unordered_map>
+
+#include "en/phonetic_string_parser/PhoneticTokenList.h"
+
+
+
+namespace GS {
+namespace TRMControlModel {
+class Model;
+class Posture;
+}
+namespace En {
+
+/*******************************************************************************
+ * Converts phonetic strings to tokens, finding the postures in a table built
+ * from the model. It is used by the text parser for its output, and by
+ * PhoneticStringParser for phonetic strings from other sources.
+ *
+ * The model must not be destroyed before the tokenizer.
+ */
+class PhoneticStringTokenizer {
+public:
+	explicit PhoneticStringTokenizer(const TRMControlModel::Model& model);
+	~PhoneticStringTokenizer();
+
+	const TRMControlModel::Model& model() const { return model_; }
+
+	// The string must not be changed while the token list is in use.
+	// Does not allocate memory after the token list has grown to the size
+	// of the input.
+	void tokenize(const char* phoneticString, PhoneticTokenList& tokenList) const;
+private:
+	PhoneticStringTokenizer(const PhoneticStringTokenizer&) = delete;
+	PhoneticStringTokenizer& operator=(const PhoneticStringTokenizer&) = delete;
+
+	const TRMControlModel::Model& model_;
+	std::unordered_map<std::string_view, const TRMControlModel::Posture*> postureMap_;
+};
+
+} /* namespace En */
+} /* namespace GS */
+
+#endif /* EN_PHONETIC_STRING_TOKENIZER_H_ */
@@ -0,0 +1,140 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "en/phonetic_string_parser/PhoneticTokenList.h"
+
+#include "Exception.h"
+
+
+
+namespace GS {
+namespace En {
+
+PhoneticTokenList::PhoneticTokenList()
+		: string_("")
+{
+}
+
+PhoneticTokenList::~PhoneticTokenList()
+{
+}
+
+void
+PhoneticTokenList::clear(const char* string)
+{
+	string_ = string;
+	tokenList_.clear();
+	chunkTokenList_.clear();
+}
+
+void
+PhoneticTokenList::add(Token::Type type, std::size_t position, int toneGroupType, double tempo,
+			const TRMControlModel::Posture* posture)
+{
+	if (type == Token::NEW_CHUNK) {
+		chunkTokenList_.push_back(tokenList_.size());
+	}
+	tokenList_.emplace_back();
+	Token& token = tokenList_.back();
+	token.type = type;
+	token.toneGroupType = toneGroupType;
+	token.tempo = tempo;
+	token.posture = posture;
+	token.position = position;
+}
+
+int
+PhoneticTokenList::numChunks() const
+{
+	return chunkTokenList_.empty() ? 0 : static_cast<int>(chunkTokenList_.size()) - 1;
+}
+
+void
+PhoneticTokenList::checkChunk(int chunk) const
+{
+	if (chunk < 0 || chunk >= numChunks()) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid chunk: " << chunk << '.');
+	}
+}
+
+std::size_t
+PhoneticTokenList::chunkBegin(int chunk) const
+{
+	checkChunk(chunk);
+	return (chunk == 0) ? 0 : chunkTokenList_[chunk];
+}
+
+std::size_t
+PhoneticTokenList::chunkEnd(int chunk) const
+{
+	checkChunk(chunk);
+	return chunkTokenList_[chunk + 1];
+}
+
+const char*
+PhoneticTokenList::chunkString(int chunk) const
+{
+	return string_ + tokenList_[chunkBegin(chunk)].position;
+}
+
+void
+PhoneticTokenList::append(const PhoneticTokenList& list, std::size_t begin, std::size_t end)
+{
+	for (std::size_t i = begin; i < end; ++i) {
+		const Token& token = list.tokenList_[i];
+		add(token.type, token.position, token.toneGroupType, token.tempo, token.posture);
+	}
+}
+
+/*******************************************************************************
+ * The second NEW_TONE_GROUP of the first chunk separates the first and second
+ * tone groups, unless it is followed by the end of the chunk. The first list
+ * ends after the marker, and the rest starts with a new chunk at the marker.
+ */
+bool
+PhoneticTokenList::splitFirstToneGroup(PhoneticTokenList& first, PhoneticTokenList& rest) const
+{
+	if (numChunks() == 0) {
+		return false;
+	}
+
+	int numberOfToneGroupMarkers = 0;
+	const std::size_t end = chunkEnd(0);
+	for (std::size_t i = 0; i < end; ++i) {
+		if (tokenList_[i].type != Token::NEW_TONE_GROUP || ++numberOfToneGroupMarkers < 2) {
+			continue;
+		}
+		if (tokenList_[i + 1].type == Token::NEW_CHUNK) {
+			return false;
+		}
+		const std::size_t position = tokenList_[i].position;
+
+		first.clear(string_);
+		first.append(*this, 0, i + 1);
+		first.add(Token::NEW_CHUNK, position);
+
+		rest.clear(string_);
+		rest.add(Token::NEW_CHUNK, position);
+		rest.append(*this, i, tokenList_.size());
+		return true;
+	}
+
+	return false;
+}
+
+} /* namespace En */
+} /* namespace GS */
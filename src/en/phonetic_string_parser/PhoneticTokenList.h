@@ -0,0 +1,98 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef EN_PHONETIC_TOKEN_LIST_H_
+#define EN_PHONETIC_TOKEN_LIST_H_
+
+#include <cstddef> /* std::size_t */
+#include <vector>
+
+
+
+namespace GS {
+namespace TRMControlModel {
+class Posture;
+}
+namespace En {
+
+/*******************************************************************************
+ * Phonetic string converted to typed tokens, with the postures already found
+ * in the model. The chunks are separated by NEW_CHUNK tokens, and the tokens
+ * after the last NEW_CHUNK are ignored.
+ *
+ * The list keeps a pointer to the phonetic string, used only to print the
+ * chunks. The string must not be changed while the list is in use.
+ */
+class PhoneticTokenList {
+public:
+	struct Token {
+		enum Type {
+			TONE_GROUP_TYPE, // /0 - /4
+			NEW_FOOT,        // "/_" or "/ "
+			NEW_MARKED_FOOT, // /*
+			NEW_TONE_GROUP,  // //
+			NEW_CHUNK,       // /c
+			LAST_FOOT,       // /l
+			WORD_MARKER,     // /w
+			FOOT_TEMPO,      // /f
+			RULE_TEMPO,      // /r
+			SYLLABLE,        // .
+			POSTURE_TEMPO,
+			POSTURE
+		};
+		Type type;
+		int toneGroupType;
+		double tempo;
+		const TRMControlModel::Posture* posture; // nullptr if the posture does not exist
+		std::size_t position; // in the phonetic string
+	};
+
+	PhoneticTokenList();
+	~PhoneticTokenList();
+
+	void clear(const char* string = "");
+	void add(Token::Type type, std::size_t position, int toneGroupType = 0, double tempo = 1.0,
+			const TRMControlModel::Posture* posture = nullptr);
+
+	bool empty() const { return tokenList_.empty(); }
+	std::size_t size() const { return tokenList_.size(); }
+	const Token& operator[](std::size_t index) const { return tokenList_[index]; }
+
+	int numChunks() const;
+	// The first chunk also contains the tokens before the first NEW_CHUNK.
+	std::size_t chunkBegin(int chunk) const;
+	std::size_t chunkEnd(int chunk) const;
+	// Returns the phonetic string, starting at the chunk.
+	const char* chunkString(int chunk) const;
+
+	// Splits the first chunk after its first tone group, so that the tone
+	// group can be synthesized before the rest of the text.
+	// Returns false if the first chunk contains only one tone group.
+	bool splitFirstToneGroup(PhoneticTokenList& first, PhoneticTokenList& rest) const;
+private:
+	void checkChunk(int chunk) const;
+	void append(const PhoneticTokenList& list, std::size_t begin, std::size_t end);
+
+	const char* string_;
+	std::vector<Token> tokenList_;
+	std::vector<std::size_t> chunkTokenList_; // indexes in tokenList_ of the NEW_CHUNK tokens
+};
+
+} /* namespace En */
+} /* namespace GS */
+
+#endif /* EN_PHONETIC_TOKEN_LIST_H_ */
@@ -0,0 +1,295 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "en/text_parser/PronunciationCache.h"
+
+#include <cerrno>
+#include <cstdlib> /* strtol */
+#include <cstring> /* strerror */
+#include <fstream>
+#include <iterator> /* prev */
+
+#include "Exception.h"
+#include "Log.h"
+#include "TemporaryFile.h"
+
+
+
+namespace {
+
+const char* const FILE_HEADER = "GSPRONCACHE 1";
+
+} /* namespace */
+
+//==============================================================================
+
+namespace GS {
+namespace En {
+
+/*******************************************************************************
+ *
+ */
+PronunciationCache::Statistics::Statistics()
+		: lookups(0)
+		, hits()
+		, evictions(0)
+{
+}
+
+/*******************************************************************************
+ *
+ */
+unsigned long long
+PronunciationCache::Statistics::totalHits() const
+{
+	unsigned long long n = 0;
+	for (unsigned long long h : hits) {
+		n += h;
+	}
+	return n;
+}
+
+/*******************************************************************************
+ * Constructor.
+ */
+PronunciationCache::PronunciationCache(unsigned int maxSize)
+		: maxSize_(maxSize)
+{
+}
+
+/*******************************************************************************
+ * Destructor.
+ */
+PronunciationCache::~PronunciationCache()
+{
+}
+
+/*******************************************************************************
+ *
+ */
+void
+PronunciationCache::setMaxSize(unsigned int maxSize)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	maxSize_ = maxSize;
+	removeExcessEntries();
+}
+
+/*******************************************************************************
+ *
+ */
+unsigned int
+PronunciationCache::maxSize() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return maxSize_;
+}
+
+/*******************************************************************************
+ * The caller must hold the lock.
+ */
+void
+PronunciationCache::removeExcessEntries()
+{
+	while (map_.size() > maxSize_) {
+		map_.erase(entryList_.back().word);
+		entryList_.pop_back();
+		++statistics_.evictions;
+	}
+}
+
+/*******************************************************************************
+ *
+ */
+bool
+PronunciationCache::find(std::string_view word, std::string& pronunciation, short& source)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	++statistics_.lookups;
+
+	auto iter = map_.find(word);
+	if (iter == map_.end()) {
+		return false;
+	}
+	const Entry& entry = *iter->second;
+	if (entry.source >= 0 && entry.source < MAX_SOURCES) {
+		++statistics_.hits[entry.source];
+	}
+	pronunciation = entry.pronunciation;
+	source = entry.source;
+	entryList_.splice(entryList_.begin(), entryList_, iter->second);
+	return true;
+}
+
+/*******************************************************************************
+ * The node of the least recently used entry is reused when the cache is full.
+ */
+void
+PronunciationCache::insert(std::string_view word, std::string_view pronunciation, short source)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (maxSize_ == 0) {
+		return;
+	}
+
+	auto iter = map_.find(word);
+	if (iter != map_.end()) {
+		iter->second->pronunciation = pronunciation;
+		iter->second->source = source;
+		entryList_.splice(entryList_.begin(), entryList_, iter->second);
+		return;
+	}
+
+	if (map_.size() >= maxSize_) {
+		map_.erase(entryList_.back().word);
+		entryList_.splice(entryList_.begin(), entryList_, std::prev(entryList_.end()));
+		++statistics_.evictions;
+	} else {
+		entryList_.emplace_front();
+	}
+	Entry& entry = entryList_.front();
+	entry.word = word;
+	entry.pronunciation = pronunciation;
+	entry.source = source;
+	map_[entry.word] = entryList_.begin();
+}
+
+/*******************************************************************************
+ *
+ */
+void
+PronunciationCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	map_.clear();
+	entryList_.clear();
+}
+
+/*******************************************************************************
+ *
+ */
+unsigned int
+PronunciationCache::size() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return map_.size();
+}
+
+/*******************************************************************************
+ *
+ */
+PronunciationCache::Statistics
+PronunciationCache::statistics() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return statistics_;
+}
+
+/*******************************************************************************
+ *
+ */
+void
+PronunciationCache::resetStatistics()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	statistics_ = Statistics();
+}
+
+/*******************************************************************************
+ * Format:
+ *   header line
+ *   signature line
+ *   one line per entry, from the least recently used: word TAB source TAB pronunciation
+ *
+ * The entries are added to the current entries.
+ */
+bool
+PronunciationCache::load(const std::string& filePath, const std::string& signature)
+{
+	std::ifstream in(filePath, std::ios_base::in | std::ios_base::binary);
+	if (!in) {
+		return false;
+	}
+
+	std::string line;
+	if (!std::getline(in, line) || line != FILE_HEADER) {
+		LOG_ERROR("Invalid pronunciation cache file: " << filePath << '.');
+		return false;
+	}
+	if (!std::getline(in, line) || line != signature) {
+		LOG_DEBUG("The pronunciation cache file " << filePath << " was created with other dictionaries.");
+		return false;
+	}
+
+	unsigned int lineNumber = 2;
+	while (std::getline(in, line)) {
+		++lineNumber;
+		const std::size_t sep1 = line.find('\t');
+		const std::size_t sep2 = (sep1 == std::string::npos) ? sep1 : line.find('\t', sep1 + 1U);
+		if (sep2 == std::string::npos || sep1 == 0) {
+			THROW_EXCEPTION(InvalidFileException, "Invalid entry in the pronunciation cache file " << filePath
+					<< " (line " << lineNumber << ").");
+		}
+		char* end;
+		const long source = std::strtol(line.c_str() + sep1 + 1U, &end, 10);
+		if (end != line.c_str() + sep2 || source < 0 || source >= MAX_SOURCES) {
+			THROW_EXCEPTION(InvalidFileException, "Invalid source in the pronunciation cache file " << filePath
+					<< " (line " << lineNumber << ").");
+		}
+		const std::string_view lineView(line);
+		insert(lineView.substr(0, sep1), lineView.substr(sep2 + 1U), static_cast<short>(source));
+	}
+	return true;
+}
+
+/*******************************************************************************
+ * The file is written to a temporary file, which is then renamed.
+ */
+void
+PronunciationCache::save(const std::string& filePath, const std::string& signature) const
+{
+	if (signature.find('\n') != std::string::npos) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid pronunciation cache signature.");
+	}
+
+	TemporaryFile tempFile(filePath);
+	{
+		std::ofstream out(tempFile.path(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (!out) {
+			THROW_EXCEPTION(IOException, "Could not open the file " << tempFile.path() << ": " << std::strerror(errno) << '.');
+		}
+		out << FILE_HEADER << '\n' << signature << '\n';
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (auto iter = entryList_.rbegin(); iter != entryList_.rend(); ++iter) {
+				if (iter->word.find_first_of("\t\n") != std::string::npos ||
+						iter->pronunciation.find('\n') != std::string::npos) {
+					continue;
+				}
+				out << iter->word << '\t' << iter->source << '\t' << iter->pronunciation << '\n';
+			}
+		}
+		out.close();
+		if (!out) {
+			THROW_EXCEPTION(IOException, "Could not write the file " << tempFile.path() << '.');
+		}
+	}
+	tempFile.commit();
+}
+
+} /* namespace En */
+} /* namespace GS */
@@ -0,0 +1,100 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef EN_PRONUNCIATION_CACHE_H_
+#define EN_PRONUNCIATION_CACHE_H_
+
+#include <list>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+
+
+namespace GS {
+namespace En {
+
+/*******************************************************************************
+ * Cache of word pronunciations, with the source (dictionary, number parser,
+ * letter-to-sound) of each pronunciation.
+ *
+ * The least recently used entry is discarded when the cache is full.
+ * The member functions may be called concurrently, so a cache may be shared
+ * by many text parsers.
+ */
+class PronunciationCache {
+public:
+	enum {
+		DEFAULT_MAX_SIZE = 16384,
+		MAX_SOURCES = 8
+	};
+
+	struct Statistics {
+		unsigned long long lookups;
+		unsigned long long hits[MAX_SOURCES]; // by source
+		unsigned long long evictions;
+
+		Statistics();
+		unsigned long long totalHits() const;
+	};
+
+	explicit PronunciationCache(unsigned int maxSize = DEFAULT_MAX_SIZE);
+	~PronunciationCache();
+
+	// maxSize = 0 disables the cache.
+	void setMaxSize(unsigned int maxSize);
+	unsigned int maxSize() const;
+
+	// Returns false if the word is not in the cache.
+	bool find(std::string_view word, std::string& pronunciation, short& source);
+	void insert(std::string_view word, std::string_view pronunciation, short source);
+	void clear();
+	unsigned int size() const;
+
+	Statistics statistics() const;
+	void resetStatistics();
+
+	// The signature identifies the dictionaries used to create the entries.
+	// Returns false if the file does not exist or has a different signature.
+	bool load(const std::string& filePath, const std::string& signature);
+	void save(const std::string& filePath, const std::string& signature) const;
+private:
+	struct Entry {
+		std::string word;
+		std::string pronunciation;
+		short source;
+	};
+	typedef std::list<Entry> EntryList;
+
+	PronunciationCache(const PronunciationCache&) = delete;
+	PronunciationCache& operator=(const PronunciationCache&) = delete;
+
+	void removeExcessEntries();
+
+	mutable std::mutex mutex_;
+	unsigned int maxSize_;
+	EntryList entryList_; // the most recently used entry is at the front
+	std::unordered_map<std::string_view, EntryList::iterator> map_; // the keys point to the words in entryList_
+	Statistics statistics_;
+};
+
+} /* namespace En */
+} /* namespace GS */
+
+#endif /* EN_PRONUNCIATION_CACHE_H_ */
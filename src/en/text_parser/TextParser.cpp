@@ -51,12 +51,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <utility> /* move */
 #include <vector>
 
-#include "en/letter_to_sound/letter_to_sound.h"
 #include "en/text_parser/abbreviations.h"
 #include "en/text_parser/special_acronyms.h"
 #include "Exception.h"
+#include "global.h"
 #include "Log.h"
 
 
@@ -169,20 +170,111 @@
 
 namespace {
 
-void print_stream(std::stringstream& stream, long stream_length);
-void strip_punctuation(char* buffer, int length, std::stringstream& stream, long *stream_length);
+/******************************************************************************
+*
+*       class:          ChunkBuffer
+*
+*       purpose:        Gap buffer used by safety_check().  The characters
+*                       before the gap are copied to front_ and may be
+*                       modified;  the characters after the gap are read
+*                       directly from the original stream.  The chunk
+*                       markers are inserted near the read position, so each
+*                       insertion moves only a few characters, and the stream
+*                       is copied once.  front_ is a work string owned by the
+*                       caller, so its memory is reused between calls.
+*
+*                       The read functions behave like the corresponding
+*                       std::istream functions:  after an invalid seek all
+*                       the operations fail.
+*
+******************************************************************************/
+class ChunkBuffer {
+public:
+	ChunkBuffer(const std::string& stream, std::string& work)
+			: stream_(stream)
+			, front_(work)
+			, back_(0)
+			, readPos_(0)
+			, fail_(false) {
+		front_.clear();
+		front_.reserve(stream.size() + stream.size() / 64U + 16U);
+	}
+
+	std::size_t size() const { return front_.size() + (stream_.size() - back_); }
+	bool good() const { return !fail_; }
+
+	bool get(char& c) {
+		if (fail_ || readPos_ >= size()) {
+			fail_ = true;
+			return false;
+		}
+		c = (readPos_ < front_.size()) ? front_[readPos_] : stream_[back_ + (readPos_ - front_.size())];
+		++readPos_;
+		return true;
+	}
+	void unget() {
+		if (!fail_ && readPos_ > 0) {
+			--readPos_;
+		}
+	}
+	long tell() const { return fail_ ? -1 : static_cast<long>(readPos_); }
+	void seek(long pos) {
+		if (fail_ || pos < 0 || static_cast<std::size_t>(pos) > size()) {
+			fail_ = true;
+		} else {
+			readPos_ = pos;
+		}
+	}
+
+	// Overwrites the characters starting at pos.
+	void write(long pos, const char* s) {
+		if (fail_) return;
+		const std::size_t n = strlen(s);
+		moveGap(pos + n);
+		front_.replace(pos, n, s);
+	}
+	void insert(long pos, const char* s) {
+		if (fail_) return;
+		moveGap(pos);
+		front_.insert(pos, s);
+	}
+
+	// Swaps the result with the original stream.
+	void release(std::string& stream) {
+		moveGap(size());
+		stream.swap(front_);
+	}
+private:
+	void moveGap(std::size_t pos) {
+		if (pos > front_.size()) {
+			const std::size_t n = pos - front_.size();
+			front_.append(stream_, back_, n);
+			back_ += n;
+		}
+	}
+
+	const std::string& stream_;
+	std::string& front_;
+	std::size_t back_;
+	std::size_t readPos_;
+	bool fail_;
+};
+
+void print_stream(const std::string& stream, long stream_length);
+void strip_punctuation(char* buffer, int length, std::string& stream, long *stream_length);
 int get_state(const char* buffer, long* i, long length, int* mode, int* next_mode,
 		int* current_state, int* next_state, int* raw_mode_flag,
-		char* word, std::stringstream& stream);
-int set_tone_group(std::stringstream& stream, long tg_pos, const char* word);
-float convert_silence(const char* buffer, std::stringstream& stream);
+		char* word, std::string& stream);
+const char* tone_group_marker(const char* word);
+int set_tone_group(std::string& stream, long tg_pos, const char* word);
+float convert_silence(const char* buffer, std::string& stream);
 int another_word_follows(const char* buffer, long i, long length, int mode);
-int shift_silence(const char* buffer, long i, long length, int mode, std::stringstream& stream);
-void insert_tag(std::stringstream& stream, long insert_point, const char* word);
-int expand_raw_mode(const char *buffer, long* j, long length, std::stringstream& stream);
+int shift_silence(const char* buffer, long i, long length, int mode, std::string& stream);
+void insert_tag(std::string& stream, long insert_point, const char* word);
+int expand_raw_mode(const char *buffer, long* j, long length, std::string& stream);
 int illegal_token(const char* token);
 int illegal_slash_code(const char* code);
-int expand_tag_number(const char* buffer, long* j, long length, std::stringstream& stream);
+int expand_tag_number(const char* buffer, long* j, long length, std::string& stream);
 int is_mode(char c);
 int is_isolated(char *buffer, int i, int len);
 int part_of_number(char *buffer, int i, int len);
@@ -192,17 +284,17 @@ int convert_dash(char *buffer, int *i, int length);
 int is_telephone_number(char *buffer, int i, int length);
 int is_punctuation(char c);
 int word_follows(const char* buffer, int i, int length);
-int expand_abbreviation(char* buffer, int i, int length, std::stringstream& stream);
-void expand_letter_mode(const char* buffer, int* i, int length, std::stringstream& stream, int* status);
+int expand_abbreviation(char* buffer, int i, int length, std::string& stream);
+void expand_letter_mode(const char* buffer, int* i, int length, std::string& stream, int* status);
 int is_all_upper_case(const char* word);
 char *to_lower_case(char *word);
 const char* is_special_acronym(const char* word);
 int contains_primary_stress(const char *pronunciation);
 int converted_stress(char *pronunciation);
 int is_possessive(char* word);
-void safety_check(std::stringstream& stream, long* stream_length);
-void insert_chunk_marker(std::stringstream& stream, long insert_point, char tg_type);
-void check_tonic(std::stringstream& stream, long start_pos, long end_pos);
+void safety_check(std::string& stream, long* stream_length, std::string& work);
+void insert_chunk_marker(ChunkBuffer& buffer, long insert_point, char tg_type);
+void check_tonic(ChunkBuffer& buffer, long start_pos, long end_pos);
 
 
 
@@ -215,15 +307,12 @@ void check_tonic(std::stringstream& stream, long start_pos, long end_pos);
 *
 ******************************************************************************/
 void
-print_stream(std::stringstream& stream, long stream_length)
+print_stream(const std::string& stream, long stream_length)
 {
-	/*  REWIND STREAM TO BEGINNING  */
-	stream.seekg(0);
-
 	/*  PRINT LOOP  */
 	printf("stream_length = %-ld\n<begin>", stream_length);
 	for (long i = 0; i < stream_length; i++) {
-		char c = stream.get();
+		char c = stream[i];
 		switch (c) {
 		case RAW_MODE_BEGIN:
 			printf("<raw mode begin>");
@@ -275,7 +364,7 @@ print_stream(std::stringstream& stream, long stream_length)
 *
 ******************************************************************************/
 void
-strip_punctuation(char* buffer, int length, std::stringstream& stream, long* stream_length)
+strip_punctuation(char* buffer, int length, std::string& stream, long* stream_length)
 {
 	int i, mode = NORMAL_MODE, status;
 
@@ -359,26 +448,26 @@ strip_punctuation(char* buffer, int length, std::stringstream& stream, long* str
 	}
 
 	/*  SECOND PASS  */
-	stream.str("");
+	stream.clear();
 	mode = NORMAL_MODE;  status = PUNCTUATION;
 	for (i = 0; i < length; i++) {
 		switch(buffer[i]) {
-		case RAW_MODE_BEGIN:      mode = RAW_MODE;      stream << buffer[i]; break;
-		case EMPHASIS_MODE_BEGIN: mode = EMPHASIS_MODE; stream << buffer[i]; break;
-		case TAGGING_MODE_BEGIN:  mode = TAGGING_MODE;  stream << buffer[i]; break;
-		case SILENCE_MODE_BEGIN:  mode = SILENCE_MODE;  stream << buffer[i]; break;
+		case RAW_MODE_BEGIN:      mode = RAW_MODE;      stream += buffer[i]; break;
+		case EMPHASIS_MODE_BEGIN: mode = EMPHASIS_MODE; stream += buffer[i]; break;
+		case TAGGING_MODE_BEGIN:  mode = TAGGING_MODE;  stream += buffer[i]; break;
+		case SILENCE_MODE_BEGIN:  mode = SILENCE_MODE;  stream += buffer[i]; break;
 		case LETTER_MODE_BEGIN:   mode = LETTER_MODE;   /*  expand below  */    ; break;
 
 		case RAW_MODE_END:
 		case EMPHASIS_MODE_END:
 		case TAGGING_MODE_END:
-		case SILENCE_MODE_END:    mode = NORMAL_MODE;   stream << buffer[i]; break;
+		case SILENCE_MODE_END:    mode = NORMAL_MODE;   stream += buffer[i]; break;
 		case LETTER_MODE_END:     mode = NORMAL_MODE;   /*  expand below  */    ; break;
 
 		case DELETED:
 			/*  CONVERT ALL DELETED CHARACTERS TO BLANKS  */
 			buffer[i] = ' ';
-			stream << ' ';
+			stream += ' ';
 			break;
 
 		default:
@@ -389,7 +478,7 @@ strip_punctuation(char* buffer, int length, std::stringstream& stream, long* str
 					if ( ((i+2) < length) && (buffer[i+2] == ')') &&
 							((buffer[i+1] == '!') || (buffer[i+1] == '?')) ) {
 						buffer[i] = buffer[i+1] = buffer[i+2] = ' ';
-						stream << "   ";
+						stream += "   ";
 						i += 2;
 						continue;
 					}
@@ -397,7 +486,7 @@ strip_punctuation(char* buffer, int length, std::stringstream& stream, long* str
 					if (is_telephone_number(buffer, i, length)) {
 						int j;
 						for (j = 0; j < 12; j++) {
-							stream << buffer[i++];
+							stream += buffer[i++];
 						}
 						status = WORD;
 						continue;
@@ -405,68 +494,68 @@ strip_punctuation(char* buffer, int length, std::stringstream& stream, long* str
 					/*  CONVERT TO COMMA IF PRECEDED BY WORD, FOLLOWED BY WORD  */
 					if ((status == WORD) && word_follows(buffer, i, length)) {
 						buffer[i] = ' ';
-						stream << ", ";
+						stream += ", ";
 						status = PUNCTUATION;
 					} else {
 						buffer[i] = ' ';
-						stream << ' ';
+						stream += ' ';
 					}
 					break;
 				case ')':
 					/*  CONVERT TO COMMA IF PRECEDED BY WORD, FOLLOWED BY WORD  */
 					if ((status == WORD) && word_follows(buffer, i, length)) {
 						buffer[i] = ',';
-						stream << ", ";
+						stream += ", ";
 						status = PUNCTUATION;
 					} else {
 						buffer[i] = ' ';
-						stream << ' ';
+						stream += ' ';
 					}
 					break;
 				case '&':
-					stream << AND;
+					stream += AND;
 					status = WORD;
 					break;
 				case '+':
 					if (is_isolated(buffer, i, length)) {
-						stream << PLUS;
+						stream += PLUS;
 					} else {
-						stream << '+';
+						stream += '+';
 					}
 					status = WORD;
 					break;
 				case '<':
-					stream << IS_LESS_THAN;
+					stream += IS_LESS_THAN;
 					status = WORD;
 					break;
 				case '>':
-					stream << IS_GREATER_THAN;
+					stream += IS_GREATER_THAN;
 					status = WORD;
 					break;
 				case '=':
-					stream << EQUALS;
+					stream += EQUALS;
 					status = WORD;
 					break;
 				case '-':
 					if (is_isolated(buffer, i, length)) {
-						stream << MINUS;
+						stream += MINUS;
 					} else {
-						stream << '-';
+						stream += '-';
 					}
 					status = WORD;
 					break;
 				case '@':
-					stream << AT;
+					stream += AT;
 					status = WORD;
 					break;
 				case '.':
 					if (!expand_abbreviation(buffer, i, length, stream)) {
-						stream << buffer[i];
+						stream += buffer[i];
 						status = PUNCTUATION;
 					}
 					break;
 				default:
-					stream << buffer[i];
+					stream += buffer[i];
 					if (is_punctuation(buffer[i])) {
 						status = PUNCTUATION;
 					} else if (isalnum(buffer[i])) {
@@ -480,14 +569,14 @@ strip_punctuation(char* buffer, int length, std::stringstream& stream, long* str
 				expand_letter_mode(buffer, &i, length, stream, &status);
 				continue;
 			} else { /*  ELSE PASS CHARACTERS STRAIGHT THROUGH  */
-				stream << buffer[i];
+				stream += buffer[i];
 			}
 			break;
 		}
 	}
 
 	/*  SET STREAM LENGTH  */
-	*stream_length = static_cast<long>(stream.tellp());
+	*stream_length = static_cast<long>(stream.size());
 }
 
 /******************************************************************************
@@ -502,7 +591,7 @@ strip_punctuation(char* buffer, int length, std::stringstream& stream, long* str
 int
 get_state(const char* buffer, long* i, long length, int* mode, int* next_mode,
 		int* current_state, int* next_state, int* raw_mode_flag,
-		char* word, std::stringstream& stream)
+		char* word, std::string& stream)
 {
 	long j;
 	int k, state = 0, current_mode;
@@ -674,53 +763,57 @@ get_state(const char* buffer, long* i, long length, int* mode, int* next_mode,
 
 /******************************************************************************
 *
-*       function:       set_tone_group
+*       function:       tone_group_marker
 *
-*       purpose:        Set the tone group marker according to the punctuation
-*                       passed in as "word".  The marker is inserted in the
-*                       stream at position "tg_pos".
+*       purpose:        Returns the tone group marker that corresponds to the
+*                       punctuation passed in as "word", or NULL if the
+*                       punctuation does not end a tone group.
 *
 ******************************************************************************/
-int
-set_tone_group(std::stringstream& stream, long tg_pos, const char* word)
+const char*
+tone_group_marker(const char* word)
 {
-	/*  RETURN IMMEDIATELY IF tg_pos NOT LEGAL  */
-	if (tg_pos == UNDEFINED_POSITION) {
-		return TTS_PARSER_FAILURE;
-	}
-
-	/*  GET CURRENT POSITION IN STREAM  */
-	long current_pos = static_cast<long>(stream.tellp());
-
-	/*  SEEK TO TONE GROUP MARKER POSITION  */
-	stream.seekp(tg_pos);
-
-	/*  WRITE APPROPRIATE TONE GROUP TYPE  */
 	switch (word[0]) {
 	case '.':
-		stream << TG_STATEMENT;
-		break;
+		return TG_STATEMENT;
 	case '!':
-		stream << TG_EXCLAMATION;
-		break;
+		return TG_EXCLAMATION;
 	case '?':
-		stream << TG_QUESTION;
-		break;
+		return TG_QUESTION;
 	case ',':
-		stream << TG_CONTINUATION;
-		break;
+		return TG_CONTINUATION;
 	case ';':
-		stream << TG_HALF_PERIOD;
-		break;
+		return TG_HALF_PERIOD;
 	case ':':
-		stream << TG_CONTINUATION;
-		break;
+		return TG_CONTINUATION;
 	default:
+		return NULL;
+	}
+}
+
+/******************************************************************************
+*
+*       function:       set_tone_group
+*
+*       purpose:        Set the tone group marker according to the punctuation
+*                       passed in as "word".  The marker overwrites the
+*                       undefined marker in the stream at position "tg_pos".
+*
+******************************************************************************/
+int
+set_tone_group(std::string& stream, long tg_pos, const char* word)
+{
+	/*  RETURN IMMEDIATELY IF tg_pos NOT LEGAL  */
+	if (tg_pos == UNDEFINED_POSITION) {
 		return TTS_PARSER_FAILURE;
 	}
 
-	/*  SEEK TO ORIGINAL POSITION ON STREAM  */
-	stream.seekp(current_pos);
+	/*  WRITE APPROPRIATE TONE GROUP TYPE  */
+	const char* marker = tone_group_marker(word);
+	if (marker == NULL) {
+		return TTS_PARSER_FAILURE;
+	}
+	stream.replace(tg_pos, strlen(marker), marker);
 
 	/*  RETURN SUCCESS */
 	return TTS_PARSER_SUCCESS;
@@ -737,7 +830,7 @@ set_tone_group(std::stringstream& stream, long tg_pos, const char* word)
 *
 ******************************************************************************/
 float
-convert_silence(const char* buffer, std::stringstream& stream)
+convert_silence(const char* buffer, std::string& stream)
 {
 	/*  CONVERT BUFFER TO DOUBLE  */
 	double silence_length = strtod(buffer, NULL);
@@ -749,11 +842,11 @@ convert_silence(const char* buffer, std::stringstream& stream)
 	int number_silence_phones = (int) rint(silence_length / SILENCE_PHONE_LENGTH);
 
 	/*  PUT IN UTTERANCE BOUNDARY MARKER  */
-	stream << UTTERANCE_BOUNDARY << ' ';
+	stream += UTTERANCE_BOUNDARY " ";
 
 	/*  WRITE OUT SILENCE PHONES TO STREAMS  */
 	for (int j = 0; j < number_silence_phones; j++) {
-		stream << SILENCE_PHONE << ' ';
+		stream += SILENCE_PHONE " ";
 	}
 
 	/*  RETURN ACTUAL LENGTH OF SILENCE  */
@@ -813,7 +906,7 @@ another_word_follows(const char* buffer, long i, long length, int mode)
 *
 ******************************************************************************/
 int
-shift_silence(const char* buffer, long i, long length, int mode, std::stringstream& stream)
+shift_silence(const char* buffer, long i, long length, int mode, std::string& stream)
 {
 	char word[WORD_LENGTH_MAX + 1];
 
@@ -874,37 +967,22 @@ shift_silence(const char* buffer, long i, long length, int mode, std::stringstre
 *
 ******************************************************************************/
 void
-insert_tag(std::stringstream& stream, long insert_point, const char* word)
+insert_tag(std::string& stream, long insert_point, const char* word)
 {
 	/*  RETURN IMMEDIATELY IF NO INSERT POINT  */
 	if (insert_point == UNDEFINED_POSITION) {
 		return;
 	}
 
-	/*  FIND POSITION OF END OF STREAM  */
-	long end_point = static_cast<long>(stream.tellp());
-
-	/*  CALCULATE HOW MANY CHARACTERS TO SHIFT  */
-	long length = end_point - insert_point;
-
-	/*  IF LENGTH IS 0, THEN SIMPLY APPEND TAG TO STREAM  */
-	if (length == 0) {
-		stream << TAG_BEGIN << ' ' << word;
+	/*  IF INSERT POINT IS AT THE END, THEN SIMPLY APPEND TAG TO STREAM  */
+	if (static_cast<std::size_t>(insert_point) == stream.size()) {
+		stream += TAG_BEGIN " ";
+		stream += word;
 	} else {
-		/*  ELSE, SAVE STREAM AFTER INSERT POINT  */
-		std::string temp(length, '\0');
-		stream.seekg(insert_point);
-		for (long j = 0; j < length; j++) {
-			char c;
-			if (!stream.get(c)) {
-				THROW_EXCEPTION(GS::EndOfBufferException, "Could not get a character from the stream.");
-			}
-			temp[j] = c;
-		}
-
-		/*  INSERT TAG; ADD TEMPORARY MATERIAL  */
-		stream.seekp(insert_point);
-		stream << TAG_BEGIN << ' ' << word << ' ' << temp;
+		/*  ELSE, INSERT TAG BEFORE THE MATERIAL AFTER INSERT POINT  */
+		stream.insert(insert_point, 1, ' ');
+		stream.insert(insert_point, word);
+		stream.insert(insert_point, TAG_BEGIN " ");
 	}
 }
 
@@ -917,7 +995,7 @@ insert_tag(std::stringstream& stream, long insert_point, const char* word)
 *
 ******************************************************************************/
 int
-expand_raw_mode(const char *buffer, long* j, long length, std::stringstream& stream)
+expand_raw_mode(const char *buffer, long* j, long length, std::string& stream)
 {
 	int k, super_raw_mode = TTS_FALSE, delimiter = TTS_FALSE, blank = TTS_TRUE;
 	char token[SYMBOL_LENGTH_MAX+1];
@@ -925,7 +1003,7 @@ expand_raw_mode(const char *buffer, long* j, long length, std::stringstream& str
 	/*  EXPAND AND CHECK RAW MODE CONTENTS TILL END OF RAW MODE  */
 	token[k = 0] = '\0';
 	for ( ; (*j < length) && (buffer[*j] != RAW_MODE_END); (*j)++) {
-		stream << buffer[*j];
+		stream += buffer[*j];
 		/*  CHECK IF ENTERING OR EXITING SUPER RAW MODE  */
 		if (buffer[*j] == '%') {
 			if (!super_raw_mode) {
@@ -954,7 +1032,7 @@ expand_raw_mode(const char *buffer, long* j, long length, std::stringstream& str
 				/*  PUT SLASH CODE INTO TOKEN BUFFER  */
 				token[0] = '/';
 				if ((++(*j) < length) && (buffer[*j] != RAW_MODE_END)) {
-					stream << buffer[*j];
+					stream += buffer[*j];
 					token[1] = buffer[*j];
 					token[2] = '\0';
 					/*  CHECK LEGALITY OF SLASH CODE  */
@@ -1032,7 +1110,7 @@ expand_raw_mode(const char *buffer, long* j, long length, std::stringstream& str
 	}
 
 	/*  PAD WITH SPACE, RESET EXTERNAL COUNTER  */
-	stream << ' ';
+	stream += ' ';
 	(*j)--;
 
 	/*  RETURN SUCCESS  */
@@ -1102,19 +1180,19 @@ illegal_slash_code(const char* code)
 *
 ******************************************************************************/
 int
-expand_tag_number(const char* buffer, long* j, long length, std::stringstream& stream)
+expand_tag_number(const char* buffer, long* j, long length, std::string& stream)
 {
 	/*  SKIP WHITE  */
 	while ((((*j)+1) < length) && (buffer[(*j)+1] == ' ')) {
 		(*j)++;
-		stream << buffer[*j];
+		stream += buffer[*j];
 	}
 
 	/*  CHECK FORMAT OF TAG NUMBER  */
 	int sign = 0;
 	while ((((*j)+1) < length) && (buffer[(*j)+1] != ' ') &&
 			(buffer[(*j)+1] != RAW_MODE_END) && (buffer[(*j)+1] != '%')) {
-		stream << buffer[++(*j)];
+		stream += buffer[++(*j)];
 		if ((buffer[*j] == '-') || (buffer[*j] == '+')) {
 			if (sign) {
 				return TTS_PARSER_FAILURE;
@@ -1411,7 +1489,7 @@ word_follows(const char* buffer, int i, int length)
 *
 ******************************************************************************/
 int
-expand_abbreviation(char* buffer, int i, int length, std::stringstream& stream)
+expand_abbreviation(char* buffer, int i, int length, std::string& stream)
 {
 	int j, k, word_length = 0;
 	char word[5];
@@ -1423,15 +1501,16 @@ expand_abbreviation(char* buffer, int i, int length, std::stringstream& stream)
 		if (isalpha(buffer[i-1])) {
 			if ((buffer[i-1] == 'p') && (((i-1) == 0) || (((i-2) >= 0) && (buffer[i-2] != '.')) ) ) {
 				/*  EXPAND p. TO page  */
-				stream.seekp(-1, std::ios_base::cur);
-				stream << "page ";
+				stream.pop_back();
+				stream += "page ";
 			} else {
 				/*  ELSE, CAPITALIZE CHARACTER IF NECESSARY, BLANK OUT PERIOD  */
-				stream.seekp(-1, std::ios_base::cur);
+				stream.pop_back();
 				if (islower(buffer[i-1])) {
 					buffer[i-1] = toupper(buffer[i-1]);
 				}
-				stream << buffer[i-1] << ' ';
+				stream += buffer[i-1];
+				stream += ' ';
 			}
 			/*  INDICATE ABBREVIATION EXPANDED  */
 			return 1;
@@ -1466,8 +1545,9 @@ expand_abbreviation(char* buffer, int i, int length, std::stringstream& stream)
 				}
 				/*  EXPAND ONLY IF NUMBER FOLLOWS  */
 				if (number_follows(buffer, i, length)) {
-					stream.seekp(-word_length, std::ios_base::cur);
-					stream << abbr_with_number[j][EXPANSION] << ' ';
+					stream.resize(stream.size() - word_length);
+					stream += abbr_with_number[j][EXPANSION];
+					stream += ' ';
 					return 1;
 				}
 			}
@@ -1476,8 +1556,9 @@ expand_abbreviation(char* buffer, int i, int length, std::stringstream& stream)
 		/*  EXPAND THESE ABBREVIATIONS UNCONDITIONALLY  */
 		for (j = 0; abbreviation[j][ABBREVIATION] != NULL; j++) {
 			if (!strcmp(abbreviation[j][ABBREVIATION],word)) {
-				stream.seekp(-word_length, std::ios_base::cur);
-				stream << abbreviation[j][EXPANSION] << ' ';
+				stream.resize(stream.size() - word_length);
+				stream += abbreviation[j][EXPANSION];
+				stream += ' ';
 				return 1;
 			}
 		}
@@ -1497,116 +1578,116 @@ expand_abbreviation(char* buffer, int i, int length, std::stringstream& stream)
 *
 ******************************************************************************/
 void
-expand_letter_mode(const char* buffer, int* i, int length, std::stringstream& stream, int* status)
+expand_letter_mode(const char* buffer, int* i, int length, std::string& stream, int* status)
 {
 	for ( ; ((*i) < length) && (buffer[*i] != LETTER_MODE_END); (*i)++) {
 		/*  CONVERT LETTER TO WORD OR WORDS  */
 		switch (buffer[*i]) {
-		case ' ': stream << "blank";                break;
-		case '!': stream << "exclamation point";    break;
-		case '"': stream << "double quote";         break;
-		case '#': stream << "number sign";          break;
-		case '$': stream << "dollar";               break;
-		case '%': stream << "percent";              break;
-		case '&': stream << "ampersand";            break;
-		case '\'':stream << "single quote";         break;
-		case '(': stream << "open parenthesis";     break;
-		case ')': stream << "close parenthesis";    break;
-		case '*': stream << "asterisk";             break;
-		case '+': stream << "plus sign";            break;
-		case ',': stream << "comma";                break;
-		case '-': stream << "hyphen";               break;
-		case '.': stream << "period";               break;
-		case '/': stream << "slash";                break;
-		case '0': stream << "zero";                 break;
-		case '1': stream << "one";                  break;
-		case '2': stream << "two";                  break;
-		case '3': stream << "three";                break;
-		case '4': stream << "four";                 break;
-		case '5': stream << "five";                 break;
-		case '6': stream << "six";                  break;
-		case '7': stream << "seven";                break;
-		case '8': stream << "eight";                break;
-		case '9': stream << "nine";                 break;
-		case ':': stream << "colon";                break;
-		case ';': stream << "semicolon";            break;
-		case '<': stream << "open angle bracket";   break;
-		case '=': stream << "equal sign";           break;
-		case '>': stream << "close angle bracket";  break;
-		case '?': stream << "question mark";        break;
-		case '@': stream << "at sign";              break;
+		case ' ': stream += "blank";                break;
+		case '!': stream += "exclamation point";    break;
+		case '"': stream += "double quote";         break;
+		case '#': stream += "number sign";          break;
+		case '$': stream += "dollar";               break;
+		case '%': stream += "percent";              break;
+		case '&': stream += "ampersand";            break;
+		case '\'':stream += "single quote";         break;
+		case '(': stream += "open parenthesis";     break;
+		case ')': stream += "close parenthesis";    break;
+		case '*': stream += "asterisk";             break;
+		case '+': stream += "plus sign";            break;
+		case ',': stream += "comma";                break;
+		case '-': stream += "hyphen";               break;
+		case '.': stream += "period";               break;
+		case '/': stream += "slash";                break;
+		case '0': stream += "zero";                 break;
+		case '1': stream += "one";                  break;
+		case '2': stream += "two";                  break;
+		case '3': stream += "three";                break;
+		case '4': stream += "four";                 break;
+		case '5': stream += "five";                 break;
+		case '6': stream += "six";                  break;
+		case '7': stream += "seven";                break;
+		case '8': stream += "eight";                break;
+		case '9': stream += "nine";                 break;
+		case ':': stream += "colon";                break;
+		case ';': stream += "semicolon";            break;
+		case '<': stream += "open angle bracket";   break;
+		case '=': stream += "equal sign";           break;
+		case '>': stream += "close angle bracket";  break;
+		case '?': stream += "question mark";        break;
+		case '@': stream += "at sign";              break;
 		case 'A':
-		case 'a': stream << 'A';                    break;
+		case 'a': stream += 'A';                    break;
 		case 'B':
-		case 'b': stream << 'B';                    break;
+		case 'b': stream += 'B';                    break;
 		case 'C':
-		case 'c': stream << 'C';                    break;
+		case 'c': stream += 'C';                    break;
 		case 'D':
-		case 'd': stream << 'D';                    break;
+		case 'd': stream += 'D';                    break;
 		case 'E':
-		case 'e': stream << 'E';                    break;
+		case 'e': stream += 'E';                    break;
 		case 'F':
-		case 'f': stream << 'F';                    break;
+		case 'f': stream += 'F';                    break;
 		case 'G':
-		case 'g': stream << 'G';                    break;
+		case 'g': stream += 'G';                    break;
 		case 'H':
-		case 'h': stream << 'H';                    break;
+		case 'h': stream += 'H';                    break;
 		case 'I':
-		case 'i': stream << 'I';                    break;
+		case 'i': stream += 'I';                    break;
 		case 'J':
-		case 'j': stream << 'J';                    break;
+		case 'j': stream += 'J';                    break;
 		case 'K':
-		case 'k': stream << 'K';                    break;
+		case 'k': stream += 'K';                    break;
 		case 'L':
-		case 'l': stream << 'L';                    break;
+		case 'l': stream += 'L';                    break;
 		case 'M':
-		case 'm': stream << 'M';                    break;
+		case 'm': stream += 'M';                    break;
 		case 'N':
-		case 'n': stream << 'N';                    break;
+		case 'n': stream += 'N';                    break;
 		case 'O':
-		case 'o': stream << 'O';                    break;
+		case 'o': stream += 'O';                    break;
 		case 'P':
-		case 'p': stream << 'P';                    break;
+		case 'p': stream += 'P';                    break;
 		case 'Q':
-		case 'q': stream << 'Q';                    break;
+		case 'q': stream += 'Q';                    break;
 		case 'R':
-		case 'r': stream << 'R';                    break;
+		case 'r': stream += 'R';                    break;
 		case 'S':
-		case 's': stream << 'S';                    break;
+		case 's': stream += 'S';                    break;
 		case 'T':
-		case 't': stream << 'T';                    break;
+		case 't': stream += 'T';                    break;
 		case 'U':
-		case 'u': stream << 'U';                    break;
+		case 'u': stream += 'U';                    break;
 		case 'V':
-		case 'v': stream << 'V';                    break;
+		case 'v': stream += 'V';                    break;
 		case 'W':
-		case 'w': stream << 'W';                    break;
+		case 'w': stream += 'W';                    break;
 		case 'X':
-		case 'x': stream << 'X';                    break;
+		case 'x': stream += 'X';                    break;
 		case 'Y':
-		case 'y': stream << 'Y';                    break;
+		case 'y': stream += 'Y';                    break;
 		case 'Z':
-		case 'z': stream << 'Z';                    break;
-		case '[': stream << "open square bracket";  break;
-		case '\\':stream << "back slash";           break;
-		case ']': stream << "close square bracket"; break;
-		case '^': stream << "caret";                break;
-		case '_': stream << "under score";          break;
-		case '`': stream << "grave accent";         break;
-		case '{': stream << "open brace";           break;
-		case '|': stream << "vertical bar";         break;
-		case '}': stream << "close brace";          break;
-		case '~': stream << "tilde";                break;
-		default:  stream << "unknown";              break;
+		case 'z': stream += 'Z';                    break;
+		case '[': stream += "open square bracket";  break;
+		case '\\':stream += "back slash";           break;
+		case ']': stream += "close square bracket"; break;
+		case '^': stream += "caret";                break;
+		case '_': stream += "under score";          break;
+		case '`': stream += "grave accent";         break;
+		case '{': stream += "open brace";           break;
+		case '|': stream += "vertical bar";         break;
+		case '}': stream += "close brace";          break;
+		case '~': stream += "tilde";                break;
+		default:  stream += "unknown";              break;
 		}
 		/*  APPEND COMMA, UNLESS PUNCTUATION FOLLOWS LAST LETTER  */
 		if ( (((*i)+1) < length) &&
 				(buffer[(*i)+1] == LETTER_MODE_END) &&
 				!word_follows(buffer, (*i), length)) {
-			stream << ' ';
+			stream += ' ';
 			*status = WORD;
 		} else {
-			stream << ", ";
+			stream += ", ";
 			*status = PUNCTUATION;
 		}
 	}
@@ -1754,24 +1835,24 @@ is_possessive(char* word)
 *
 ******************************************************************************/
 void
-safety_check(std::stringstream& stream, long* stream_length)
+safety_check(std::string& stream, long* stream_length, std::string& work)
 {
 	int number_of_feet = 0, number_of_phones = 0, state = NON_PHONEME;
 	long last_word_pos = UNDEFINED_POSITION, last_tg_pos = UNDEFINED_POSITION;
 	char last_tg_type = '0';
 	char c;
 
-	/*  REWIND STREAM TO BEGINNING  */
-	stream.seekg(0);
+	/*  THE MARKERS ARE INSERTED IN A COPY OF THE STREAM  */
+	ChunkBuffer buffer(stream, work);
 
 	/*  LOOP THROUGH STREAM, INSERTING NEW CHUNK MARKERS IF NECESSARY  */
-	while (stream.get(c) && c != '\0') {
+	while (buffer.get(c) && c != '\0') {
 		switch (c) {
 		case '%':
 			/*  IGNORE SUPER RAW MODE CONTENTS  */
-			while (stream.get(c) && c != '%') {
+			while (buffer.get(c) && c != '%') {
 				if (c == '\0') {
-					stream.unget();
+					buffer.unget();
 					break;
 				}
 			}
@@ -1779,7 +1860,7 @@ safety_check(std::stringstream& stream, long* stream_length)
 			break;
 		case '/':
 			/*  SLASH CODES  */
-			if (!stream.get(c)) {
+			if (!buffer.get(c)) {
 				THROW_EXCEPTION(GS::EndOfBufferException, "Could not get a character from the stream.");
 			}
 			switch (c) {
@@ -1792,21 +1873,23 @@ safety_check(std::stringstream& stream, long* stream_length)
 				/*  FOOT AND TONIC FOOT MARKERS  */
 				if (++number_of_feet > MAX_FEET_PER_CHUNK) {
 					/*  SPLIT STREAM INTO TWO CHUNKS  */
-					insert_chunk_marker(stream, last_word_pos, last_tg_type);
-					set_tone_group(stream, last_tg_pos, ",");
-					check_tonic(stream, last_tg_pos, last_word_pos);
+					insert_chunk_marker(buffer, last_word_pos, last_tg_type);
+					if (last_tg_pos != UNDEFINED_POSITION) {
+						buffer.write(last_tg_pos, TG_CONTINUATION);
+					}
+					check_tonic(buffer, last_tg_pos, last_word_pos);
 				}
 				break;
 			case 't':
 				/*  IGNORE TAGGING MODE CONTENTS  */
 				/*  SKIP WHITE  */
-				while (stream.get(c) && c == ' ')
+				while (buffer.get(c) && c == ' ')
 					;
-				stream.unget();
+				buffer.unget();
 				/*  SKIP OVER TAG NUMBER  */
-				while (stream.get(c) && c != ' ') {
+				while (buffer.get(c) && c != ' ') {
 					if (c == '\0') {
-						stream.unget();
+						buffer.unget();
 						break;
 					}
 				}
@@ -1818,7 +1901,7 @@ safety_check(std::stringstream& stream, long* stream_length)
 			case '4':
 				/*  REMEMBER TONE GROUP TYPE AND POSITION  */
 				last_tg_type = c;
-				last_tg_pos = static_cast<long>(stream.tellg()) - 2;
+				last_tg_pos = buffer.tell() - 2;
 				break;
 			default:
 				/*  IGNORE ALL OTHER SLASH CODES  */
@@ -1833,14 +1916,16 @@ safety_check(std::stringstream& stream, long* stream_length)
 			if (state == PHONEME) {
 				if (++number_of_phones > MAX_PHONES_PER_CHUNK) {
 					/*  SPLIT STREAM INTO TWO CHUNKS  */
-					insert_chunk_marker(stream, last_word_pos, last_tg_type);
-					set_tone_group(stream, last_tg_pos, ",");
-					check_tonic(stream, last_tg_pos, last_word_pos);
+					insert_chunk_marker(buffer, last_word_pos, last_tg_type);
+					if (last_tg_pos != UNDEFINED_POSITION) {
+						buffer.write(last_tg_pos, TG_CONTINUATION);
+					}
+					check_tonic(buffer, last_tg_pos, last_word_pos);
 					state = NON_PHONEME;
 					break;
 				}
 				if (c == ' ') {
-					last_word_pos = static_cast<long>(stream.tellg());
+					last_word_pos = buffer.tell();
 				}
 			}
 			state = NON_PHONEME;
@@ -1852,7 +1937,8 @@ safety_check(std::stringstream& stream, long* stream_length)
 	}
 
 	/*  BE SURE TO RESET LENGTH OF STREAM  */
-	*stream_length = static_cast<long>(stream.tellg());
+	*stream_length = buffer.tell();
+	buffer.release(stream);
 }
 
 /******************************************************************************
@@ -1865,33 +1951,15 @@ safety_check(std::stringstream& stream, long* stream_length)
 *
 ******************************************************************************/
 void
-insert_chunk_marker(std::stringstream& stream, long insert_point, char tg_type)
+insert_chunk_marker(ChunkBuffer& buffer, long insert_point, char tg_type)
 {
-	char c;
-	std::stringstream temp_stream;
-
-	/*  COPY STREAM FROM INSERT POINT TO END TO BUFFER TO ANOTHER STREAM  */
-	stream.seekg(insert_point);
-	while (stream.get(c) && c != '\0') {
-		temp_stream << c;
-	}
-	temp_stream << '\0';
+	/*  FAIL IF THERE IS NO INSERT POINT  */
+	buffer.seek(insert_point);
 
 	/*  PUT IN MARKERS AT INSERT POINT  */
-	stream.seekp(insert_point);
-	stream << TONE_GROUP_BOUNDARY << ' ' << CHUNK_BOUNDARY << ' '
-		<< TONE_GROUP_BOUNDARY << " /" << tg_type << ' ';
-	long new_position = static_cast<long>(stream.tellp()) - 9; //TODO: check
-
-	/*  APPEND CONTENTS OF TEMPORARY STREAM  */
-	temp_stream.seekg(0);
-	while (temp_stream.get(c) && c != '\0') {
-		stream << c;
-	}
-	stream << '\0';
-
-	/*  POSITION THE STREAM AT THE NEW /c MARKER  */
-	stream.seekp(new_position);
+	char markers[] = TONE_GROUP_BOUNDARY " " CHUNK_BOUNDARY " " TONE_GROUP_BOUNDARY " /0 ";
+	markers[sizeof markers - 3] = tg_type;
+	buffer.insert(insert_point, markers);
 }
 
 /******************************************************************************
@@ -1901,37 +1969,36 @@ insert_chunk_marker(std::stringstream& stream, long insert_point, char tg_type)
 *       purpose:        Checks to see if a tonic marker is present in the
 *                       stream between the start and end positions.  If no
 *                       tonic is present, then put one in at the last foot
-*                       marker if it exists.
+*                       marker if it exists.  Reading continues after the
+*                       tonic marker or at the end position.
 *
 ******************************************************************************/
 void
-check_tonic(std::stringstream& stream, long start_pos, long end_pos)
+check_tonic(ChunkBuffer& buffer, long start_pos, long end_pos)
 {
 	long i, last_foot_pos = UNDEFINED_POSITION;
 
-	/*  REMEMBER CURRENT POSITION IN STREAM  */
-	long temp_pos = static_cast<long>(stream.tellp());
-
 	/*  CALCULATE EXTENT OF STREAM TO LOOP THROUGH  */
 	long extent = end_pos - start_pos;
 
-	/*  REWIND STREAM TO START POSITION  */
-	stream.seekg(start_pos);
+	/*  REWIND STREAM TO START POSITION;  IF THE TONE GROUP BEGINS AFTER THE
+	    END POSITION, GO TO THE END POSITION, SO THAT THE NEW CHUNK MARKER IS
+	    READ AGAIN (OTHERWISE THE CHUNK WOULD BE SPLIT FOREVER)  */
+	buffer.seek(extent > 0 ? start_pos : end_pos);
 
 	/*  LOOP THROUGH STREAM, DETERMINING LAST FOOT POSITION, AND PRESENCE OF TONIC  */
 	char c;
-	for (i = 0; i < extent; i++) {
-		if (stream.get(c) && c == '/' && ++i < extent) {
-			if (!stream.get(c)) {
+	for (i = 0; i < extent && buffer.good(); i++) {
+		if (buffer.get(c) && c == '/' && ++i < extent) {
+			if (!buffer.get(c)) {
 				THROW_EXCEPTION(GS::EndOfBufferException, "Could not get a character from the stream.");
 			}
 			switch (c) {
 			case '_':
-				last_foot_pos = static_cast<long>(stream.tellg()) - 1;
+				last_foot_pos = buffer.tell() - 1;
 				break;
 			case '*':
-				/*  GO TO ORIGINAL POSITION ON STREAM, AND RETURN IMMEDIATELY  */
-				//NXSeek(stream, temp_pos, NX_FROMSTART);
+				/*  TONIC FOUND, RETURN IMMEDIATELY  */
 				return;
 			}
 		}
@@ -1939,12 +2006,8 @@ check_tonic(std::stringstream& stream, long start_pos, long end_pos)
 
 	/*  IF HERE, NO TONIC, SO INSERT TONIC MARKER  */
 	if (last_foot_pos != UNDEFINED_POSITION) {
-		stream.seekp(last_foot_pos);
-		stream << '*';
+		buffer.write(last_foot_pos, "*");
 	}
-
-	/*  GO TO ORIGINAL POSITION ON STREAM  */
-	stream.seekp(temp_pos);
 }
 
 } /* namespace */
@@ -1954,11 +2017,21 @@ check_tonic(std::stringstream& stream, long start_pos, long end_pos)
 namespace GS {
 namespace En {
 
+TextParser::Context::Context()
+{
+	dictionaryBuffer_.fill('\0');
+}
+
+TextParser::Context::~Context()
+{
+}
+
 TextParser::TextParser(const char* configDirPath,
 			const std::string& dictionary1Path,
 			const std::string& dictionary2Path,
 			const std::string& dictionary3Path)
 		: escape_character_(DEFAULT_ESCAPE_CHARACTER)
+		, pronunciationCache_(std::make_shared<PronunciationCache>())
 {
 	if (dictionary1Path != "none") {
 		dict1_.reset(new DictionarySearch);
@@ -1993,16 +2066,96 @@ TextParser::~TextParser()
 
 /******************************************************************************
 *
-*       function:       init_parser_module
+*       function:       setPronunciationCache
+*
+*       purpose:        Replaces the pronunciation cache.  The cache must
+*                       not contain pronunciations from other dictionaries.
+*
+******************************************************************************/
+void
+TextParser::setPronunciationCache(std::shared_ptr<PronunciationCache> cache)
+{
+	if (!cache) {
+		THROW_EXCEPTION(InvalidParameterException, "Null pronunciation cache.");
+	}
+	pronunciationCache_ = std::move(cache);
+}
+
+/******************************************************************************
+*
+*       function:       pronunciation_cache_signature
+*
+*       purpose:        Returns a string that identifies the dictionaries,
+*                       the dictionary order and the program version.
+*
+******************************************************************************/
+std::string
+TextParser::pronunciation_cache_signature() const
+{
+	std::ostringstream out;
+	out << PROGRAM_VERSION;
+	for (int i = 0; i < DICTIONARY_ORDER_SIZE; i++) {
+		out << ' ' << dictionaryOrder_[i];
+	}
+	for (const DictionarySearch* dict : {dict1_.get(), dict2_.get(), dict3_.get()}) {
+		if (dict) {
+			out << " [" << dict->version() << "] " << dict->size();
+		} else {
+			out << " none";
+		}
+	}
+	return out.str();
+}
+
+/******************************************************************************
+*
+*       function:       loadPronunciationCache
+*
+*       purpose:        Adds the entries of a file saved by
+*                       savePronunciationCache to the pronunciation cache.
+*
+******************************************************************************/
+bool
+TextParser::loadPronunciationCache(const std::string& filePath)
+{
+	return pronunciationCache_->load(filePath, pronunciation_cache_signature());
+}
+
+/******************************************************************************
+*
+*       function:       savePronunciationCache
+*
+*       purpose:        Saves the pronunciation cache to a file.
+*
+******************************************************************************/
+void
+TextParser::savePronunciationCache(const std::string& filePath) const
+{
+	pronunciationCache_->save(filePath, pronunciation_cache_signature());
+}
+
+/******************************************************************************
+*
+*       function:       printPronunciationCacheStatistics
 *
-*       purpose:        Sets up parser module for subsequent use.  This must
-*                       be called before parser() is ever used.
+*       purpose:        Prints the hits of the pronunciation cache, by source.
+*                       The statistics accumulate over all the parsed texts.
 *
 ******************************************************************************/
 void
-TextParser::init_parser_module()
+TextParser::printPronunciationCacheStatistics() const
 {
-	auxStream_.str("");
+	static const char* const sourceNames[] = {
+		nullptr, "number parser", "dictionary 1", "dictionary 2", "dictionary 3", "letter-to-sound"
+	};
+	const PronunciationCache::Statistics stat = pronunciationCache_->statistics();
+	const unsigned long long hits = stat.totalHits();
+	printf("Pronunciation cache: size=%u lookups=%llu hits=%llu (%.1f%%) evictions=%llu\n",
+		pronunciationCache_->size(), stat.lookups, hits,
+		stat.lookups > 0 ? 100.0 * hits / stat.lookups : 0.0, stat.evictions);
+	for (int i = TTS_NUMBER_PARSER; i <= TTS_LETTER_TO_SOUND; i++) {
+		printf("  %s hits=%llu\n", sourceNames[i], stat.hits[i]);
+	}
 }
 
 /******************************************************************************
@@ -2038,20 +2191,31 @@ TextParser::set_escape_code(char new_escape_code)
 *
 ******************************************************************************/
 std::string
-TextParser::parseText(const char* text)
+TextParser::parseText(const char* text) const
+{
+	Context context;
+	return parseText(text, context);
+}
+
+const std::string&
+TextParser::parseText(const char* text, Context& context) const
 {
 	int error;
 	int input_length, buffer1_length, buffer2_length;
 	long stream1_length, auxStream_length;
+	std::vector<char>& buffer1 = context.buffer1_;
+	std::vector<char>& buffer2 = context.buffer2_;
+	std::string& stream1 = context.stream1_;
+	std::string& auxStream = context.auxStream_;
 
-	auxStream_.str("");
+	auxStream.clear();
 
 	/*  FIND LENGTH OF INPUT  */
 	input_length = strlen(text);
 
-	/*  ALLOCATE BUFFER1, BUFFER2  */
-	std::vector<char> buffer1(input_length + 1);
-	std::vector<char> buffer2(input_length + 1);
+	/*  CLEAR BUFFER1, BUFFER2  */
+	buffer1.assign(input_length + 1, '\0');
+	buffer2.assign(input_length + 1, '\0');
 
 	if (Log::debugEnabled) {
 		printf("text=%s\n", text);
@@ -2075,7 +2239,7 @@ TextParser::parseText(const char* text)
 		printf("buffer2=%s\n", &buffer2[0]);
 	}
 
-	std::stringstream stream1;
+	stream1.clear();
 
 	/*  STRIP OUT OR CONVERT UNESSENTIAL PUNCTUATION  */
 	strip_punctuation(&buffer2[0], buffer2_length, stream1, &stream1_length);
@@ -2087,27 +2251,56 @@ TextParser::parseText(const char* text)
 	}
 
 	// Clear the auxiliary stream.
-	auxStream_.str("");
+	auxStream.clear();
 
 	/*  DO FINAL CONVERSION  */
-	if ((error = final_conversion(stream1, stream1_length, auxStream_, &auxStream_length))
+	if ((error = final_conversion(stream1, stream1_length, auxStream, &auxStream_length, context))
 			!= TTS_PARSER_SUCCESS) {
 		THROW_EXCEPTION(TextParserException, "Error in final_conversion();");
 	}
 
 	/*  DO SAFETY CHECK;  MAKE SURE NOT TOO MANY FEET OR PHONES PER CHUNK  */
-	safety_check(auxStream_, &auxStream_length);
+	safety_check(auxStream, &auxStream_length, context.workStream_);
 
 	if (Log::debugEnabled) {
 		/*  PRINT OUT STREAM 2  */
 		printf("STREAM 2\n");
-		print_stream(auxStream_, auxStream_length);
+		print_stream(auxStream, auxStream_length);
+	}
+
+	auxStream.pop_back(); // the last character is '\0'
+	return auxStream;
+}
+
+const std::string&
+TextParser::parseText(const char* text, Context& context, PhoneticTokenList& tokenList) const
+{
+	if (!tokenizer_) {
+		THROW_EXCEPTION(InvalidStateException, "The model of the text parser has not been set.");
 	}
 
-	/*  SET OUTPUT POINTER TO MEMORY STREAM BUFFER
-	    THIS STREAM PERSISTS BETWEEN CALLS  */
-	std::string phoneticString = auxStream_.str();
-	return phoneticString.substr(0, phoneticString.size() - 1); // the last character is '\0'
+	const std::string& phoneticString = parseText(text, context);
+
+	/*  CONVERT THE FINAL STREAM TO TOKENS. THE TOKENS CANNOT BE EMITTED
+	    BY final_conversion, BECAUSE safety_check INSERTS CHUNK MARKERS
+	    AND REWRITES THE TONE GROUPS BEHIND ITS READ POSITION  */
+	tokenizer_->tokenize(phoneticString.c_str(), tokenList);
+
+	return phoneticString;
+}
+
+/******************************************************************************
+*
+*       function:       setModel
+*
+*       purpose:        Creates the tokenizer of the final stream, which
+*                       finds the postures of the tokens in the model.
+*
+******************************************************************************/
+void
+TextParser::setModel(const TRMControlModel::Model& model)
+{
+	tokenizer_.reset(new PhoneticStringTokenizer(model));
 }
 
 /******************************************************************************
@@ -2115,17 +2308,39 @@ TextParser::parseText(const char* text)
 *       function:       lookup_word
 *
 *       purpose:        Returns the pronunciation of word, and sets dict to
-*                       the dictionary in which it was found.  Relies on the
-*                       global dictionaryOrder.
+*                       the dictionary in which it was found.  Looks in the
+*                       pronunciation cache before searching the
+*                       dictionaries.
 *
 ******************************************************************************/
 const char*
-TextParser::lookup_word(const char* word, short* dict)
+TextParser::lookup_word(const char* word, short* dict, Context& context) const
 {
 	if (Log::debugEnabled) {
 		printf("lookup_word word: %s\n", word);
 	}
 
+	if (pronunciationCache_->find(word, context.cachedPronunciation_, *dict)) {
+		return context.cachedPronunciation_.c_str();
+	}
+
+	const char* pronunciation = search_dictionaries(word, dict, context);
+	pronunciationCache_->insert(word, pronunciation, *dict);
+	return pronunciation;
+}
+
+/******************************************************************************
+*
+*       function:       search_dictionaries
+*
+*       purpose:        Returns the pronunciation of word, and sets dict to
+*                       the dictionary in which it was found.  Relies on the
+*                       global dictionaryOrder.
+*
+******************************************************************************/
+const char*
+TextParser::search_dictionaries(const char* word, short* dict, Context& context) const
+{
 	/*  SEARCH DICTIONARIES IN USER ORDER TILL PRONUNCIATION FOUND  */
 	for (int i = 0; i < DICTIONARY_ORDER_SIZE; i++) {
 		switch(dictionaryOrder_[i]) {
@@ -2133,7 +2348,7 @@ TextParser::lookup_word(const char* word, short* dict)
 			break;
 		case TTS_NUMBER_PARSER:
 			{
-				const char* pron = numberParser_.parseNumber(word, NumberParser::NORMAL);
+				const char* pron = context.numberParser_.parseNumber(word, NumberParser::NORMAL);
 				if (pron != nullptr) {
 					*dict = TTS_NUMBER_PARSER;
 					return pron;
@@ -2142,7 +2357,7 @@ TextParser::lookup_word(const char* word, short* dict)
 			break;
 		case TTS_DICTIONARY_1:
 			if (dict1_) {
-				const char* entry = dict1_->getEntry(word);
+				const char* entry = dict1_->getEntry(word, context.dictionaryBuffer_);
 				if (entry != nullptr) {
 					*dict = TTS_DICTIONARY_1;
 					return entry;
@@ -2151,7 +2366,7 @@ TextParser::lookup_word(const char* word, short* dict)
 			break;
 		case TTS_DICTIONARY_2:
 			if (dict2_) {
-				const char* entry = dict2_->getEntry(word);
+				const char* entry = dict2_->getEntry(word, context.dictionaryBuffer_);
 				if (entry != nullptr) {
 					*dict = TTS_DICTIONARY_2;
 					return entry;
@@ -2160,7 +2375,7 @@ TextParser::lookup_word(const char* word, short* dict)
 			break;
 		case TTS_DICTIONARY_3:
 			if (dict3_) {
-				const char* entry = dict3_->getEntry(word);
+				const char* entry = dict3_->getEntry(word, context.dictionaryBuffer_);
 				if (entry != nullptr) {
 					*dict = TTS_DICTIONARY_3;
 					return entry;
@@ -2174,13 +2389,13 @@ TextParser::lookup_word(const char* word, short* dict)
 
 	/*  IF HERE, THEN FIND WORD IN LETTER-TO-SOUND RULEBASE  */
 	/*  THIS IS GUARANTEED TO FIND A PRONUNCIATION OF SOME SORT  */
-	letter_to_sound(word, pronunciation_);
-	if (!pronunciation_.empty()) {
+	context.letterToSound_.getPronunciation(word, context.pronunciation_);
+	if (!context.pronunciation_.empty()) {
 		*dict = TTS_LETTER_TO_SOUND;
-		return &pronunciation_[0];
+		return &context.pronunciation_[0];
 	} else {
 		*dict = TTS_LETTER_TO_SOUND;
-		return numberParser_.degenerateString(word);
+		return context.numberParser_.degenerateString(word);
 	}
 }
 
@@ -2194,7 +2409,7 @@ TextParser::lookup_word(const char* word, short* dict)
 *
 ******************************************************************************/
 void
-TextParser::condition_input(const char* input, char* output, int length, int* output_length)
+TextParser::condition_input(const char* input, char* output, int length, int* output_length) const
 {
 	int i, j = 0;
 
@@ -2244,7 +2459,7 @@ TextParser::condition_input(const char* input, char* output, int length, int* ou
 *
 ******************************************************************************/
 int
-TextParser::mark_modes(const char* input, char* output, int length, int* output_length)
+TextParser::mark_modes(const char* input, char* output, int length, int* output_length) const
 {
 	int i, j = 0, pos, minus, period;
 	int mode_stack[MODE_NEST_MAX], stack_ptr = 0, mode;
@@ -2493,8 +2708,8 @@ TextParser::mark_modes(const char* input, char* output, int length, int* output_
 *
 ******************************************************************************/
 int
-TextParser::final_conversion(std::stringstream& stream1, long stream1_length,
-				std::stringstream& stream2, long* stream2_length)
+TextParser::final_conversion(const std::string& stream1, long stream1_length,
+				std::string& stream2, long* stream2_length, Context& context) const
 {
 	long i, last_word_end = UNDEFINED_POSITION, tg_marker_pos = UNDEFINED_POSITION;
 	int mode = NORMAL_MODE, next_mode = 0, prior_tonic = TTS_FALSE, raw_mode_flag = TTS_FALSE;
@@ -2503,11 +2718,10 @@ TextParser::final_conversion(std::stringstream& stream1, long stream1_length,
 	//int length, max_length;
 
 	/*  REWIND STREAM2 BACK TO BEGINNING  */
-	stream2.str("");
+	stream2.clear();
 
 	/*  GET MEMORY BUFFER ASSOCIATED WITH STREAM1  */
-	std::string stream1String = stream1.str();
-	const char* input = stream1String.data();
+	const char* input = stream1.data();
 
 	/*  MAIN LOOP  */
 	for (i = 0; i < stream1_length; i++) {
@@ -2545,36 +2759,36 @@ TextParser::final_conversion(std::stringstream& stream1, long stream1_length,
 				/*  ADD BEGINNING MARKERS IF NECESSARY (SWITCH FALL-THRU DESIRED)  */
 				switch(last_written_state) {
 				case STATE_BEGIN:
-					stream2 << CHUNK_BOUNDARY << ' ';
+					stream2 += CHUNK_BOUNDARY " ";
 					[[fallthrough]];
 				case STATE_FINAL_PUNC:
-					stream2 << TONE_GROUP_BOUNDARY << ' ';
+					stream2 += TONE_GROUP_BOUNDARY " ";
 					prior_tonic = TTS_FALSE;
 					[[fallthrough]];
 				case STATE_MEDIAL_PUNC:
-					stream2 << TG_UNDEFINED << ' ';
-					tg_marker_pos = static_cast<long>(stream2.tellp()) - 3;
+					stream2 += TG_UNDEFINED " ";
+					tg_marker_pos = static_cast<long>(stream2.size()) - 3;
 					[[fallthrough]];
 				case STATE_SILENCE:
-					stream2 << UTTERANCE_BOUNDARY << ' ';
+					stream2 += UTTERANCE_BOUNDARY " ";
 				}
 
 				if (mode == NORMAL_MODE) {
 					/*  PUT IN WORD MARKER  */
-					stream2 << WORD_BEGIN << ' ';
+					stream2 += WORD_BEGIN " ";
 					/*  ADD LAST WORD MARKER AND TONICIZATION IF NECESSARY  */
 					switch(next_state) {
 					case STATE_MEDIAL_PUNC:
 					case STATE_FINAL_PUNC:
 					case STATE_END:
 						/*  PUT IN LAST WORD MARKER  */
-						stream2 << LAST_WORD << ' ';
+						stream2 += LAST_WORD " ";
 						/*  WRITE WORD TO STREAM WITH TONIC IF NO PRIOR TONICIZATION  */
-						expand_word(word, (!prior_tonic), stream2);
+						expand_word(word, (!prior_tonic), stream2, context);
 						break;
 					default:
 						/*  WRITE WORD TO STREAM WITHOUT TONIC  */
-						expand_word(word, TTS_NO, stream2);
+						expand_word(word, TTS_NO, stream2, context);
 						break;
 					}
 				} else if (mode == EMPHASIS_MODE) {
@@ -2583,26 +2797,26 @@ TextParser::final_conversion(std::stringstream& stream1, long stream1_length,
 						if (set_tone_group(stream2, tg_marker_pos, ",") == TTS_PARSER_FAILURE) {
 							return TTS_PARSER_FAILURE;
 						}
-						stream2 << TONE_GROUP_BOUNDARY << ' ' << TG_UNDEFINED << ' ';
-						tg_marker_pos = static_cast<long>(stream2.tellp()) - 3;
+						stream2 += TONE_GROUP_BOUNDARY " " TG_UNDEFINED " ";
+						tg_marker_pos = static_cast<long>(stream2.size()) - 3;
 					}
 					/*  PUT IN WORD MARKER  */
-					stream2 << WORD_BEGIN << ' ';
+					stream2 += WORD_BEGIN " ";
 					/*  MARK LAST WORD OF TONE GROUP, IF NECESSARY  */
 					if ((next_state == STATE_MEDIAL_PUNC) ||
 							(next_state == STATE_FINAL_PUNC) ||
 							(next_state == STATE_END) ||
 							((next_state == STATE_WORD) && (next_mode == EMPHASIS_MODE)) ) {
-						stream2 << LAST_WORD << ' ';
+						stream2 += LAST_WORD " ";
 					}
 					/*  TONICIZE WORD  */
-					expand_word(word, TTS_YES, stream2);
+					expand_word(word, TTS_YES, stream2, context);
 					prior_tonic = TTS_TRUE;
 				}
 
 				/*  SET LAST WRITTEN STATE, AND END POSITION AFTER THE WORD  */
 				last_written_state = STATE_WORD;
-				last_word_end = static_cast<long>(stream2.tellp());
+				last_word_end = static_cast<long>(stream2.size());
 				break;
 
 			case STATE_MEDIAL_PUNC:
@@ -2610,20 +2824,20 @@ TextParser::final_conversion(std::stringstream& stream1, long stream1_length,
 				switch(last_written_state) {
 				case STATE_WORD:
 					if (shift_silence(input, i, stream1_length, mode, stream2)) {
-						last_word_end = static_cast<long>(stream2.tellp());
+						last_word_end = static_cast<long>(stream2.size());
 					} else if ((next_state != STATE_END) &&
 							another_word_follows(input, i, stream1_length, mode)) {
 						if (!strcmp(word,",")) {
-							stream2 << UTTERANCE_BOUNDARY << ' ' << MEDIAL_PAUSE << ' ';
+							stream2 += UTTERANCE_BOUNDARY " " MEDIAL_PAUSE " ";
 						} else {
-							stream2 << UTTERANCE_BOUNDARY << ' ' << LONG_MEDIAL_PAUSE << ' ';
+							stream2 += UTTERANCE_BOUNDARY " " LONG_MEDIAL_PAUSE " ";
 						}
 					} else if (next_state == STATE_END) {
-						stream2 << UTTERANCE_BOUNDARY << ' ';
+						stream2 += UTTERANCE_BOUNDARY " ";
 					}
 					[[fallthrough]];
 				case STATE_SILENCE:
-					stream2 << TONE_GROUP_BOUNDARY << ' ';
+					stream2 += TONE_GROUP_BOUNDARY " ";
 					prior_tonic = TTS_FALSE;
 					if (set_tone_group(stream2, tg_marker_pos, word) == TTS_PARSER_FAILURE) {
 						return TTS_PARSER_FAILURE;
@@ -2636,8 +2850,8 @@ TextParser::final_conversion(std::stringstream& stream1, long stream1_length,
 			case STATE_FINAL_PUNC:
 				if (last_written_state == STATE_WORD) {
 					if (shift_silence(input, i, stream1_length, mode, stream2)) {
-						last_word_end = static_cast<long>(stream2.tellp());
-						stream2 << TONE_GROUP_BOUNDARY << ' ';
+						last_word_end = static_cast<long>(stream2.size());
+						stream2 += TONE_GROUP_BOUNDARY " ";
 						prior_tonic = TTS_FALSE;
 						if (set_tone_group(stream2, tg_marker_pos, word) == TTS_PARSER_FAILURE) {
 							return TTS_PARSER_FAILURE;
@@ -2646,8 +2860,7 @@ TextParser::final_conversion(std::stringstream& stream1, long stream1_length,
 						/*  IF SILENCE INSERTED, THEN CONVERT FINAL PUNCTUATION TO MEDIAL  */
 						last_written_state = STATE_MEDIAL_PUNC;
 					} else {
-						stream2 << UTTERANCE_BOUNDARY << ' '
-							<< TONE_GROUP_BOUNDARY << ' ' << CHUNK_BOUNDARY << ' ';
+						stream2 += UTTERANCE_BOUNDARY " " TONE_GROUP_BOUNDARY " " CHUNK_BOUNDARY " ";
 						prior_tonic = TTS_FALSE;
 						if (set_tone_group(stream2, tg_marker_pos, word) == TTS_PARSER_FAILURE) {
 							return TTS_PARSER_FAILURE;
@@ -2656,7 +2869,7 @@ TextParser::final_conversion(std::stringstream& stream1, long stream1_length,
 						last_written_state = STATE_FINAL_PUNC;
 					}
 				} else if (last_written_state == STATE_SILENCE) {
-					stream2 << TONE_GROUP_BOUNDARY << ' ';
+					stream2 += TONE_GROUP_BOUNDARY " ";
 					prior_tonic = TTS_FALSE;
 					if (set_tone_group(stream2, tg_marker_pos, word) == TTS_PARSER_FAILURE) {
 						return TTS_PARSER_FAILURE;
@@ -2669,18 +2882,18 @@ TextParser::final_conversion(std::stringstream& stream1, long stream1_length,
 
 			case STATE_SILENCE:
 				if (last_written_state == STATE_BEGIN) {
-					stream2 << CHUNK_BOUNDARY << ' ' << TONE_GROUP_BOUNDARY << ' ' << TG_UNDEFINED << ' ';
+					stream2 += CHUNK_BOUNDARY " " TONE_GROUP_BOUNDARY " " TG_UNDEFINED " ";
 					prior_tonic = TTS_FALSE;
-					tg_marker_pos = static_cast<long>(stream2.tellp()) - 3;
+					tg_marker_pos = static_cast<long>(stream2.size()) - 3;
 					if ((convert_silence(word, stream2) <= 0.0) && (next_state == STATE_END)) {
 						return TTS_PARSER_FAILURE;
 					}
 					last_written_state = STATE_SILENCE;
-					last_word_end = static_cast<long>(stream2.tellp());
+					last_word_end = static_cast<long>(stream2.size());
 				} else if (last_written_state == STATE_WORD) {
 					convert_silence(word, stream2);
 					last_written_state = STATE_SILENCE;
-					last_word_end = static_cast<long>(stream2.tellp());
+					last_word_end = static_cast<long>(stream2.size());
 				}
 				break;
 
@@ -2700,14 +2913,14 @@ TextParser::final_conversion(std::stringstream& stream1, long stream1_length,
 	switch (last_written_state) {
 
 	case STATE_MEDIAL_PUNC:
-		stream2 << CHUNK_BOUNDARY;
+		stream2 += CHUNK_BOUNDARY;
 		break;
 
 	case STATE_WORD:
-		stream2 << UTTERANCE_BOUNDARY << ' ';
+		stream2 += UTTERANCE_BOUNDARY " ";
 		[[fallthrough]];
 	case STATE_SILENCE:
-		stream2 << TONE_GROUP_BOUNDARY << ' ' << CHUNK_BOUNDARY;
+		stream2 += TONE_GROUP_BOUNDARY " " CHUNK_BOUNDARY;
 		prior_tonic = TTS_FALSE;
 		if (set_tone_group(stream2, tg_marker_pos, DEFAULT_END_PUNC) == TTS_PARSER_FAILURE) {
 			return TTS_PARSER_FAILURE;
@@ -2722,10 +2935,10 @@ TextParser::final_conversion(std::stringstream& stream1, long stream1_length,
 	}
 
 	/*  BE SURE TO ADD NULL TO END OF STREAM  */
-	stream2 << '\0';
+	stream2 += '\0';
 
 	/*  SET STREAM2 LENGTH  */
-	*stream2_length = static_cast<long>(stream2.tellp());
+	*stream2_length = static_cast<long>(stream2.size());
 
 	/*  RETURN SUCCESS  */
 	return TTS_PARSER_SUCCESS;
@@ -2743,7 +2956,7 @@ TextParser::final_conversion(std::stringstream& stream1, long stream1_length,
 *
 ******************************************************************************/
 void
-TextParser::expand_word(char* word, int is_tonic, std::stringstream& stream)
+TextParser::expand_word(char* word, int is_tonic, std::string& stream, Context& context) const
 {
 	short dictionary;
 	const char *pronunciation, *ptr;
@@ -2760,7 +2973,7 @@ TextParser::expand_word(char* word, int is_tonic, std::stringstream& stream)
 		if (!strcmp(word,"a") && !possessive) {
 			pronunciation = "uh";
 		} else {
-			pronunciation = numberParser_.degenerateString(word);
+			pronunciation = context.numberParser_.degenerateString(word);
 		}
 		dictionary = TTS_LETTER_TO_SOUND;
 	} else if (is_all_upper_case(word)) {
@@ -2768,21 +2981,24 @@ TextParser::expand_word(char* word, int is_tonic, std::stringstream& stream)
 		    EXCEPT SPECIAL ACRONYMS  */
 
 		if (!(pronunciation = is_special_acronym(word))) {
-			pronunciation = numberParser_.degenerateString(word);
+			pronunciation = context.numberParser_.degenerateString(word);
 		}
 
 		dictionary = TTS_LETTER_TO_SOUND;
 	} else { /*  ALL OTHER WORDS ARE LOOKED UP IN DICTIONARIES, AFTER CONVERTING TO LOWER CASE  */
-		pronunciation = lookup_word((const char *)to_lower_case(word), &dictionary);
+		pronunciation = lookup_word((const char *)to_lower_case(word), &dictionary, context);
 	}
 
 	/*  ADD FOOT BEGIN MARKER TO FRONT OF WORD IF IT HAS NO PRIMARY STRESS AND IT IS
 	    TO RECEIVE A TONIC;  IF ONLY A SECONDARY STRESS MARKER, CONVERT TO PRIMARY  */
 	last_foot_begin = UNDEFINED_POSITION;
 	if (is_tonic && !contains_primary_stress(pronunciation)) {
-		if (!converted_stress((char *)pronunciation)) {
-			stream << FOOT_BEGIN;
-			last_foot_begin = static_cast<long>(stream.tellp()) - 2;
+		/*  CONVERT A COPY, THE PRONUNCIATION MAY BE READ-ONLY  */
+		context.tonicPronunciation_ = pronunciation;
+		pronunciation = context.tonicPronunciation_.c_str();
+		if (!converted_stress(&context.tonicPronunciation_[0])) {
+			stream += FOOT_BEGIN;
+			last_foot_begin = static_cast<long>(stream.size()) - 2;
 		}
 	}
 
@@ -2795,32 +3011,32 @@ TextParser::expand_word(char* word, int is_tonic, std::stringstream& stream)
 		switch(*ptr) {
 		case '\'':
 		case '`':
-			stream << FOOT_BEGIN;
-			last_foot_begin = static_cast<long>(stream.tellp()) - 2;
+			stream += FOOT_BEGIN;
+			last_foot_begin = static_cast<long>(stream.size()) - 2;
 			last_phoneme[0] = '\0';
 			last_phoneme_ptr = last_phoneme;
 			break;
 		case '"':
-			stream << SECONDARY_STRESS;
+			stream += SECONDARY_STRESS;
 			last_phoneme[0] = '\0';
 			last_phoneme_ptr = last_phoneme;
 			break;
 		case '_':
 		case '.':
-			stream << *ptr;
+			stream += *ptr;
 			last_phoneme[0] = '\0';
 			last_phoneme_ptr = last_phoneme;
 			break;
 		case ' ':
 			/*  SUPPRESS UNNECESSARY BLANKS  */
 			if (*(ptr+1) && (*(ptr+1) != ' ')) {
-				stream << *ptr;
+				stream += *ptr;
 				last_phoneme[0] = '\0';
 				last_phoneme_ptr = last_phoneme;
 			}
 			break;
 		default:
-			stream << *ptr;
+			stream += *ptr;
 			*last_phoneme_ptr++ = *ptr;
 			*last_phoneme_ptr = '\0';
 			break;
@@ -2833,25 +3049,22 @@ TextParser::expand_word(char* word, int is_tonic, std::stringstream& stream)
 		if (!strcmp(last_phoneme,"p") || !strcmp(last_phoneme,"t") ||
 				!strcmp(last_phoneme,"k") || !strcmp(last_phoneme,"f") ||
 				!strcmp(last_phoneme,"th")) {
-			stream << "_s";
+			stream += "_s";
 		} else if (!strcmp(last_phoneme,"s") || !strcmp(last_phoneme,"sh") ||
 				!strcmp(last_phoneme,"z") || !strcmp(last_phoneme,"zh") ||
 				!strcmp(last_phoneme,"j") || !strcmp(last_phoneme,"ch")) {
-			stream << ".uh_z";
+			stream += ".uh_z";
 		} else {
-			stream << "_z";
+			stream += "_z";
 		}
 	}
 
 	/*  ADD SPACE AFTER WORD  */
-	stream << ' ';
+	stream += ' ';
 
 	/*  IF TONIC, CONVERT LAST FOOT MARKER TO TONIC MARKER  */
 	if (is_tonic && (last_foot_begin != UNDEFINED_POSITION)) {
-		long temporaryPosition = static_cast<long>(stream.tellp());
-		stream.seekp(last_foot_begin);
-		stream << TONIC_BEGIN;
-		stream.seekp(temporaryPosition);
+		stream.replace(last_foot_begin, strlen(TONIC_BEGIN), TONIC_BEGIN);
 	}
 }
 
@@ -23,26 +23,86 @@
 
 #include <memory>
 #include <string>
-#include <sstream>
 #include <vector>
 
 #include "en/dictionary/DictionarySearch.h"
+#include "en/letter_to_sound/LetterToSound.h"
+#include "en/phonetic_string_parser/PhoneticStringTokenizer.h"
+#include "en/phonetic_string_parser/PhoneticTokenList.h"
 #include "en/text_parser/NumberParser.h"
+#include "en/text_parser/PronunciationCache.h"
 
 
 
 namespace GS {
+namespace TRMControlModel {
+class Model;
+}
 namespace En {
 
+/*******************************************************************************
+ * The dictionaries and the configuration are not modified after the
+ * construction, and the state of a parse is kept in a Context, so parseText
+ * may be called concurrently.
+ */
 class TextParser {
 public:
+	// Per-call state, with buffers that are reused between calls. After the
+	// buffers have grown to the size of the input, parseText does not allocate
+	// memory, except to insert new words in the pronunciation cache.
+	// A context must not be used by more than one thread at a time.
+	class Context {
+	public:
+		Context();
+		~Context();
+	private:
+		friend class TextParser;
+
+		Context(const Context&) = delete;
+		Context& operator=(const Context&) = delete;
+
+		std::vector<char> buffer1_;
+		std::vector<char> buffer2_;
+		std::string stream1_;
+		std::string auxStream_;
+		std::string workStream_;
+		std::vector<char> pronunciation_;
+		std::string tonicPronunciation_;
+		std::string cachedPronunciation_;
+		DictionarySearch::Buffer dictionaryBuffer_;
+		NumberParser numberParser_;
+		LetterToSound letterToSound_;
+	};
+
 	TextParser(const char* configDirPath,
 			const std::string& dictionary1Path,
 			const std::string& dictionary2Path,
 			const std::string& dictionary3Path);
 	~TextParser();
 
-	std::string parseText(const char* text);
+	std::string parseText(const char* text) const;
+	// The returned string is stored in the context, and is invalidated by the
+	// next call with the same context.
+	const std::string& parseText(const char* text, Context& context) const;
+	// Also converts the final stream to tokens. The returned string is
+	// used only for debugging, and must not be changed while the token list
+	// is in use.
+	const std::string& parseText(const char* text, Context& context, PhoneticTokenList& tokenList) const;
+
+	// The postures of the tokens are found in the model, which must be set
+	// before the tokens are requested, and must not be destroyed before the
+	// text parser.
+	void setModel(const TRMControlModel::Model& model);
+	const TRMControlModel::Model* model() const { return tokenizer_ ? &tokenizer_->model() : nullptr; }
+
+	// The cache may be shared by many text parsers that use the same dictionaries.
+	// The cache must not be replaced while a text is being parsed.
+	PronunciationCache& pronunciationCache() { return *pronunciationCache_; }
+	void setPronunciationCache(std::shared_ptr<PronunciationCache> cache);
+	// Returns false if the file does not exist or was created with other dictionaries.
+	bool loadPronunciationCache(const std::string& filePath);
+	void savePronunciationCache(const std::string& filePath) const;
+	void printPronunciationCacheStatistics() const;
 
 private:
 	enum {
@@ -52,14 +112,15 @@ private:
 	TextParser(const TextParser&) = delete;
 	TextParser& operator=(const TextParser&) = delete;
 
-	void init_parser_module();
 	int set_escape_code(char new_escape_code);
-	const char* lookup_word(const char* word, short* dict);
-	void condition_input(const char* input, char* output, int length, int* output_length);
-	int mark_modes(const char* input, char *output, int length, int *output_length);
-	void expand_word(char* word, int is_tonic, std::stringstream& stream);
-	int final_conversion(std::stringstream& stream1, long stream1_length,
-				std::stringstream& stream2, long* stream2_length);
+	const char* lookup_word(const char* word, short* dict, Context& context) const;
+	const char* search_dictionaries(const char* word, short* dict, Context& context) const;
+	std::string pronunciation_cache_signature() const;
+	void condition_input(const char* input, char* output, int length, int* output_length) const;
+	int mark_modes(const char* input, char *output, int length, int *output_length) const;
+	void expand_word(char* word, int is_tonic, std::string& stream, Context& context) const;
+	int final_conversion(const std::string& stream1, long stream1_length,
+				std::string& stream2, long* stream2_length, Context& context) const;
 
 	std::unique_ptr<DictionarySearch> dict1_;
 	std::unique_ptr<DictionarySearch> dict2_;
@@ -68,9 +129,9 @@ private:
 	char escape_character_;
 	short dictionaryOrder_[DICTIONARY_ORDER_SIZE];
 
-	std::stringstream auxStream_;
-	std::vector<char> pronunciation_;
-	NumberParser numberParser_;
+	std::shared_ptr<PronunciationCache> pronunciationCache_;
+
+	std::unique_ptr<PhoneticStringTokenizer> tokenizer_;
 };
 
 } /* namespace En */
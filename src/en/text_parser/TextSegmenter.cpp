@@ -0,0 +1,279 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "en/text_parser/TextSegmenter.h"
+
+#include <cctype> /* isalnum, isalpha */
+#include <cstring> /* strlen, strncmp */
+
+#include "en/text_parser/abbreviations.h"
+
+
+
+namespace {
+
+bool
+isBlank(const std::string& s)
+{
+	return s.find_first_not_of(' ') == std::string::npos;
+}
+
+} /* namespace */
+
+namespace GS {
+namespace En {
+
+TextSegmenter::TextSegmenter(std::istream& in)
+		: in_(in)
+		, block_(BLOCK_SIZE)
+		, begin_(0)
+		, scanPos_(0)
+		, modeDepth_(0)
+		, rawMode_(false)
+		, endOfInput_(false)
+		, lastChar_('\n')
+{
+}
+
+TextSegmenter::~TextSegmenter()
+{
+}
+
+bool
+TextSegmenter::getSegment(std::string& segment)
+{
+	for (;;) {
+		std::size_t end;
+		if (findSegmentEnd(end)) {
+			segment.assign(buffer_, begin_, end - begin_);
+			begin_ = end;
+			return true;
+		}
+		if (endOfInput_) {
+			break;
+		}
+		readBlock();
+	}
+
+	if (begin_ == buffer_.size()) {
+		return false;
+	}
+	segment.assign(buffer_, begin_, std::string::npos);
+	begin_ = scanPos_ = buffer_.size();
+	return !isBlank(segment);
+}
+
+/*******************************************************************************
+ * Appends a block of the input to the buffer, converting line ends to spaces.
+ *
+ * Like the line-by-line reading, a space is added after the last line if it
+ * does not end with a line end.
+ */
+void
+TextSegmenter::readBlock()
+{
+	if (begin_ >= BLOCK_SIZE) {
+		buffer_.erase(0, begin_);
+		scanPos_ -= begin_;
+		begin_ = 0;
+	}
+
+	in_.read(block_.data(), BLOCK_SIZE);
+	const std::size_t n = in_.gcount();
+	if (n == 0) {
+		endOfInput_ = true;
+		if (lastChar_ != '\n') {
+			buffer_ += ' ';
+		}
+		return;
+	}
+	lastChar_ = block_[n - 1];
+
+	for (std::size_t i = 0; i < n; ++i) {
+		if (block_[i] == '\n') {
+			block_[i] = ' ';
+		}
+	}
+	buffer_.append(block_.data(), n);
+}
+
+/*******************************************************************************
+ * Scans the buffer from the last checked position.
+ *
+ * Returns true if the current segment ends at "end", or false if more input
+ * is needed.
+ */
+bool
+TextSegmenter::findSegmentEnd(std::size_t& end)
+{
+	const std::size_t size = buffer_.size();
+	while (scanPos_ < size) {
+		const char c = buffer_[scanPos_];
+		if (c == ESCAPE_CHARACTER) {
+			if (scanPos_ + 2 >= size && !endOfInput_) {
+				return false;
+			}
+			scanPos_ += skipEscapeSequence(scanPos_);
+			continue;
+		}
+		if (modeDepth_ == 0 && (c == '.' || c == '!' || c == '?')) {
+			switch (checkSegmentEnd(scanPos_)) {
+			case SEGMENT_END:
+				end = ++scanPos_;
+				return true;
+			case NEED_MORE_INPUT:
+				return false;
+			case NO_SEGMENT_END:
+				break;
+			}
+		}
+		++scanPos_;
+	}
+	return false;
+}
+
+/*******************************************************************************
+ * Tracks the escape modes like TextParser::mark_modes.
+ *
+ * Only raw, letter and emphasis modes are counted. Tagging and silence modes
+ * may end without an explicit mode end, and contain only numbers.
+ *
+ * Returns the length of the escape sequence.
+ */
+std::size_t
+TextSegmenter::skipEscapeSequence(std::size_t pos)
+{
+	if (pos + 2 >= buffer_.size()) {
+		return 1;
+	}
+	const char modeChar = buffer_[pos + 1];
+	const char typeChar = buffer_[pos + 2];
+
+	if (rawMode_) {
+		if ((modeChar == 'r' || modeChar == 'R') && (typeChar == 'e' || typeChar == 'E')) {
+			rawMode_ = false;
+			--modeDepth_;
+			return 3;
+		}
+		return 1;
+	}
+
+	if (modeChar == ESCAPE_CHARACTER) {
+		return 2;
+	}
+	switch (modeChar) {
+	case 'r': case 'R':
+	case 'l': case 'L':
+	case 'e': case 'E':
+		if (typeChar == 'b' || typeChar == 'B') {
+			++modeDepth_;
+			rawMode_ = (modeChar == 'r' || modeChar == 'R');
+		} else if ((typeChar == 'e' || typeChar == 'E') && modeDepth_ > 0) {
+			--modeDepth_;
+		}
+		return 3;
+	default:
+		return 1;
+	}
+}
+
+/*******************************************************************************
+ * Checks if the final punctuation at "pos" ends a chunk in the text parser.
+ *
+ * When in doubt, the segment is not ended.
+ */
+TextSegmenter::Decision
+TextSegmenter::checkSegmentEnd(std::size_t pos) const
+{
+	const std::size_t size = buffer_.size();
+
+	/*  A SPACE AND A WORD MUST FOLLOW  */
+	if (pos + 1 >= size) {
+		return endOfInput_ ? NO_SEGMENT_END : NEED_MORE_INPUT;
+	}
+	if (buffer_[pos + 1] != ' ') {
+		return NO_SEGMENT_END;
+	}
+	std::size_t next = pos + 2;
+	while (next < size && buffer_[next] == ' ') {
+		++next;
+	}
+	if (next == size) {
+		return endOfInput_ ? NO_SEGMENT_END : NEED_MORE_INPUT;
+	}
+	if (!isalnum(static_cast<unsigned char>(buffer_[next]))) {
+		return NO_SEGMENT_END;
+	}
+
+	/*  A WORD MUST PRECEDE  */
+	std::size_t wordPos = pos;
+	while (wordPos > begin_ && isalnum(static_cast<unsigned char>(buffer_[wordPos - 1]))) {
+		--wordPos;
+	}
+	const std::size_t wordLength = pos - wordPos;
+	if (wordLength == 0) {
+		return NO_SEGMENT_END;
+	}
+
+	/*  NO ESCAPE SEQUENCE IN THE LAST TWO TOKENS  */
+	std::size_t i = pos;
+	for (int tokens = 0; tokens < 2 && i > begin_; ++tokens) {
+		while (i > begin_ && buffer_[i - 1] != ' ') {
+			if (buffer_[--i] == ESCAPE_CHARACTER) {
+				return NO_SEGMENT_END;
+			}
+		}
+		while (i > begin_ && buffer_[i - 1] == ' ') {
+			--i;
+		}
+	}
+
+	/*  THE PERIOD MUST NOT BE DELETED BY THE ABBREVIATION EXPANSION  */
+	if (buffer_[pos] == '.') {
+		if (wordLength == 1 && isalpha(static_cast<unsigned char>(buffer_[wordPos]))) {
+			return NO_SEGMENT_END;
+		}
+		if (isAbbreviation(wordPos, wordLength)) {
+			return NO_SEGMENT_END;
+		}
+	}
+
+	return SEGMENT_END;
+}
+
+bool
+TextSegmenter::isAbbreviation(std::size_t wordPos, std::size_t wordLength) const
+{
+	if (wordLength < 2 || wordLength > 4) {
+		return false;
+	}
+	const char* word = buffer_.data() + wordPos;
+	for (int i = 0; abbreviation[i][0] != NULL; ++i) {
+		if (strlen(abbreviation[i][0]) == wordLength && strncmp(abbreviation[i][0], word, wordLength) == 0) {
+			return true;
+		}
+	}
+	for (int i = 0; abbr_with_number[i][0] != NULL; ++i) {
+		if (strlen(abbr_with_number[i][0]) == wordLength && strncmp(abbr_with_number[i][0], word, wordLength) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+} /* namespace En */
+} /* namespace GS */
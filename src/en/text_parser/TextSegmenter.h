@@ -0,0 +1,83 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef EN_TEXT_SEGMENTER_H_
+#define EN_TEXT_SEGMENTER_H_
+
+#include <cstddef> /* std::size_t */
+#include <istream>
+#include <string>
+#include <vector>
+
+
+
+namespace GS {
+namespace En {
+
+/*******************************************************************************
+ * Splits the input text into segments that can be passed separately to
+ * TextParser::parseText.
+ *
+ * The input is read in blocks, so only the current segment is kept in memory.
+ * Line ends are converted to spaces. A segment ends after a '.', '!' or '?'
+ * only where the text parser would end a chunk anyway: after a word, before
+ * a space and a letter or digit, outside any escape mode, and not after an
+ * abbreviation or a single letter. The concatenation of the phonetic strings
+ * of the segments is equivalent to the phonetic string of the entire text.
+ */
+class TextSegmenter {
+public:
+	explicit TextSegmenter(std::istream& in);
+	~TextSegmenter();
+
+	// Returns false at the end of the input.
+	bool getSegment(std::string& segment);
+private:
+	enum {
+		BLOCK_SIZE = 65536,
+		ESCAPE_CHARACTER = 27 // the default escape character of the text parser
+	};
+	enum Decision {
+		NO_SEGMENT_END,
+		SEGMENT_END,
+		NEED_MORE_INPUT
+	};
+
+	TextSegmenter(const TextSegmenter&) = delete;
+	TextSegmenter& operator=(const TextSegmenter&) = delete;
+
+	void readBlock();
+	bool findSegmentEnd(std::size_t& end);
+	std::size_t skipEscapeSequence(std::size_t pos);
+	Decision checkSegmentEnd(std::size_t pos) const;
+	bool isAbbreviation(std::size_t wordPos, std::size_t wordLength) const;
+
+	std::istream& in_;
+	std::vector<char> block_;
+	std::string buffer_;
+	std::size_t begin_;   // start of the current segment in buffer_
+	std::size_t scanPos_; // the characters before this position have been checked
+	int modeDepth_;
+	bool rawMode_;
+	bool endOfInput_;
+	char lastChar_;
+};
+
+} /* namespace En */
+} /* namespace GS */
+
+#endif /* EN_TEXT_SEGMENTER_H_ */
@@ -20,5 +20,11 @@
 
 #define PROGRAM_VERSION "0.1.9"
 #define TRM_CONTROL_MODEL_CONFIG_FILE "/monet.xml"
+#define TRM_CONTROL_MODEL_CONFIGURATION_FILE "/trm_control_model.txt"
+
+#ifdef _WIN32
+// The batch synthesis uses only threads.
+# define GS_NO_WORKER_PROCESSES
+#endif
 
 #endif /* GLOBAL_H_ */
@@ -0,0 +1,65 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+#include "Dictionary.h"
+#include "global.h"
+#include "Log.h"
+
+
+
+/*******************************************************************************
+ * Converts a text dictionary to the binary format, which is memory-mapped
+ * when loaded.
+ */
+int
+main(int argc, char* argv[])
+{
+	using namespace GS;
+
+	const char* inputFile = nullptr;
+	const char* outputFile = nullptr;
+
+	if (argc == 3) {
+		inputFile = argv[1];
+		outputFile = argv[2];
+	} else if ((argc == 4) && (strcmp("-v", argv[1]) == 0)) {
+		Log::debugEnabled = true;
+		inputFile = argv[2];
+		outputFile = argv[3];
+	} else {
+		std::cout << "\nGnuspeechSA dictionary compiler " << PROGRAM_VERSION << "\n\n";
+		std::cerr << "Usage: " << argv[0] << " [-v] input_dictionary.txt output_dictionary.dict\n";
+		std::cout << "         -v : verbose\n" << std::endl;
+		return 1;
+	}
+
+	try {
+		Dictionary dict;
+		dict.load(inputFile);
+		dict.save(outputFile);
+		std::cout << "Entries: " << dict.size() << std::endl;
+	} catch (std::exception& e) {
+		std::cerr << "Caught an exception: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
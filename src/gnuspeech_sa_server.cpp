@@ -0,0 +1,972 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+// Synthesis server. The model, the dictionaries and the configuration are
+// loaded once, and the requests are processed by a pool of worker threads.
+//
+// Each request is a line with a JSON object:
+//
+//   {"id": "1", "text": "Hello world.", "voice": "female", "tempo": 1.2,
+//    "pitch_offset": -2.0, "intonation": "micro,macro,drift",
+//    "format": "wav", "output": "hello.wav", "timeout": 2.5}
+//
+// Only "text" is required. The standard voices are loaded at startup, so
+// each request may use a different voice. "intonation" is a comma-separated
+// list of "micro", "macro", "smooth", "drift" and "random", or "none".
+// "format" is "wav" or "raw" (16-bit little-endian PCM). "output" is a file
+// name in the output directory given in the command line, and is rejected if
+// there is no output directory. If "output" is not present, the audio is sent
+// after the response line, with the number of bytes in the field "bytes".
+// "timeout" is the maximum time in seconds from the reception of the request,
+// including the time in the queue.
+//
+// Each response is a line with a JSON object, containing "status" ("ok",
+// "error", "timeout" or "cancelled") and the latencies of the request. The
+// responses may be sent in a different order than the requests. If the client
+// disconnects, or does not read the responses, its remaining requests are
+// cancelled.
+
+#include <algorithm> /* min */
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <limits.h> /* PIPE_BUF */
+#include <poll.h> /* poll */
+#include <signal.h> /* signal */
+#include <sys/socket.h>
+#include <sys/stat.h> /* chmod, umask */
+#include <sys/un.h> /* sockaddr_un */
+#include <unistd.h> /* close, read, unlink, write */
+
+#include "BoundedQueue.h"
+#include "CancellationToken.h"
+#include "Exception.h"
+#include "global.h"
+#include "Model.h"
+#include "en/Synthesizer.h"
+#include "en/text_parser/TextParser.h"
+#include "TemporaryFile.h"
+#include "TRMControlModelConfiguration.h"
+#include "VoiceSet.h"
+#include "WAVEFileWriter.h"
+
+
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+constexpr unsigned int DEFAULT_QUEUE_SIZE = 64;
+constexpr unsigned int DEFAULT_MAX_CONNECTIONS = 64;
+constexpr std::size_t MAX_LINE_SIZE = 1024 * 1024;
+constexpr std::size_t READ_BUFFER_SIZE = 64 * 1024;
+constexpr std::size_t MAX_QUEUED_OUTPUT_SIZE = 256 * 1024 * 1024; // bytes
+constexpr std::size_t WRITE_BLOCK_SIZE = PIPE_BUF; // does not block after POLLOUT
+constexpr int HANGUP_POLL_INTERVAL_MS = 100;
+constexpr int WRITE_TIMEOUT_MS = 30000;
+constexpr mode_t SOCKET_MODE = S_IRUSR | S_IWUSR; // only the owner may connect
+
+double
+elapsedMilliseconds(Clock::time_point begin, Clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+/*******************************************************************************
+ * Parses a JSON object whose values are strings, numbers, booleans or null.
+ * The values are stored as text, without quotes.
+ */
+class JSONObjectParser {
+public:
+	JSONObjectParser(const std::string& s, std::map<std::string, std::string>& valueMap)
+			: s_(s), pos_(0), valueMap_(valueMap) {}
+
+	void parse() {
+		valueMap_.clear();
+		skipSpace();
+		expect('{');
+		skipSpace();
+		if (peek() == '}') {
+			++pos_;
+		} else {
+			for (;;) {
+				skipSpace();
+				std::string key = parseString();
+				skipSpace();
+				expect(':');
+				skipSpace();
+				std::string value;
+				if (peek() == '"') {
+					value = parseString();
+				} else {
+					value = parseLiteral();
+				}
+				valueMap_[key] = value;
+				skipSpace();
+				if (peek() == ',') {
+					++pos_;
+				} else {
+					expect('}');
+					break;
+				}
+			}
+		}
+		skipSpace();
+		if (pos_ != s_.size()) {
+			THROW_EXCEPTION(GS::InvalidValueException, "Invalid JSON: characters after the object.");
+		}
+	}
+private:
+	char peek() const { return (pos_ < s_.size()) ? s_[pos_] : '\0'; }
+
+	void skipSpace() {
+		while (pos_ < s_.size() && (s_[pos_] == ' ' || s_[pos_] == '\t' || s_[pos_] == '\r' || s_[pos_] == '\n')) {
+			++pos_;
+		}
+	}
+
+	void expect(char c) {
+		if (peek() != c) {
+			THROW_EXCEPTION(GS::InvalidValueException, "Invalid JSON: expected '" << c << "' at position " << pos_ << '.');
+		}
+		++pos_;
+	}
+
+	unsigned int parseHex4() {
+		if (s_.size() - pos_ < 4) {
+			THROW_EXCEPTION(GS::InvalidValueException, "Invalid JSON: truncated unicode escape.");
+		}
+		unsigned int code = 0;
+		for (int i = 0; i < 4; ++i) {
+			const char c = s_[pos_++];
+			code <<= 4;
+			if (c >= '0' && c <= '9') {
+				code |= c - '0';
+			} else if (c >= 'a' && c <= 'f') {
+				code |= c - 'a' + 10;
+			} else if (c >= 'A' && c <= 'F') {
+				code |= c - 'A' + 10;
+			} else {
+				THROW_EXCEPTION(GS::InvalidValueException, "Invalid JSON: invalid unicode escape.");
+			}
+		}
+		return code;
+	}
+
+	static void appendUTF8(unsigned int code, std::string& s) {
+		if (code < 0x80U) {
+			s += static_cast<char>(code);
+		} else if (code < 0x800U) {
+			s += static_cast<char>(0xC0U | (code >> 6));
+			s += static_cast<char>(0x80U | (code & 0x3FU));
+		} else if (code < 0x10000U) {
+			s += static_cast<char>(0xE0U | (code >> 12));
+			s += static_cast<char>(0x80U | ((code >> 6) & 0x3FU));
+			s += static_cast<char>(0x80U | (code & 0x3FU));
+		} else {
+			s += static_cast<char>(0xF0U | (code >> 18));
+			s += static_cast<char>(0x80U | ((code >> 12) & 0x3FU));
+			s += static_cast<char>(0x80U | ((code >> 6) & 0x3FU));
+			s += static_cast<char>(0x80U | (code & 0x3FU));
+		}
+	}
+
+	std::string parseString() {
+		expect('"');
+		std::string value;
+		for (;;) {
+			if (pos_ >= s_.size()) {
+				THROW_EXCEPTION(GS::InvalidValueException, "Invalid JSON: unterminated string.");
+			}
+			const char c = s_[pos_++];
+			if (c == '"') {
+				break;
+			} else if (c != '\\') {
+				value += c;
+				continue;
+			}
+			switch (peek()) {
+			case '"':  value += '"';  break;
+			case '\\': value += '\\'; break;
+			case '/':  value += '/';  break;
+			case 'b':  value += '\b'; break;
+			case 'f':  value += '\f'; break;
+			case 'n':  value += '\n'; break;
+			case 'r':  value += '\r'; break;
+			case 't':  value += '\t'; break;
+			case 'u':
+				{
+					++pos_;
+					unsigned int code = parseHex4();
+					if (code >= 0xD800U && code < 0xDC00U && s_.compare(pos_, 2, "\\u") == 0) {
+						pos_ += 2;
+						const unsigned int low = parseHex4();
+						if (low < 0xDC00U || low >= 0xE000U) {
+							THROW_EXCEPTION(GS::InvalidValueException, "Invalid JSON: invalid surrogate pair.");
+						}
+						code = 0x10000U + ((code - 0xD800U) << 10) + (low - 0xDC00U);
+					}
+					appendUTF8(code, value);
+				}
+				continue;
+			default:
+				THROW_EXCEPTION(GS::InvalidValueException, "Invalid JSON: invalid escape sequence.");
+			}
+			++pos_;
+		}
+		return value;
+	}
+
+	std::string parseLiteral() {
+		const std::size_t begin = pos_;
+		while (pos_ < s_.size() && (std::isalnum(static_cast<unsigned char>(s_[pos_])) ||
+				s_[pos_] == '-' || s_[pos_] == '+' || s_[pos_] == '.')) {
+			++pos_;
+		}
+		if (pos_ == begin) {
+			THROW_EXCEPTION(GS::InvalidValueException, "Invalid JSON value at position " << pos_ << '.');
+		}
+		return s_.substr(begin, pos_ - begin);
+	}
+
+	const std::string& s_;
+	std::size_t pos_;
+	std::map<std::string, std::string>& valueMap_;
+};
+
+void
+appendJSONString(const std::string& value, std::string& s)
+{
+	s += '"';
+	for (char c : value) {
+		switch (c) {
+		case '"':  s += "\\\""; break;
+		case '\\': s += "\\\\"; break;
+		case '\n': s += "\\n";  break;
+		case '\r': s += "\\r";  break;
+		case '\t': s += "\\t";  break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20U) {
+				static const char hexDigits[] = "0123456789abcdef";
+				s += "\\u00";
+				s += hexDigits[(c >> 4) & 0x0F];
+				s += hexDigits[c & 0x0F];
+			} else {
+				s += c;
+			}
+		}
+	}
+	s += '"';
+}
+
+/*******************************************************************************
+ * A client: standard input/output, or a socket connection.
+ *
+ * The responses are written by a separate thread, so a client that does not
+ * read them never blocks the workers.
+ */
+class Connection {
+public:
+	Connection(int inputFd, int outputFd, bool ownsFds)
+			: inputFd_(inputFd), outputFd_(outputFd), ownsFds_(ownsFds), pendingRequests_(0)
+			, queuedOutputSize_(0), closing_(false) {
+		writerThread_ = std::thread(&Connection::writeOutput, this);
+	}
+	~Connection() {
+		closeOutput();
+		if (ownsFds_) {
+			close(inputFd_);
+			if (outputFd_ != inputFd_) {
+				close(outputFd_);
+			}
+		}
+	}
+
+	int inputFd() const { return inputFd_; }
+
+	// Cancelled when the client disconnects, or does not read the responses.
+	const GS::CancellationToken& cancellationToken() const { return cancellationToken_; }
+
+	void addPendingRequest() { ++pendingRequests_; }
+	void removePendingRequest() { --pendingRequests_; }
+
+	// Queues the data, which is written by the writer thread. The data of
+	// different responses are not interleaved.
+	// If too much data is queued, the client is not reading the responses, and
+	// the remaining requests are cancelled.
+	void send(const std::string& response, const std::string& audioData) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (closing_ || cancellationToken_.cancelled()) {
+			return;
+		}
+		const std::size_t size = response.size() + audioData.size();
+		if (queuedOutputSize_ + size > MAX_QUEUED_OUTPUT_SIZE) {
+			cancelOutput();
+			return;
+		}
+		outputQueue_.emplace_back();
+		std::string& data = outputQueue_.back();
+		data.reserve(size);
+		data += response;
+		data += audioData;
+		queuedOutputSize_ += size;
+		outputCondition_.notify_one();
+	}
+
+	// Called after the end of the input. Returns when all the requests have
+	// been answered and the responses have been written, or when the client
+	// closes the connection. In the latter case, the remaining requests are
+	// cancelled.
+	void waitForClose() {
+		while (pendingRequests_ > 0) {
+			pollfd pfd;
+			pfd.fd = outputFd_;
+			pfd.events = 0; // POLLHUP and POLLERR are always reported
+			pfd.revents = 0;
+			const int n = poll(&pfd, 1, HANGUP_POLL_INTERVAL_MS);
+			if (n < 0 && errno != EINTR) {
+				break;
+			}
+			if (n > 0 && (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)) != 0) {
+				cancellationToken_.cancel();
+				break;
+			}
+		}
+		closeOutput();
+	}
+private:
+	Connection(const Connection&) = delete;
+	Connection& operator=(const Connection&) = delete;
+
+	// The mutex must be locked.
+	void cancelOutput() {
+		cancellationToken_.cancel();
+		outputQueue_.clear();
+		queuedOutputSize_ = 0;
+	}
+
+	// Writes the queued data until closeOutput() is called.
+	void writeOutput() {
+		std::string data;
+		std::unique_lock<std::mutex> lock(mutex_);
+		for (;;) {
+			outputCondition_.wait(lock, [&] { return closing_ || !outputQueue_.empty(); });
+			if (outputQueue_.empty()) {
+				break;
+			}
+			data.swap(outputQueue_.front());
+			outputQueue_.pop_front();
+			queuedOutputSize_ -= data.size();
+
+			lock.unlock();
+			const bool written = writeAll(data);
+			lock.lock();
+			if (!written) {
+				// The client has disconnected, or does not read the responses.
+				cancelOutput();
+			}
+		}
+	}
+
+	// Writes the remaining data, and stops the writer thread.
+	void closeOutput() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			closing_ = true;
+			outputCondition_.notify_one();
+		}
+		if (writerThread_.joinable()) {
+			writerThread_.join();
+		}
+	}
+
+	// Fails if the client does not accept data for WRITE_TIMEOUT_MS.
+	bool writeAll(const std::string& data) {
+		std::size_t pos = 0;
+		while (pos < data.size()) {
+			pollfd pfd;
+			pfd.fd = outputFd_;
+			pfd.events = POLLOUT;
+			pfd.revents = 0;
+			const int n = poll(&pfd, 1, WRITE_TIMEOUT_MS);
+			if (n < 0) {
+				if (errno == EINTR) continue;
+				return false;
+			}
+			if (n == 0 || (pfd.revents & POLLOUT) == 0) {
+				return false;
+			}
+			const ssize_t written = write(outputFd_, data.data() + pos, std::min(data.size() - pos, WRITE_BLOCK_SIZE));
+			if (written < 0) {
+				if (errno == EINTR) continue;
+				return false;
+			}
+			pos += written;
+		}
+		return true;
+	}
+
+	const int inputFd_;
+	const int outputFd_;
+	const bool ownsFds_;
+	std::atomic<int> pendingRequests_;
+	GS::CancellationToken cancellationToken_;
+	std::mutex mutex_;
+	std::condition_variable outputCondition_;
+	std::deque<std::string> outputQueue_;
+	std::size_t queuedOutputSize_; // bytes
+	bool closing_;
+	std::thread writerThread_;
+};
+
+struct Request {
+	std::shared_ptr<Connection> connection;
+	std::string line;
+	Clock::time_point receiveTime;
+};
+
+typedef GS::BoundedQueue<Request> RequestQueue;
+
+struct Statistics {
+	Statistics() : requests(0), errors(0), cancelled(0), audioSeconds(0.0), totalMilliseconds(0.0), maxMilliseconds(0.0) {}
+
+	void add(bool ok, bool wasCancelled, double audioSec, double totalMs) {
+		std::lock_guard<std::mutex> lock(mutex);
+		++requests;
+		if (!ok) ++errors;
+		if (wasCancelled) ++cancelled;
+		audioSeconds += audioSec;
+		totalMilliseconds += totalMs;
+		if (totalMs > maxMilliseconds) maxMilliseconds = totalMs;
+	}
+
+	std::mutex mutex;
+	unsigned long requests;
+	unsigned long errors;
+	unsigned long cancelled; // included in errors
+	double audioSeconds;
+	double totalMilliseconds;
+	double maxMilliseconds;
+};
+
+void
+encodeAudio(const std::vector<float>& buffer, int channels, float outputRate, bool wavHeader, std::string& data)
+{
+	data.clear();
+	if (wavHeader) {
+		GS::WAVEFileWriter::appendHeader(data, channels, buffer.size() / channels, outputRate);
+	}
+	GS::WAVEFileWriter::appendSamples(data, buffer.data(), buffer.size());
+}
+
+/*******************************************************************************
+ * The state used by one worker thread. The model and the text parser are
+ * shared by all the workers.
+ */
+class Worker {
+public:
+	Worker(const char* configDirPath, const GS::TRMControlModel::Model& model, const GS::En::TextParser& textParser,
+			const GS::TRMControlModel::VoiceSet& voiceSet, double defaultTimeout, const char* outputDirPath)
+			: synthesizer_(configDirPath, model, textParser, voiceSet)
+			, defaultTimeout_(defaultTimeout)
+			, outputDirPath_(outputDirPath != nullptr ? outputDirPath : "") {
+		synthesizer_.setCancellationToken(&cancellationToken_);
+	}
+
+	void process(const Request& request, Statistics& statistics);
+private:
+	Worker(const Worker&) = delete;
+	Worker& operator=(const Worker&) = delete;
+
+	void synthesize(const std::map<std::string, std::string>& valueMap);
+	std::string outputFilePath(const std::string& fileName) const;
+
+	GS::CancellationToken cancellationToken_; // its parent is the token of the connection
+	GS::En::Synthesizer synthesizer_;
+	const double defaultTimeout_; // seconds, 0.0: no timeout
+	const std::string outputDirPath_; // empty: the "output" field is rejected
+	std::map<std::string, std::string> valueMap_;
+	std::vector<float> audioBuffer_;
+	std::string audioData_;
+	std::string response_;
+};
+
+double
+parseDouble(const std::map<std::string, std::string>& valueMap, const char* key, double defaultValue)
+{
+	auto iter = valueMap.find(key);
+	if (iter == valueMap.end()) {
+		return defaultValue;
+	}
+	char* end;
+	const double value = std::strtod(iter->second.c_str(), &end);
+	if (iter->second.empty() || *end != '\0' || !std::isfinite(value)) {
+		THROW_EXCEPTION(GS::InvalidValueException, "Invalid value for " << key << ": " << iter->second << '.');
+	}
+	return value;
+}
+
+int
+parseIntonation(const std::map<std::string, std::string>& valueMap, int defaultValue)
+{
+	auto iter = valueMap.find("intonation");
+	if (iter == valueMap.end()) {
+		return defaultValue;
+	}
+	if (iter->second == "none") {
+		return GS::TRMControlModel::Configuration::INTONATION_NONE;
+	}
+	int intonation = GS::TRMControlModel::Configuration::INTONATION_NONE;
+	std::istringstream in(iter->second);
+	std::string flag;
+	while (std::getline(in, flag, ',')) {
+		if (flag == "micro") {
+			intonation |= GS::TRMControlModel::Configuration::INTONATION_MICRO;
+		} else if (flag == "macro") {
+			intonation |= GS::TRMControlModel::Configuration::INTONATION_MACRO;
+		} else if (flag == "smooth") {
+			intonation |= GS::TRMControlModel::Configuration::INTONATION_SMOOTH;
+		} else if (flag == "drift") {
+			intonation |= GS::TRMControlModel::Configuration::INTONATION_DRIFT;
+		} else if (flag == "random") {
+			intonation |= GS::TRMControlModel::Configuration::INTONATION_RANDOMIZE;
+		} else {
+			THROW_EXCEPTION(GS::InvalidValueException, "Invalid intonation: " << iter->second << '.');
+		}
+	}
+	return intonation;
+}
+
+void
+Worker::synthesize(const std::map<std::string, std::string>& valueMap)
+{
+	auto iter = valueMap.find("text");
+	if (iter == valueMap.end()) {
+		THROW_EXCEPTION(GS::InvalidValueException, "Missing text.");
+	}
+	const std::string& text = iter->second;
+
+	GS::En::Synthesizer::Parameters parameters = synthesizer_.defaultParameters();
+	parameters.tempo = parseDouble(valueMap, "tempo", parameters.tempo);
+	parameters.pitchOffset = parseDouble(valueMap, "pitch_offset", parameters.pitchOffset);
+	parameters.intonation = parseIntonation(valueMap, parameters.intonation);
+
+	iter = valueMap.find("voice");
+	if (iter != valueMap.end()) {
+		const std::string& voiceName = iter->second;
+		if (voiceName.empty() || voiceName.find_first_not_of("abcdefghijklmnopqrstuvwxyz_") != std::string::npos) {
+			THROW_EXCEPTION(GS::InvalidValueException, "Invalid voice: " << voiceName << '.');
+		}
+		parameters.voiceName = voiceName;
+	}
+
+	synthesizer_.synthesize(text, parameters, audioBuffer_);
+}
+
+// The file name must not contain a directory, so that the clients can only
+// write to the output directory.
+std::string
+Worker::outputFilePath(const std::string& fileName) const
+{
+	if (outputDirPath_.empty()) {
+		THROW_EXCEPTION(GS::InvalidValueException, "The output to files is disabled.");
+	}
+	if (fileName.empty() || fileName == "." || fileName == ".." ||
+			fileName.find_first_of(std::string("/\0", 2)) != std::string::npos) {
+		THROW_EXCEPTION(GS::InvalidValueException, "Invalid output file name: " << fileName << '.');
+	}
+	return outputDirPath_ + '/' + fileName;
+}
+
+void
+Worker::process(const Request& request, Statistics& statistics)
+{
+	const Clock::time_point startTime = Clock::now();
+	std::string id;
+	std::string outputFile;
+	bool ok = true;
+	bool cancelled = false;
+	double audioSeconds = 0.0;
+	response_.clear();
+	audioData_.clear();
+	try {
+		JSONObjectParser(request.line, valueMap_).parse();
+
+		auto iter = valueMap_.find("id");
+		if (iter != valueMap_.end()) id = iter->second;
+		iter = valueMap_.find("output");
+		if (iter != valueMap_.end()) outputFile = outputFilePath(iter->second);
+		iter = valueMap_.find("format");
+		const std::string format = (iter == valueMap_.end()) ? "wav" : iter->second;
+		if (format != "wav" && format != "raw") {
+			THROW_EXCEPTION(GS::InvalidValueException, "Invalid format: " << format << '.');
+		}
+		const double timeout = parseDouble(valueMap_, "timeout", defaultTimeout_);
+		if (timeout < 0.0) {
+			THROW_EXCEPTION(GS::InvalidValueException, "Invalid value for timeout: " << timeout << '.');
+		}
+
+		cancellationToken_.reset();
+		cancellationToken_.setParent(&request.connection->cancellationToken());
+		if (timeout > 0.0) {
+			cancellationToken_.setDeadline(request.receiveTime +
+				std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeout)));
+		}
+		synthesize(valueMap_);
+
+		encodeAudio(audioBuffer_, synthesizer_.channels(), synthesizer_.outputRate(), format == "wav", audioData_);
+		if (!outputFile.empty()) {
+			GS::TemporaryFile file(outputFile);
+			std::ofstream out(file.path(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			out.write(audioData_.data(), audioData_.size());
+			out.close();
+			if (!out) {
+				THROW_EXCEPTION(GS::IOException, "Could not write the file " << outputFile << '.');
+			}
+			file.commit();
+			audioData_.clear();
+		}
+		audioSeconds = audioBuffer_.size() / (synthesizer_.channels() * static_cast<double>(synthesizer_.outputRate()));
+	} catch (std::exception& e) {
+		ok = false;
+		const char* status = "error";
+		if (dynamic_cast<const GS::DeadlineExceededException*>(&e) != nullptr) {
+			cancelled = true;
+			status = "timeout";
+		} else if (dynamic_cast<const GS::CancelledException*>(&e) != nullptr) {
+			cancelled = true;
+			status = "cancelled";
+		}
+		audioData_.clear();
+		response_ = "{\"id\":";
+		appendJSONString(id, response_);
+		response_ += ",\"status\":\"";
+		response_ += status;
+		response_ += "\",\"message\":";
+		// The source location in GS exceptions starts in the second line.
+		const char* message = e.what();
+		appendJSONString(std::string(message, std::strcspn(message, "\n")), response_);
+	}
+
+	const Clock::time_point endTime = Clock::now();
+	const double queueMs = elapsedMilliseconds(request.receiveTime, startTime);
+	const double synthesisMs = elapsedMilliseconds(startTime, endTime);
+	const double totalMs = elapsedMilliseconds(request.receiveTime, endTime);
+
+	std::ostringstream fields;
+	if (ok) {
+		response_ = "{\"id\":";
+		appendJSONString(id, response_);
+		response_ += ",\"status\":\"ok\"";
+		if (!outputFile.empty()) {
+			response_ += ",\"output\":";
+			appendJSONString(outputFile, response_);
+		} else {
+			fields << ",\"bytes\":" << audioData_.size();
+		}
+		fields << ",\"sample_rate\":" << synthesizer_.outputRate()
+			<< ",\"channels\":" << synthesizer_.channels()
+			<< ",\"audio_s\":" << audioSeconds;
+	}
+	fields << ",\"queue_ms\":" << queueMs
+		<< ",\"synthesis_ms\":" << synthesisMs
+		<< ",\"total_ms\":" << totalMs << "}\n";
+	response_ += fields.str();
+
+	cancellationToken_.setParent(nullptr);
+
+	request.connection->send(response_, audioData_);
+	statistics.add(ok, cancelled, audioSeconds, totalMs);
+}
+
+// Reads the requests of a client until the end of the input, and waits until
+// they have been answered.
+void
+readRequests(std::shared_ptr<Connection> connection, RequestQueue& queue)
+{
+	std::vector<char> buffer(READ_BUFFER_SIZE);
+	std::string line;
+	bool skipLine = false; // the line is too long
+	for (;;) {
+		const ssize_t n = read(connection->inputFd(), buffer.data(), buffer.size());
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) break;
+		for (ssize_t i = 0; i < n; ++i) {
+			const char c = buffer[i];
+			if (c != '\n') {
+				if (!skipLine) {
+					if (line.size() < MAX_LINE_SIZE) {
+						line += c;
+					} else {
+						skipLine = true;
+						line.clear();
+						connection->send("{\"id\":\"\",\"status\":\"error\",\"message\":\"The request is too long.\"}\n", std::string());
+					}
+				}
+				continue;
+			}
+			if (!skipLine && line.find_first_not_of(" \t\r") != std::string::npos) {
+				Request request;
+				request.connection = connection;
+				request.line.swap(line);
+				request.receiveTime = Clock::now();
+				connection->addPendingRequest();
+				queue.push(std::move(request));
+			}
+			line.clear();
+			skipLine = false;
+		}
+	}
+
+	connection->waitForClose();
+}
+
+void
+workerThread(Worker& worker, RequestQueue& queue, Statistics& statistics)
+{
+	Request request;
+	while (queue.pop(request)) {
+		worker.process(request, statistics);
+		request.connection->removePendingRequest();
+		request.connection.reset();
+	}
+}
+
+// Each connection uses a reader thread and a writer thread. The connections
+// above the limit are refused.
+void
+acceptConnections(const char* socketPath, unsigned int maxConnections, RequestQueue& queue)
+{
+	const int serverFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (serverFd < 0) {
+		THROW_EXCEPTION(GS::IOException, "Could not create the socket: " << std::strerror(errno) << '.');
+	}
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof address);
+	address.sun_family = AF_UNIX;
+	if (std::strlen(socketPath) >= sizeof address.sun_path) {
+		close(serverFd);
+		THROW_EXCEPTION(GS::InvalidParameterException, "The socket path is too long: " << socketPath << '.');
+	}
+	std::strcpy(address.sun_path, socketPath);
+	unlink(socketPath);
+	// The umask prevents connections before chmod.
+	const mode_t oldMask = umask(~SOCKET_MODE & 0777);
+	const bool bound = bind(serverFd, reinterpret_cast<sockaddr*>(&address), sizeof address) == 0;
+	const int bindError = errno;
+	umask(oldMask);
+	if (!bound || chmod(socketPath, SOCKET_MODE) != 0 || listen(serverFd, SOMAXCONN) != 0) {
+		const int error = bound ? errno : bindError;
+		close(serverFd);
+		THROW_EXCEPTION(GS::IOException, "Could not listen on the socket " << socketPath << ": " << std::strerror(error) << '.');
+	}
+
+	static std::atomic<unsigned int> numConnections(0); // used by the detached threads
+	for (;;) {
+		const int fd = accept(serverFd, nullptr, nullptr);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) continue;
+			const int error = errno;
+			close(serverFd);
+			THROW_EXCEPTION(GS::IOException, "Could not accept a connection: " << std::strerror(error) << '.');
+		}
+		if (numConnections >= maxConnections) {
+			static const char response[] = "{\"id\":\"\",\"status\":\"error\",\"message\":\"Too many connections.\"}\n";
+			send(fd, response, sizeof response - 1, MSG_DONTWAIT); // the connection is closed anyway
+			close(fd);
+			continue;
+		}
+		++numConnections;
+		std::thread([fd, &queue] {
+			readRequests(std::make_shared<Connection>(fd, fd, true), queue);
+			--numConnections;
+		}).detach();
+	}
+}
+
+void
+showUsage(const char* programName)
+{
+	std::cout << "\nGnuspeechSA server " << PROGRAM_VERSION << "\n\n";
+	std::cout << "Usage:\n\n";
+	std::cout << programName << " -c config_dir [-t threads] [-q queue_size] [-d timeout] [-o output_dir]\n"
+			"        [-s socket_path [-m max_connections]]\n";
+	std::cout << "        Synthesizes the requests received in standard input (one JSON object per line),\n";
+	std::cout << "        or in the connections to a Unix domain socket.\n";
+	std::cout << "        -t : number of worker threads (default: number of CPUs)\n";
+	std::cout << "        -q : maximum number of queued requests (default: " << DEFAULT_QUEUE_SIZE << ")\n";
+	std::cout << "        -d : timeout in seconds of the requests without \"timeout\" (default: none)\n";
+	std::cout << "        -o : directory of the files requested with \"output\" (default: output to files disabled)\n";
+	std::cout << "        -s : the socket is created with access only for the owner\n";
+	std::cout << "        -m : maximum number of simultaneous connections (default: " << DEFAULT_MAX_CONNECTIONS << ")\n" << std::endl;
+}
+
+bool
+parseUnsigned(const char* s, unsigned int& value)
+{
+	char* end;
+	const unsigned long v = std::strtoul(s, &end, 10);
+	if (*s == '\0' || *end != '\0' || v == 0 || v > 4096) {
+		return false;
+	}
+	value = v;
+	return true;
+}
+
+bool
+parseSeconds(const char* s, double& value)
+{
+	char* end;
+	const double v = std::strtod(s, &end);
+	if (*s == '\0' || *end != '\0' || !(v >= 0.0) || !std::isfinite(v)) {
+		return false;
+	}
+	value = v;
+	return true;
+}
+
+} /* namespace */
+
+int
+main(int argc, char* argv[])
+{
+	const char* configDirPath = nullptr;
+	const char* socketPath = nullptr;
+	const char* outputDirPath = nullptr;
+	unsigned int maxConnections = DEFAULT_MAX_CONNECTIONS;
+	unsigned int numThreads = std::thread::hardware_concurrency();
+	unsigned int queueSize = DEFAULT_QUEUE_SIZE;
+	double defaultTimeout = 0.0;
+	if (numThreads == 0) {
+		numThreads = 1;
+	}
+
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 == argc) {
+			showUsage(argv[0]);
+			return 1;
+		}
+		if (strcmp(argv[i], "-c") == 0) {
+			configDirPath = argv[++i];
+		} else if (strcmp(argv[i], "-s") == 0) {
+			socketPath = argv[++i];
+		} else if (strcmp(argv[i], "-o") == 0) {
+			outputDirPath = argv[++i];
+		} else if (strcmp(argv[i], "-m") == 0) {
+			if (!parseUnsigned(argv[++i], maxConnections)) {
+				showUsage(argv[0]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-t") == 0) {
+			if (!parseUnsigned(argv[++i], numThreads)) {
+				showUsage(argv[0]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-q") == 0) {
+			if (!parseUnsigned(argv[++i], queueSize)) {
+				showUsage(argv[0]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-d") == 0) {
+			if (!parseSeconds(argv[++i], defaultTimeout)) {
+				showUsage(argv[0]);
+				return 1;
+			}
+		} else {
+			showUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (configDirPath == nullptr) {
+		showUsage(argv[0]);
+		return 1;
+	}
+
+	// Write errors are reported by write().
+	signal(SIGPIPE, SIG_IGN);
+
+	try {
+		GS::TRMControlModel::Configuration trmControlConfig;
+		trmControlConfig.load(std::string(configDirPath) + TRM_CONTROL_MODEL_CONFIGURATION_FILE);
+		GS::TRMControlModel::Model trmControlModel;
+		trmControlModel.setBinaryCacheEnabled(trmControlConfig.modelCacheEnabled);
+		trmControlModel.load(configDirPath, TRM_CONTROL_MODEL_CONFIG_FILE);
+
+		std::unique_ptr<GS::En::TextParser> textParser(new GS::En::TextParser(configDirPath,
+									trmControlConfig.dictionary1File,
+									trmControlConfig.dictionary2File,
+									trmControlConfig.dictionary3File));
+		textParser->setModel(trmControlModel);
+
+		GS::TRMControlModel::VoiceSet voiceSet(configDirPath);
+
+		std::vector<std::unique_ptr<Worker>> workerList;
+		for (unsigned int i = 0; i < numThreads; ++i) {
+			workerList.emplace_back(new Worker(configDirPath, trmControlModel, *textParser, voiceSet, defaultTimeout, outputDirPath));
+		}
+
+		RequestQueue queue(queueSize);
+		Statistics statistics;
+		std::vector<std::thread> threadList;
+		for (auto& worker : workerList) {
+			threadList.emplace_back(workerThread, std::ref(*worker), std::ref(queue), std::ref(statistics));
+		}
+		std::cerr << "Ready (" << numThreads << " worker threads)." << std::endl;
+
+		if (socketPath != nullptr) {
+			acceptConnections(socketPath, maxConnections, queue);
+		} else {
+			readRequests(std::make_shared<Connection>(STDIN_FILENO, STDOUT_FILENO, false), queue);
+		}
+
+		queue.close();
+		for (auto& thread : threadList) {
+			thread.join();
+		}
+
+		std::cerr << "Requests: " << statistics.requests << "  Errors: " << statistics.errors
+			<< "  Cancelled: " << statistics.cancelled
+			<< "  Audio: " << statistics.audioSeconds << " s";
+		if (statistics.requests > 0) {
+			std::cerr << "  Mean latency: " << statistics.totalMilliseconds / statistics.requests << " ms"
+				<< "  Max latency: " << statistics.maxMilliseconds << " ms";
+		}
+		std::cerr << std::endl;
+	} catch (std::exception& e) {
+		std::cerr << "Caught an exception: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,286 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "gnuspeechsa.h"
+
+#include <algorithm> /* min */
+#include <chrono>
+#include <cmath> /* isnan */
+#include <cstring> /* strlen, strspn */
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CancellationToken.h"
+#include "Exception.h"
+#include "global.h"
+#include "Model.h"
+#include "TRMControlModelConfiguration.h"
+#include "VoiceSet.h"
+#include "en/Synthesizer.h"
+#include "en/text_parser/TextParser.h"
+
+
+
+struct gs_engine {
+	std::string configDirPath;
+	GS::TRMControlModel::Model model;
+	std::unique_ptr<GS::En::TextParser> textParser;
+	std::unique_ptr<GS::TRMControlModel::VoiceSet> voiceSet;
+};
+
+struct gs_session {
+	explicit gs_session(const gs_engine& engine)
+			: synthesizer(engine.configDirPath.c_str(), engine.model, *engine.textParser, *engine.voiceSet)
+			, parameters(synthesizer.defaultParameters())
+			, timeout(0.0) {
+		synthesizer.setCancellationToken(&cancellationToken);
+	}
+
+	GS::CancellationToken cancellationToken;
+	GS::En::Synthesizer synthesizer;
+	GS::En::Synthesizer::Parameters parameters;
+	double timeout; // seconds
+	std::vector<float> buffer;
+};
+
+namespace {
+
+const std::size_t BLOCK_FRAMES = 4096;
+const char* const VOICE_NAME_CHARACTERS = "abcdefghijklmnopqrstuvwxyz_";
+
+thread_local std::string lastError;
+
+// The location of the exception is removed.
+void
+setError(const char* message)
+{
+	lastError = message;
+	const std::size_t pos = lastError.find('\n');
+	if (pos != std::string::npos) {
+		lastError.resize(pos);
+	}
+}
+
+int
+invalidArgument()
+{
+	setError("Invalid argument.");
+	return GS_INVALID_ARGUMENT;
+}
+
+} /* namespace */
+
+int
+gs_api_version(void)
+{
+	return GS_API_VERSION;
+}
+
+const char*
+gs_last_error(void)
+{
+	return lastError.c_str();
+}
+
+gs_engine*
+gs_engine_create(const char* config_dir)
+{
+	if (config_dir == nullptr) {
+		invalidArgument();
+		return nullptr;
+	}
+	try {
+		std::unique_ptr<gs_engine> engine(new gs_engine());
+		engine->configDirPath = config_dir;
+		GS::TRMControlModel::Configuration trmControlConfig;
+		trmControlConfig.load(engine->configDirPath + TRM_CONTROL_MODEL_CONFIGURATION_FILE);
+		engine->model.setBinaryCacheEnabled(trmControlConfig.modelCacheEnabled);
+		engine->model.load(config_dir, TRM_CONTROL_MODEL_CONFIG_FILE);
+		engine->textParser.reset(new GS::En::TextParser(config_dir,
+							trmControlConfig.dictionary1File,
+							trmControlConfig.dictionary2File,
+							trmControlConfig.dictionary3File));
+		engine->textParser->setModel(engine->model);
+		if (trmControlConfig.pronunciationCacheFile != "none") {
+			engine->textParser->loadPronunciationCache(engine->configDirPath + '/' + trmControlConfig.pronunciationCacheFile);
+		}
+		engine->voiceSet.reset(new GS::TRMControlModel::VoiceSet(config_dir));
+		return engine.release();
+	} catch (std::exception& e) {
+		setError(e.what());
+	} catch (...) {
+		setError("Unknown error.");
+	}
+	return nullptr;
+}
+
+void
+gs_engine_destroy(gs_engine* engine)
+{
+	delete engine;
+}
+
+gs_session*
+gs_session_create(gs_engine* engine)
+{
+	if (engine == nullptr) {
+		invalidArgument();
+		return nullptr;
+	}
+	try {
+		return new gs_session(*engine);
+	} catch (std::exception& e) {
+		setError(e.what());
+	} catch (...) {
+		setError("Unknown error.");
+	}
+	return nullptr;
+}
+
+void
+gs_session_destroy(gs_session* session)
+{
+	delete session;
+}
+
+int
+gs_session_set_voice(gs_session* session, const char* voice_name)
+{
+	if (session == nullptr || voice_name == nullptr) {
+		return invalidArgument();
+	}
+	// The name is used in the path of the voice file.
+	const std::size_t nameLength = std::strlen(voice_name);
+	if (nameLength == 0 || std::strspn(voice_name, VOICE_NAME_CHARACTERS) != nameLength) {
+		setError("Invalid voice name.");
+		return GS_INVALID_ARGUMENT;
+	}
+	try {
+		session->parameters.voiceName = voice_name;
+	} catch (...) {
+		setError("Could not allocate memory.");
+		return GS_ERROR;
+	}
+	return GS_OK;
+}
+
+int
+gs_session_set_tempo(gs_session* session, double tempo)
+{
+	if (session == nullptr || !(tempo > 0.0)) {
+		return invalidArgument();
+	}
+	session->parameters.tempo = tempo;
+	return GS_OK;
+}
+
+int
+gs_session_set_pitch_offset(gs_session* session, double pitch_offset)
+{
+	if (session == nullptr || std::isnan(pitch_offset)) {
+		return invalidArgument();
+	}
+	session->parameters.pitchOffset = pitch_offset;
+	return GS_OK;
+}
+
+int
+gs_session_set_latency_first(gs_session* session, int enabled)
+{
+	if (session == nullptr) {
+		return invalidArgument();
+	}
+	session->synthesizer.setLatencyFirst(enabled != 0);
+	return GS_OK;
+}
+
+int
+gs_session_set_timeout(gs_session* session, double seconds)
+{
+	if (session == nullptr || !(seconds >= 0.0)) {
+		return invalidArgument();
+	}
+	session->timeout = seconds;
+	return GS_OK;
+}
+
+int
+gs_synthesize(gs_session* session, const char* text, gs_audio_callback callback, void* user)
+{
+	if (session == nullptr || text == nullptr || callback == nullptr) {
+		return invalidArgument();
+	}
+	GS::CancellationToken& token = session->cancellationToken;
+	if (token.reset()) {
+		setError("Cancelled.");
+		return GS_CANCELLED;
+	}
+	int status;
+	try {
+		if (session->timeout > 0.0) {
+			token.setDeadline(GS::CancellationToken::Clock::now() +
+				std::chrono::duration_cast<GS::CancellationToken::Clock::duration>(
+					std::chrono::duration<double>(session->timeout)));
+		}
+		GS::En::Synthesizer& synthesizer = session->synthesizer;
+		synthesizer.setParameters(session->parameters);
+		const bool completed = synthesizer.synthesizeSegments(text, session->buffer,
+			[&](const std::vector<float>& buffer) -> bool {
+				const int channels = synthesizer.channels();
+				const int sampleRate = static_cast<int>(synthesizer.outputRate());
+				const std::size_t numFrames = buffer.size() / channels;
+				for (std::size_t pos = 0; pos < numFrames; pos += BLOCK_FRAMES) {
+					token.check();
+					if (callback(buffer.data() + pos * channels, std::min(BLOCK_FRAMES, numFrames - pos),
+							channels, sampleRate, user) != 0) {
+						return false;
+					}
+				}
+				return true;
+			});
+		if (completed) {
+			status = GS_OK;
+		} else {
+			setError("Cancelled by the callback.");
+			status = GS_CANCELLED;
+		}
+	} catch (GS::DeadlineExceededException& e) {
+		setError(e.what());
+		status = GS_TIMEOUT;
+	} catch (GS::CancelledException& e) {
+		setError(e.what());
+		status = GS_CANCELLED;
+	} catch (std::exception& e) {
+		setError(e.what());
+		status = GS_ERROR;
+	} catch (...) {
+		setError("Unknown error.");
+		status = GS_ERROR;
+	}
+	token.reset();
+	return status;
+}
+
+void
+gs_session_cancel(gs_session* session)
+{
+	if (session != nullptr) {
+		session->cancellationToken.cancel();
+	}
+}
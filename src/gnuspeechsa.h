@@ -0,0 +1,119 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+/*
+ * C API of the library.
+ *
+ * An engine contains the model, the dictionaries and the voices, loaded once
+ * from a configuration directory. It may be shared by many sessions. Each
+ * session synthesizes one text at a time, and must not be used by more than
+ * one thread at a time, except for gs_session_cancel. The sessions must be
+ * destroyed before the engine.
+ *
+ * The functions do not throw exceptions. When a function fails, the error
+ * message can be obtained with gs_last_error, in the same thread.
+ */
+
+#ifndef GNUSPEECHSA_H_
+#define GNUSPEECHSA_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Incremented when the API changes in an incompatible way. */
+#define GS_API_VERSION 1
+
+typedef struct gs_engine gs_engine;
+typedef struct gs_session gs_session;
+
+enum gs_status {
+	GS_OK               =  0,
+	GS_CANCELLED        =  1,
+	GS_TIMEOUT          =  2,
+	GS_ERROR            = -1,
+	GS_INVALID_ARGUMENT = -2
+};
+
+/*
+ * Receives a block of samples, in the range [-1.0, 1.0]. If the output has two
+ * channels, the samples are interleaved. The block is valid only during the
+ * call. Returns 0 to continue the synthesis, or another value to cancel it.
+ */
+typedef int (*gs_audio_callback)(const float* samples, size_t num_frames,
+					int channels, int sample_rate, void* user);
+
+/* Returns GS_API_VERSION of the library. */
+int gs_api_version(void);
+
+/* Returns the message of the last error in the calling thread. */
+const char* gs_last_error(void);
+
+/* Returns NULL on error. */
+gs_engine* gs_engine_create(const char* config_dir);
+void gs_engine_destroy(gs_engine* engine);
+
+/* Returns NULL on error. */
+gs_session* gs_session_create(gs_engine* engine);
+void gs_session_destroy(gs_session* session);
+
+/*
+ * The parameters are used by the next calls to gs_synthesize. The voice name
+ * may contain only the characters a-z and '_'.
+ */
+int gs_session_set_voice(gs_session* session, const char* voice_name);
+int gs_session_set_tempo(gs_session* session, double tempo);
+int gs_session_set_pitch_offset(gs_session* session, double pitch_offset);
+
+/*
+ * Each call to gs_synthesize returns GS_TIMEOUT if it has not finished after
+ * the given number of seconds. 0 (the default) disables the timeout.
+ */
+int gs_session_set_timeout(gs_session* session, double seconds);
+
+/*
+ * If enabled, the first tone group of each text is synthesized and passed to
+ * the callback before the rest of the first sentence, which reduces the time
+ * to the first block. Disabled by default.
+ */
+int gs_session_set_latency_first(gs_session* session, int enabled);
+
+/*
+ * Synthesizes the text sentence by sentence. The blocks of each sentence are
+ * passed to the callback as soon as the sentence has been synthesized. All
+ * the sentences are scaled by the same factor, which depends on the voice;
+ * the first call with a voice also synthesizes a short calibration text.
+ *
+ * Returns GS_OK, GS_CANCELLED, GS_TIMEOUT, GS_ERROR or GS_INVALID_ARGUMENT.
+ */
+int gs_synthesize(gs_session* session, const char* text, gs_audio_callback callback, void* user);
+
+/*
+ * May be called by any thread. The current call to gs_synthesize of the
+ * session stops at the next chunk, rule application or block of samples, and
+ * returns GS_CANCELLED. If the session is not synthesizing, the next call is
+ * cancelled.
+ */
+void gs_session_cancel(gs_session* session);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GNUSPEECHSA_H_ */
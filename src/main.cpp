@@ -15,6 +15,10 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
  ***************************************************************************/
 
+#include <algorithm> /* any_of, max */
+#include <chrono>
+#include <cmath> /* abs */
+#include <cstdlib>
 #include <cstring>
 #include <exception>
 #include <fstream>
@@ -22,18 +26,79 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "batch/BatchResources.h"
+#include "batch/BatchSynthesis.h"
 #include "Controller.h"
 #include "Exception.h"
 #include "global.h"
 #include "Log.h"
 #include "Model.h"
+#include "WAVEFileWriter.h"
 #include "en/phonetic_string_parser/PhoneticStringParser.h"
+#include "en/RealTimeSynthesizer.h"
+#include "en/Synthesizer.h"
 #include "en/text_parser/TextParser.h"
+#include "en/text_parser/TextSegmenter.h"
 #include "TRMControlModelConfiguration.h"
+#include "Tube.h"
+#include "VoiceSet.h"
 
 
 
+namespace {
+
+const double REAL_TIME_BUFFER_SECONDS = 2.0;
+const std::size_t REAL_TIME_BLOCK_FRAMES = 256;
+
+/*******************************************************************************
+ * Simulates a real-time consumer, e.g. an audio callback, that pulls blocks of
+ * samples at the output rate, using the system clock. The pulled samples,
+ * including the silence inserted in the underruns, are written to the file.
+ */
+int
+synthesizeRealTime(const char* configDirPath, const std::string& text, const char* outputFile, bool latencyFirst)
+{
+	GS::BatchResources resources;
+	resources.load(configDirPath);
+	const GS::TRMControlModel::VoiceSet voiceSet(configDirPath);
+	GS::En::RealTimeSynthesizer synthesizer(configDirPath, resources.model, *resources.textParser, voiceSet,
+							REAL_TIME_BUFFER_SECONDS);
+	synthesizer.setLatencyFirst(latencyFirst);
+	const int channels = synthesizer.channels();
+	const double blockSeconds = REAL_TIME_BLOCK_FRAMES / static_cast<double>(synthesizer.outputRate());
+
+	std::vector<float> block(REAL_TIME_BLOCK_FRAMES * channels);
+	std::vector<float> buffer;
+	double firstAudioSeconds = -1.0;
+	const auto startTime = std::chrono::steady_clock::now();
+	synthesizer.speak(text);
+	for (unsigned long n = 1; !synthesizer.idle(); ++n) {
+		synthesizer.pull(block.data(), REAL_TIME_BLOCK_FRAMES);
+		buffer.insert(buffer.end(), block.begin(), block.end());
+		if (firstAudioSeconds < 0.0 && std::any_of(block.begin(), block.end(), [](float s) { return s != 0.0f; })) {
+			firstAudioSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		}
+		std::this_thread::sleep_until(startTime + std::chrono::duration<double>(n * blockSeconds));
+	}
+	synthesizer.stop();
+
+	GS::WAVEFileWriter::writeFile(outputFile, buffer, channels, synthesizer.outputRate());
+
+	const GS::En::RealTimeSynthesizer::Statistics statistics = synthesizer.statistics();
+	std::cout << "Frames: " << statistics.pulledFrames << "  Block: " << REAL_TIME_BLOCK_FRAMES << " frames\n"
+		<< "Underruns: " << statistics.underruns << "  Underrun frames: " << statistics.underrunFrames
+		<< "  Late sentences: " << statistics.lateSegments << '\n'
+		<< "First audio: " << firstAudioSeconds * 1000.0 << " ms  (synthesized after "
+		<< statistics.meanFirstAudioLatency * 1000.0 << " ms)" << std::endl;
+
+	return (statistics.errors == 0) ? 0 : 1;
+}
+
+} /* namespace */
+
 void
 showUsage(const char* programName)
 {
@@ -41,12 +106,28 @@ showUsage(const char* programName)
 	std::cout << "Usage:\n\n";
 	std::cout << programName << " --version\n";
 	std::cout << "        Shows the program version.\n\n";
-	std::cout << programName << " [-v] -c config_dir -p trm_param_file.txt -o output_file.wav \"Hello world.\"\n";
+	std::cout << programName << " [-v] -c config_dir [-t threads] -p trm_param_file.txt -o output_file.wav \"Hello world.\"\n";
 	std::cout << "        Synthesizes text from the command line.\n";
+	std::cout << "        -t : number of threads used to synthesize the parts between silences\n";
+	std::cout << "             (the result may differ from the serial synthesis by rounding errors)\n";
+	std::cout << "        -v : verbose\n\n";
+	std::cout << programName << " [-v] -c config_dir [-t threads] -i input_text.txt -p trm_param_file.txt -o output_file.wav\n";
+	std::cout << "        Synthesizes text from a file (\"-\": standard input).\n";
+	std::cout << "        -t : number of threads used to synthesize the parts between silences\n";
+	std::cout << "        -v : verbose\n\n";
+	std::cout << programName << " [-v] -c config_dir [--processes n] [-t threads] [--index index.tsv] --batch manifest.tsv\n";
+	std::cout << "        Synthesizes many texts. Each line of the manifest contains an id, the text\n";
+	std::cout << "        and the output WAV file, separated by tabs.\n";
+	std::cout << "        --processes : number of worker processes (default: 1)\n";
+	std::cout << "        -t : number of threads per process (default: number of CPUs / processes)\n";
+	std::cout << "        --index : the finished utterances are added to this file, and are skipped\n";
+	std::cout << "                  in the next runs\n";
 	std::cout << "        -v : verbose\n\n";
-	std::cout << programName << " [-v] -c config_dir -i input_text.txt -p trm_param_file.txt -o output_file.wav\n";
-	std::cout << "        Synthesizes text from a file.\n";
-	std::cout << "        -v : verbose\n" << std::endl;
+	std::cout << programName << " -c config_dir --realtime [--latency-first] -o output_file.wav (-i input_text.txt | \"Hello world.\")\n";
+	std::cout << "        Plays the synthesis to a simulated real-time output, and shows the\n";
+	std::cout << "        underruns. The output file receives the samples that would be played.\n";
+	std::cout << "        --latency-first : synthesizes the first tone group separately, to\n";
+	std::cout << "                          start the audio sooner\n" << std::endl;
 }
 
 int
@@ -61,7 +142,14 @@ main(int argc, char* argv[])
 	const char* inputFile = nullptr;
 	const char* outputFile = nullptr;
 	const char* trmParamFile = nullptr;
+	const char* manifestFile = nullptr;
+	const char* indexFile = nullptr;
+	unsigned int numThreads = 0;
+	unsigned int numProcesses = 0;
+	bool realTime = false;
+	bool latencyFirst = false;
 	std::ostringstream inputTextStream;
+	bool hasInputText = false;
 
 	int i = 1;
 	while (i < argc) {
@@ -100,6 +188,44 @@ main(int argc, char* argv[])
 			}
 			outputFile = argv[i];
 			++i;
+		} else if (strcmp(argv[i], "-t") == 0) {
+			++i;
+			if (i == argc || std::atoi(argv[i]) <= 0) {
+				showUsage(argv[0]);
+				return 1;
+			}
+			numThreads = std::atoi(argv[i]);
+			++i;
+		} else if (strcmp(argv[i], "--batch") == 0) {
+			++i;
+			if (i == argc) {
+				showUsage(argv[0]);
+				return 1;
+			}
+			manifestFile = argv[i];
+			++i;
+		} else if (strcmp(argv[i], "--index") == 0) {
+			++i;
+			if (i == argc) {
+				showUsage(argv[0]);
+				return 1;
+			}
+			indexFile = argv[i];
+			++i;
+		} else if (strcmp(argv[i], "--processes") == 0) {
+			++i;
+			if (i == argc || std::atoi(argv[i]) <= 0) {
+				showUsage(argv[0]);
+				return 1;
+			}
+			numProcesses = std::atoi(argv[i]);
+			++i;
+		} else if (strcmp(argv[i], "--realtime") == 0) {
+			++i;
+			realTime = true;
+		} else if (strcmp(argv[i], "--latency-first") == 0) {
+			++i;
+			latencyFirst = true;
 		} else if (strcmp(argv[i], "--version") == 0) {
 			++i;
 			showUsage(argv[0]);
@@ -108,36 +234,101 @@ main(int argc, char* argv[])
 			for ( ; i < argc; ++i) {
 				inputTextStream << argv[i] << ' ';
 			}
+			hasInputText = true;
 		}
 	}
 
-	if (configDirPath == nullptr || trmParamFile == nullptr || outputFile == nullptr) {
+	if (manifestFile != nullptr) {
+		if (configDirPath == nullptr || inputFile != nullptr || hasInputText ||
+				trmParamFile != nullptr || outputFile != nullptr || realTime || latencyFirst) {
+			showUsage(argv[0]);
+			return 1;
+		}
+#ifdef GS_NO_WORKER_PROCESSES
+		if (numProcesses > 1) {
+			std::cerr << "Worker processes are not supported on this platform." << std::endl;
+			return 1;
+		}
+#endif
+		if (numProcesses == 0) {
+			numProcesses = 1;
+		}
+		if (numThreads == 0) {
+			numThreads = std::max(std::thread::hardware_concurrency() / numProcesses, 1U);
+		}
+		try {
+			return GS::synthesizeBatch(configDirPath, manifestFile, indexFile, numProcesses, numThreads);
+		} catch (std::exception& e) {
+			std::cerr << "Caught an exception: " << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	if (realTime) {
+		if (configDirPath == nullptr || trmParamFile != nullptr || outputFile == nullptr ||
+				(inputFile != nullptr) == hasInputText || indexFile != nullptr || numProcesses != 0 || numThreads != 0) {
+			showUsage(argv[0]);
+			return 1;
+		}
+		std::string text = inputTextStream.str();
+		if (inputFile != nullptr) {
+			std::ifstream inputFileIn;
+			if (strcmp(inputFile, "-") != 0) {
+				inputFileIn.open(inputFile, std::ios_base::in | std::ios_base::binary);
+				if (!inputFileIn) {
+					std::cerr << "Could not open the file " << inputFile << '.' << std::endl;
+					return 1;
+				}
+			}
+			std::ostringstream textOut;
+			textOut << (strcmp(inputFile, "-") == 0 ? std::cin.rdbuf() : inputFileIn.rdbuf());
+			text = textOut.str();
+		}
+		try {
+			return synthesizeRealTime(configDirPath, text, outputFile, latencyFirst);
+		} catch (std::exception& e) {
+			std::cerr << "Caught an exception: " << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	if (configDirPath == nullptr || trmParamFile == nullptr || outputFile == nullptr ||
+			(inputFile != nullptr && hasInputText) || indexFile != nullptr || numProcesses != 0 || latencyFirst) {
 		showUsage(argv[0]);
 		return 1;
 	}
 
-	if (inputFile != nullptr) {
-		std::ifstream in(inputFile, std::ios_base::in | std::ios_base::binary);
-		if (!in) {
+	// The text is read and parsed sentence by sentence.
+	std::istringstream inputTextIn;
+	std::ifstream inputFileIn;
+	std::istream* in = &inputTextIn;
+	if (inputFile == nullptr) {
+		inputTextIn.str(inputTextStream.str());
+	} else if (strcmp(inputFile, "-") == 0) {
+		in = &std::cin;
+	} else {
+		inputFileIn.open(inputFile, std::ios_base::in | std::ios_base::binary);
+		if (!inputFileIn) {
 			std::cerr << "Could not open the file " << inputFile << '.' << std::endl;
 			return 1;
 		}
-		std::string line;
-		while (std::getline(in, line)) {
-			inputTextStream << line << ' ';
-		}
+		in = &inputFileIn;
 	}
-	std::string inputText = inputTextStream.str();
-	if (inputText.empty()) {
+	GS::En::TextSegmenter textSegmenter(*in);
+	std::string inputText;
+	if (!textSegmenter.getSegment(inputText)) {
 		std::cerr << "Empty input text." << std::endl;
 		return 1;
 	}
-	if (GS::Log::debugEnabled) {
-		std::cout << "inputText=[" << inputText << ']' << std::endl;
-	}
 
 	try {
 		std::unique_ptr<GS::TRMControlModel::Model> trmControlModel(new GS::TRMControlModel::Model());
+		{
+			// The controller needs the model, and loads the configuration again.
+			GS::TRMControlModel::Configuration config;
+			config.load(std::string(configDirPath) + TRM_CONTROL_MODEL_CONFIGURATION_FILE);
+			trmControlModel->setBinaryCacheEnabled(config.modelCacheEnabled);
+		}
 		trmControlModel->load(configDirPath, TRM_CONTROL_MODEL_CONFIG_FILE);
 		if (GS::Log::debugEnabled) {
 			trmControlModel->printInfo();
@@ -150,14 +341,71 @@ main(int argc, char* argv[])
 											trmControlConfig.dictionary1File,
 											trmControlConfig.dictionary2File,
 											trmControlConfig.dictionary3File));
+		textParser->setModel(*trmControlModel);
 		std::unique_ptr<GS::En::PhoneticStringParser> phoneticStringParser(new GS::En::PhoneticStringParser(configDirPath, *trmController));
 
-		std::string phoneticString = textParser->parseText(inputText.c_str());
-		if (GS::Log::debugEnabled) {
-			std::cout << "Phonetic string: [" << phoneticString << ']' << std::endl;
+		std::string pronunciationCacheFile;
+		if (trmControlConfig.pronunciationCacheFile != "none") {
+			pronunciationCacheFile = std::string(configDirPath) + '/' + trmControlConfig.pronunciationCacheFile;
+			textParser->loadPronunciationCache(pronunciationCacheFile);
 		}
 
-		trmController->synthesizePhoneticString(*phoneticStringParser, phoneticString.c_str(), trmParamFile, outputFile);
+		GS::En::TextParser::Context textParserContext;
+		GS::En::PhoneticTokenList tokenList;
+		bool hasSegment = true;
+		auto nextTokenList = [&]() -> const GS::En::PhoneticTokenList* {
+			if (!hasSegment) {
+				return nullptr;
+			}
+			if (GS::Log::debugEnabled) {
+				std::cout << "inputText=[" << inputText << ']' << std::endl;
+			}
+			const std::string& phoneticString = textParser->parseText(inputText.c_str(), textParserContext, tokenList);
+			if (GS::Log::debugEnabled) {
+				std::cout << "Phonetic string: [" << phoneticString << ']' << std::endl;
+			}
+			hasSegment = textSegmenter.getSegment(inputText);
+			return &tokenList;
+		};
+		if (numThreads > 1) {
+			std::fstream trmParamStream(trmParamFile, std::ios_base::in | std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			if (!trmParamStream) {
+				std::cerr << "Could not open the file " << trmParamFile << '.' << std::endl;
+				return 1;
+			}
+			trmController->synthesizeTokenLists(*phoneticStringParser, nextTokenList, trmParamStream);
+
+			GS::TRM::Tube trm;
+			std::vector<float> buffer;
+			trm.synthesizeToBufferInParallel(trmParamStream, buffer, numThreads);
+			GS::WAVEFileWriter::writeFile(outputFile, buffer, trm.channels(), trm.outputRate());
+
+			if (GS::Log::debugEnabled) {
+				std::vector<float> serialBuffer;
+				trmParamStream.clear();
+				trmParamStream.seekg(0);
+				trm.synthesizeToBuffer(trmParamStream, serialBuffer);
+				float maxDeviation = 0.0;
+				for (std::size_t i = 0; i < buffer.size() && i < serialBuffer.size(); ++i) {
+					maxDeviation = std::max(maxDeviation, std::abs(buffer[i] - serialBuffer[i]));
+				}
+				std::cout << "Maximum deviation from the serial synthesis: " << maxDeviation
+					<< " (full scale: 1.0)" << std::endl;
+			}
+		} else {
+			trmController->synthesizeTokenLists(*phoneticStringParser, nextTokenList, trmParamFile, outputFile);
+		}
+
+		if (GS::Log::debugEnabled) {
+			textParser->printPronunciationCacheStatistics();
+		}
+		if (!pronunciationCacheFile.empty()) {
+			try {
+				textParser->savePronunciationCache(pronunciationCacheFile);
+			} catch (std::exception& e) {
+				std::cerr << "Could not save the pronunciation cache: " << e.what() << std::endl;
+			}
+		}
 
 	} catch (std::exception& e) {
 		std::cerr << "Caught an exception: " << e.what() << std::endl;
@@ -33,6 +33,9 @@ public:
 
 	void reset();
 	double getSample();
+
+	double seed() const { return seed_; }
+	void setSeed(double seed) { seed_ = seed; }
 private:
 	NoiseSource(const NoiseSource&) = delete;
 	NoiseSource& operator=(const NoiseSource&) = delete;
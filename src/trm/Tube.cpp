@@ -33,13 +33,18 @@
 
 #include "Tube.h"
 
+#include <algorithm> /* max, min */
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#include <exception>
 #include <fstream>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility> /* move */
 
 #include "Exception.h"
@@ -52,6 +57,7 @@
 
 #define INPUT_VECTOR_RESERVE 128
 #define OUTPUT_VECTOR_RESERVE 1024
+#define SEGMENT_FILE_BLOCK_SIZE 4096
 
 #define GLOTTAL_SOURCE_PULSE 0
 #define GLOTTAL_SOURCE_SINE 1
@@ -81,6 +87,9 @@ namespace GS {
 namespace TRM {
 
 Tube::Tube()
+		: referenceSampleValue_(0.0)
+		, cancellationToken_(nullptr)
+		, segmentFile_(nullptr)
 {
 	reset();
 
@@ -90,6 +99,9 @@ Tube::Tube()
 
 Tube::~Tube()
 {
+	if (segmentFile_ != nullptr) {
+		fclose(segmentFile_);
+	}
 }
 
 void
@@ -135,6 +147,10 @@ Tube::reset()
 	memset(&currentData_, 0, sizeof(CurrentData));
 	outputDataPos_ = 0;
 	outputData_.resize(0);
+	if (segmentFile_ != nullptr) {
+		fclose(segmentFile_);
+		segmentFile_ = nullptr;
+	}
 
 	if (srConv_) srConv_->reset();
 	if (mouthRadiationFilter_) mouthRadiationFilter_->reset();
@@ -151,7 +167,7 @@ Tube::reset()
 void
 Tube::synthesizeToFile(std::istream& inputStream, const char* outputFile)
 {
-	if (!outputData_.empty()) {
+	if (srConv_) {
 		reset();
 	}
 	parseInputStream(inputStream);
@@ -165,6 +181,424 @@ Tube::synthesizeToFile(std::istream& inputStream, const char* outputFile)
 	writeOutputToFile(outputFile);
 }
 
+void
+Tube::synthesizeToBuffer(std::istream& inputStream, std::vector<float>& outputBuffer)
+{
+	if (srConv_) {
+		reset();
+	}
+	parseInputStream(inputStream);
+	initializeSynthesizer();
+	synthesizeForInputSequence();
+	writeOutputToBuffer(outputBuffer);
+}
+
+/******************************************************************************
+*
+*  function:  synthesizeSegment
+*
+*  purpose:   Synthesizes the input tables of a segment of the
+*             utterance. The last input table is kept, to interpolate
+*             to the first table of the next segment, so the samples
+*             are the same as in the synthesis of the whole input.
+*
+******************************************************************************/
+void
+Tube::synthesizeSegment(std::istream& inputStream)
+{
+	if (segmentFile_ == nullptr) {
+		if (srConv_) {
+			reset();
+		}
+		parseInputHeader(inputStream);
+		initializeSynthesizer();
+
+		segmentFile_ = tmpfile();
+		if (segmentFile_ == nullptr) {
+			THROW_EXCEPTION(IOException, "Could not create a temporary file for the samples.");
+		}
+	}
+
+	parseInputTables(inputStream);
+	synthesizeForInputSequence();
+
+	/*  KEEP THE LAST INPUT TABLE  */
+	if (inputData_.size() > 1U) {
+		inputData_.erase(inputData_.begin(), inputData_.end() - 1);
+	}
+
+	writeOutputToSegmentFile();
+}
+
+/******************************************************************************
+*
+*  function:  finishSynthesisToFile
+*
+*  purpose:   Synthesizes the end of the last segment, and writes the
+*             samples of all the segments to the output file.
+*
+******************************************************************************/
+void
+Tube::finishSynthesisToFile(const char* outputFile)
+{
+	if (segmentFile_ == nullptr) {
+		THROW_EXCEPTION(InvalidStateException, "No segment has been synthesized.");
+	}
+
+	/*  DOUBLE UP THE LAST INPUT TABLE, TO HELP INTERPOLATION CALCULATIONS  */
+	if (!inputData_.empty()) {
+		std::unique_ptr<InputData> lastData(new InputData());
+		*lastData = *inputData_.back();
+		inputData_.push_back(std::move(lastData));
+		synthesizeForInputSequence();
+	}
+
+	writeOutputToFile(outputFile);
+
+	fclose(segmentFile_);
+	segmentFile_ = nullptr;
+}
+
+void
+Tube::synthesizeToBufferInParallel(std::istream& inputStream, std::vector<float>& outputBuffer, unsigned int numThreads)
+{
+	if (srConv_) {
+		reset();
+	}
+	parseInputStream(inputStream);
+	initializeSynthesizer();
+
+	std::vector<Part> partList;
+	findParts(numThreads, partList);
+	if (partList.size() < 2) {
+		synthesizeForInputSequence();
+		writeOutputToBuffer(outputBuffer);
+		return;
+	}
+	calculateSourceStates(partList);
+
+	/*  SYNTHESIZE THE PARTS AT THE INTERNAL SAMPLE RATE. THE PARTS ARE  */
+	/*  PASSED IN ORDER TO THE SAMPLE RATE CONVERTER BY THIS THREAD  */
+	const std::size_t numParts = partList.size();
+	const std::size_t maxPartsAhead = 2 * numThreads;
+	std::vector<std::vector<double>> outputList(numParts);
+	std::vector<std::vector<double>> tailList(numParts);
+	std::vector<char> doneList(numParts);
+	std::size_t nextPart = 0;
+	std::size_t convertedParts = 0;
+	std::exception_ptr exception;
+	std::mutex mutex;
+	std::condition_variable partDone;
+	std::condition_variable partConverted;
+	auto synthesizeParts = [&]() {
+		for (;;) {
+			std::size_t i;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				partConverted.wait(lock, [&]{ return nextPart < convertedParts + maxPartsAhead || exception; });
+				if (nextPart >= numParts || exception) break;
+				i = nextPart++;
+			}
+			try {
+				Tube partTube;
+				partTube.synthesizePart(*this, partList[i], outputList[i], tailList[i]);
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(mutex);
+				exception = std::current_exception();
+				partDone.notify_all();
+				partConverted.notify_all();
+				break;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			doneList[i] = 1;
+			partDone.notify_all();
+		}
+	};
+	std::vector<std::thread> threadList;
+	/*  IF THIS THREAD FAILS, THE PART THREADS ARE STOPPED AND JOINED  */
+	/*  BEFORE THE EXCEPTION IS RETHROWN  */
+	try {
+		for (unsigned int i = 0, end = std::min<std::size_t>(numThreads, numParts); i < end; ++i) {
+			threadList.emplace_back(synthesizeParts);
+		}
+
+		for (std::size_t i = 0; i < numParts; ++i) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				partDone.wait(lock, [&]{ return doneList[i] || exception; });
+				if (exception) break;
+			}
+			std::vector<double>& output = outputList[i];
+			if (i > 0) {
+				/*  ADD THE TAIL OF THE PREVIOUS PART  */
+				const std::vector<double>& tail = tailList[i - 1];
+				const std::size_t fadeBegin = tail.size() / 2;
+				const double fadeSize = tail.size() - fadeBegin;
+				for (std::size_t j = 0; j < fadeBegin; ++j) {
+					output[j] += tail[j];
+				}
+				for (std::size_t j = fadeBegin; j < tail.size(); ++j) {
+					output[j] += tail[j] * ((tail.size() - j) / fadeSize);
+				}
+				std::vector<double>().swap(tailList[i - 1]);
+			}
+			for (double sample : output) {
+				srConv_->dataFill(sample);
+			}
+			std::vector<double>().swap(output);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			convertedParts = i + 1;
+			partConverted.notify_all();
+		}
+	} catch (...) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!exception) {
+			exception = std::current_exception();
+		}
+		partConverted.notify_all();
+	}
+
+	for (auto& thread : threadList) {
+		thread.join();
+	}
+	if (exception) {
+		reset();
+		std::rethrow_exception(exception);
+	}
+
+	writeOutputToBuffer(outputBuffer);
+}
+
+/******************************************************************************
+*
+*  function:  findParts
+*
+*  purpose:   Splits the input in the middle of the silences, in parts
+*             of at least MIN_PART_FRAMES. The warm-up of each part,
+*             except the first, and the tail of each part, except the
+*             last, are also silent.
+*
+******************************************************************************/
+void
+Tube::findParts(unsigned int numThreads, std::vector<Part>& partList) const
+{
+	partList.clear();
+	const int size = inputData_.size();
+	if (numThreads < 2 || size < 2) {
+		return;
+	}
+	const int partFrames = std::max<int>(MIN_PART_FRAMES, size / (4 * numThreads));
+
+	Part part;
+	part.begin = 1;
+	part.outputBegin = 1;
+	part.glottalSourcePosition = 0.0;
+	part.noiseSeed = 0.0;
+	int silenceBegin = -1;
+	for (int pos = 0; pos <= size; ++pos) {
+		if (pos < size && isSilent(pos)) {
+			if (silenceBegin < 0) silenceBegin = pos;
+			continue;
+		}
+		if (silenceBegin >= 0 && pos - silenceBegin >= MIN_SILENCE_FRAMES && pos < size) {
+			/*  THE TRANSITIONS BETWEEN THE SILENT TABLES ARE SILENT  */
+			const int cut = silenceBegin + (pos - silenceBegin) / 2;
+			if (cut - part.outputBegin >= partFrames) {
+				part.end = cut;
+				part.tailEnd = cut + TAIL_FRAMES;
+				partList.push_back(part);
+				part.begin = cut - WARM_UP_FRAMES;
+				part.outputBegin = cut;
+			}
+		}
+		silenceBegin = -1;
+	}
+	if (!partList.empty()) {
+		part.end = size;
+		part.tailEnd = size;
+		partList.push_back(part);
+	}
+}
+
+/******************************************************************************
+*
+*  function:  calculateSourceStates
+*
+*  purpose:   Runs only the glottal source position and the noise
+*             source, like synthesizeForInputSequence, and stores
+*             their states at the start of each part. These states
+*             never converge, unlike the states of the filters, which
+*             are recovered during the warm-up.
+*
+******************************************************************************/
+void
+Tube::calculateSourceStates(std::vector<Part>& partList)
+{
+	double controlFreq = 1.0 / controlPeriod_;
+	std::size_t n = 0;
+	for (int i = 1; n < partList.size(); i++) {
+		while (n < partList.size() && partList[n].begin == i) {
+			partList[n].glottalSourcePosition = glottalSource_->position();
+			partList[n].noiseSeed = noiseSource_->seed();
+			++n;
+		}
+
+		double glotPitch = inputData_[i - 1]->glotPitch;
+		double glotPitchDelta = (inputData_[i]->glotPitch - glotPitch) * controlFreq;
+		for (int j = 0; j < controlPeriod_; j++) {
+			glottalSource_->skipSample(frequency(glotPitch));
+			noiseSource_->getSample();
+			glotPitch += glotPitchDelta;
+		}
+	}
+}
+
+bool
+Tube::isSilent(int pos) const
+{
+	const InputData& data = *inputData_[pos];
+	return data.glotVol <= 0.0 && data.aspVol <= 0.0 && data.fricVol <= 0.0;
+}
+
+void
+Tube::copyConfiguration(const Tube& other)
+{
+	outputRate_     = other.outputRate_;
+	controlRate_    = other.controlRate_;
+	volume_         = other.volume_;
+	channels_       = other.channels_;
+	balance_        = other.balance_;
+	waveform_       = other.waveform_;
+	tp_             = other.tp_;
+	tnMin_          = other.tnMin_;
+	tnMax_          = other.tnMax_;
+	breathiness_    = other.breathiness_;
+	length_         = other.length_;
+	temperature_    = other.temperature_;
+	lossFactor_     = other.lossFactor_;
+	apertureRadius_ = other.apertureRadius_;
+	mouthCoef_      = other.mouthCoef_;
+	noseCoef_       = other.noseCoef_;
+	for (int i = 0; i < TOTAL_NASAL_SECTIONS; i++) {
+		noseRadius_[i] = other.noseRadius_[i];
+	}
+	throatCutoff_   = other.throatCutoff_;
+	throatVol_      = other.throatVol_;
+	modulation_     = other.modulation_;
+	mixOffset_      = other.mixOffset_;
+}
+
+/******************************************************************************
+*
+*  function:  synthesizePart
+*
+*  purpose:   Synthesizes the part of the input of the source tube,
+*             starting with the source states of the part. The
+*             samples of the warm-up are discarded, and the samples
+*             of the tail are stored separately.
+*
+******************************************************************************/
+void
+Tube::synthesizePart(const Tube& source, const Part& part, std::vector<double>& output, std::vector<double>& tail)
+{
+	copyConfiguration(source);
+	cancellationToken_ = source.cancellationToken_;
+	for (int pos = part.begin - 1; pos <= part.tailEnd - 1; ++pos) {
+		std::unique_ptr<InputData> data(new InputData());
+		*data = *source.inputData_[pos];
+		inputData_.push_back(std::move(data));
+	}
+	initializeSynthesizer();
+	if (part.begin > 1) {
+		glottalSource_->setPosition(part.glottalSourcePosition);
+		noiseSource_->setSeed(part.noiseSeed);
+	}
+
+	output.resize((part.end - part.outputBegin) * controlPeriod_);
+	tail.resize((part.tailEnd - part.end) * controlPeriod_);
+	double* out = output.data();
+	for (int i = 1, size = inputData_.size(); i < size; i++) {
+		if (i == part.end - part.begin + 1) {
+			out = tail.data();
+		}
+		checkCancellation();
+		setControlRateParameters(i);
+		for (int j = 0; j < controlPeriod_; j++) {
+			double signal = synthesize();
+			if (i > part.outputBegin - part.begin) {
+				*out++ = signal;
+			}
+			sampleRateInterpolation();
+		}
+	}
+}
+
+/******************************************************************************
+*
+*  function:  checkCancellation
+*
+*  purpose:   Throws CancelledException or DeadlineExceededException
+*             if the synthesis has been cancelled. The tube is reset
+*             first, so that it can be reused.
+*
+******************************************************************************/
+void
+Tube::checkCancellation()
+{
+	if (cancellationToken_ != nullptr && cancellationToken_->cancelled()) {
+		reset();
+		cancellationToken_->check();
+		THROW_EXCEPTION(CancelledException, "Cancelled.");
+	}
+}
+
+/******************************************************************************
+*
+*  function:  writeOutputToBuffer
+*
+*  purpose:   Scales the samples like writeOutputToFile, and stores
+*             them in the buffer.
+*
+******************************************************************************/
+void
+Tube::writeOutputToBuffer(std::vector<float>& outputBuffer)
+{
+	/*  BE SURE TO FLUSH SRC BUFFER  */
+	srConv_->flushBuffer();
+
+	const double maximumValue = referenceSampleValue_ > 0.0 ? referenceSampleValue_ : srConv_->maximumSampleValue();
+	const unsigned int numberSamples = srConv_->numberSamples();
+	if (channels_ == 1) {
+		outputBuffer.resize(numberSamples);
+		float scale = calculateMonoScale(maximumValue);
+		for (unsigned int i = 0; i < numberSamples; ++i) {
+			outputBuffer[i] = outputData_[i] * scale;
+		}
+	} else {
+		outputBuffer.resize(numberSamples * 2U);
+		float leftScale, rightScale;
+		calculateStereoScale(maximumValue, leftScale, rightScale);
+		for (unsigned int i = 0; i < numberSamples; ++i) {
+			outputBuffer[2U * i]      = outputData_[i] * leftScale;
+			outputBuffer[2U * i + 1U] = outputData_[i] * rightScale;
+		}
+	}
+
+	/*  WITH A REFERENCE VALUE, THE PEAKS MAY EXCEED THE RANGE  */
+	if (referenceSampleValue_ > 0.0) {
+		for (float& sample : outputBuffer) {
+			sample = std::max(-1.0f, std::min(sample, 1.0f));
+		}
+	}
+}
+
+double
+Tube::maximumSampleValue() const
+{
+	return srConv_ ? srConv_->maximumSampleValue() : 0.0;
+}
+
 /******************************************************************************
 *
 *  function:  printInfo
@@ -276,6 +710,28 @@ Tube::printInfo(const char* inputFile)
 ******************************************************************************/
 void
 Tube::parseInputStream(std::istream& in)
+{
+	parseInputHeader(in);
+	parseInputTables(in);
+
+	/*  DOUBLE UP THE LAST INPUT TABLE, TO HELP INTERPOLATION CALCULATIONS  */
+	if (!inputData_.empty()) {
+		std::unique_ptr<InputData> lastData(new InputData());
+		*lastData = *inputData_.back();
+		inputData_.push_back(std::move(lastData));
+	}
+}
+
+/******************************************************************************
+*
+*  function:  parseInputHeader
+*
+*  purpose:   Parses the configuration at the start of the input
+*             stream.
+*
+******************************************************************************/
+void
+Tube::parseInputHeader(std::istream& in)
 {
 	std::string line;
 
@@ -428,6 +884,20 @@ Tube::parseInputStream(std::istream& in)
 	} else {
 		mixOffset_ = Text::parseString<double>(line);
 	}
+}
+
+/******************************************************************************
+*
+*  function:  parseInputTables
+*
+*  purpose:   Parses the input tables that follow the header, and
+*             appends them to the input data.
+*
+******************************************************************************/
+void
+Tube::parseInputTables(std::istream& in)
+{
+	std::string line;
 
 	/*  GET THE INPUT TABLE VALUES  */
 	unsigned int paramNumber = 0;
@@ -458,13 +928,6 @@ Tube::parseInputStream(std::istream& in)
 		inputData_.push_back(std::move(data));
 		++paramNumber;
 	}
-
-	/*  DOUBLE UP THE LAST INPUT TABLE, TO HELP INTERPOLATION CALCULATIONS  */
-	if (!inputData_.empty()) {
-		std::unique_ptr<InputData> lastData(new InputData());
-		*lastData = *inputData_.back();
-		inputData_.push_back(std::move(lastData));
-	}
 }
 
 /******************************************************************************
@@ -561,12 +1024,16 @@ Tube::synthesizeForInputSequence()
 {
 	/*  CONTROL RATE LOOP  */
 	for (int i = 1, size = inputData_.size(); i < size; i++) {
+		/*  STOP IF THE SYNTHESIS HAS BEEN CANCELLED  */
+		checkCancellation();
+
 		/*  SET CONTROL RATE PARAMETERS FROM INPUT TABLES  */
 		setControlRateParameters(i);
 
 		/*  SAMPLE RATE LOOP  */
 		for (int j = 0; j < controlPeriod_; j++) {
-			synthesize();
+			/*  OUTPUT SAMPLE HERE  */
+			srConv_->dataFill(synthesize());
 
 			/*  DO SAMPLE RATE INTERPOLATION OF CONTROL PARAMETERS  */
 			sampleRateInterpolation();
@@ -574,7 +1041,7 @@ Tube::synthesizeForInputSequence()
 	}
 }
 
-void
+double
 Tube::synthesize()
 {
 	/*  CONVERT PARAMETERS HERE  */
@@ -624,10 +1091,9 @@ Tube::synthesize()
 	/*  PUT PULSE THROUGH THROAT  */
 	signal += throat_->process(pulse * VT_SCALE);
 
-	/*  OUTPUT SAMPLE HERE  */
-	srConv_->dataFill(signal);
-
 	prevGlotAmplitude_ = ax;
+
+	return signal;
 }
 
 /******************************************************************************
@@ -972,34 +1438,79 @@ Tube::writeOutputToFile(const char* outputFile)
 
 	WAVEFileWriter fileWriter(outputFile, channels_, srConv_->numberSamples(), outputRate_);
 
+	float leftScale, rightScale;
 	if (channels_ == 1) {
-		float scale = calculateMonoScale();
-		for (unsigned int i = 0, end = srConv_->numberSamples(); i < end; ++i) {
-			fileWriter.writeSample(outputData_[i] * scale);
+		leftScale = rightScale = calculateMonoScale(srConv_->maximumSampleValue());
+	} else {
+		calculateStereoScale(srConv_->maximumSampleValue(), leftScale, rightScale);
+	}
+
+	/*  THE SAMPLES OF THE PREVIOUS SEGMENTS ARE IN THE TEMPORARY FILE  */
+	if (segmentFile_ != nullptr) {
+		std::vector<float> block(SEGMENT_FILE_BLOCK_SIZE);
+		rewind(segmentFile_);
+		std::size_t n;
+		while ((n = fread(block.data(), sizeof(float), block.size(), segmentFile_)) > 0) {
+			writeScaledSamples(fileWriter, block.data(), n, leftScale, rightScale);
+		}
+		if (ferror(segmentFile_)) {
+			THROW_EXCEPTION(IOException, "Could not read the temporary file of the samples.");
+		}
+	}
+	writeScaledSamples(fileWriter, outputData_.data(), outputData_.size(), leftScale, rightScale);
+}
+
+/******************************************************************************
+*
+*  function:  writeScaledSamples
+*
+*  purpose:   Scales the samples and writes them to the output file.
+*
+******************************************************************************/
+void
+Tube::writeScaledSamples(WAVEFileWriter& fileWriter, const float* data, std::size_t size, float leftScale, float rightScale)
+{
+	if (channels_ == 1) {
+		for (std::size_t i = 0; i < size; ++i) {
+			fileWriter.writeSample(data[i] * leftScale);
 		}
 	} else {
-		float leftScale, rightScale;
-		calculateStereoScale(leftScale, rightScale);
-		for (unsigned int i = 0, end = srConv_->numberSamples(); i < end; ++i) {
-			fileWriter.writeStereoSamples(outputData_[i] * leftScale, outputData_[i] * rightScale);
+		for (std::size_t i = 0; i < size; ++i) {
+			fileWriter.writeStereoSamples(data[i] * leftScale, data[i] * rightScale);
 		}
 	}
 }
 
+/******************************************************************************
+*
+*  function:  writeOutputToSegmentFile
+*
+*  purpose:   Moves the unscaled samples to the temporary file.
+*
+******************************************************************************/
+void
+Tube::writeOutputToSegmentFile()
+{
+	if (fwrite(outputData_.data(), sizeof(float), outputData_.size(), segmentFile_) != outputData_.size()) {
+		THROW_EXCEPTION(IOException, "Could not write the temporary file of the samples.");
+	}
+	outputData_.clear();
+}
+
 float
-Tube::calculateMonoScale()
+Tube::calculateMonoScale(double maximumValue)
 {
-	float scale = static_cast<float>((OUTPUT_SCALE / srConv_->maximumSampleValue()) * amplitude(volume_));
+	float scale = static_cast<float>((OUTPUT_SCALE / maximumValue) * amplitude(volume_));
 	LOG_DEBUG("\nScale: " << scale << '\n');
 	return scale;
 }
 
 void
-Tube::calculateStereoScale(float& leftScale, float& rightScale)
+Tube::calculateStereoScale(double maximumValue, float& leftScale, float& rightScale)
 {
 	leftScale = static_cast<float>(-((balance_ / 2.0) - 0.5));
 	rightScale = static_cast<float>(((balance_ / 2.0) + 0.5));
-	float newMax = static_cast<float>(srConv_->maximumSampleValue() * (balance_ > 0.0 ? rightScale : leftScale));
+	float newMax = static_cast<float>(maximumValue * (balance_ > 0.0 ? rightScale : leftScale));
 	float scale = static_cast<float>((OUTPUT_SCALE / newMax) * amplitude(volume_));
 	leftScale  *= scale;
 	rightScale *= scale;
@@ -22,11 +22,14 @@
 #define TRM_TUBE_H_
 
 #include <algorithm> /* max, min */
+#include <cstddef> /* std::size_t */
+#include <cstdio> /* FILE */
 #include <istream>
 #include <memory>
 #include <vector>
 
 #include "BandpassFilter.h"
+#include "CancellationToken.h"
 #include "NoiseFilter.h"
 #include "NoiseSource.h"
 #include "RadiationFilter.h"
@@ -41,6 +44,9 @@
 
 
 namespace GS {
+
+class WAVEFileWriter;
+
 namespace TRM {
 
 class Tube {
@@ -70,10 +76,50 @@ public:
 	~Tube();
 
 	void synthesizeToFile(std::istream& inputStream, const char* outputFile);
+	// The samples are scaled to the range [-1.0, 1.0]. Stereo samples are interleaved.
+	void synthesizeToBuffer(std::istream& inputStream, std::vector<float>& outputBuffer);
+	// Synthesizes in parallel the parts of the input that are separated by
+	// silences. Each part starts in the middle of a silence with a new tube,
+	// with the glottal source and noise source states of the serial synthesis.
+	// The previous part continues until near the end of the silence, and its
+	// decaying tail is added to the next part, with a fade-out. The result
+	// differs from the serial synthesis only by the rounding errors and the
+	// faded-out tails.
+	void synthesizeToBufferInParallel(std::istream& inputStream, std::vector<float>& outputBuffer, unsigned int numThreads);
+	// Incremental synthesis to a file. The input of each call to
+	// synthesizeSegment continues the input of the previous call, and only
+	// the first input contains the header. The samples are scaled over the
+	// whole utterance, so the unscaled samples of each segment are moved to a
+	// temporary file until finishSynthesisToFile writes the output file.
+	void synthesizeSegment(std::istream& inputStream);
+	void finishSynthesisToFile(const char* outputFile);
+
+	// These values are valid after the synthesis.
+	float outputRate() const { return outputRate_; }
+	int channels() const { return channels_; }
+	double maximumSampleValue() const;
+
+	// If value is greater than zero, the samples stored in the buffer are
+	// scaled as if value were the maximum sample value, and are clipped to
+	// the range [-1.0, 1.0], so separate utterances have the same gain.
+	// Otherwise the samples of each utterance are scaled by their own
+	// maximum value (the default).
+	void setReferenceSampleValue(double value) { referenceSampleValue_ = value; }
+
+	// The token is checked in each control period. If the synthesis is
+	// cancelled, the tube is reset before the exception is thrown.
+	// May be nullptr.
+	void setCancellationToken(const CancellationToken* token) { cancellationToken_ = token; }
 private:
 	enum {
 		VELUM = N1
 	};
+	enum { /*  PARALLEL SYNTHESIS (IN INPUT TABLES)  */
+		MIN_SILENCE_FRAMES = 20, /*  minimum silence where the input may be split  */
+		TAIL_FRAMES        = 8,  /*  must be less than MIN_SILENCE_FRAMES / 2  */
+		WARM_UP_FRAMES     = 8,  /*  must be less than MIN_SILENCE_FRAMES / 2  */
+		MIN_PART_FRAMES    = 250
+	};
 	enum { /*  OROPHARYNX SCATTERING JUNCTION COEFFICIENTS (BETWEEN EACH REGION)  */
 		C1 = R1, /*  R1-R2 (S1-S2)  */
 		C2 = R2, /*  R2-R3 (S2-S3)  */
@@ -125,6 +171,17 @@ private:
 		TOTAL_FRIC_COEFFICIENTS = 8
 	};
 
+	/*  TRANSITIONS [outputBegin, end) OF THE INPUT TABLES, PRECEDED BY THE  */
+	/*  WARM-UP [begin, outputBegin) AND FOLLOWED BY THE TAIL [end, tailEnd)  */
+	struct Part {
+		int begin;
+		int outputBegin;
+		int end;
+		int tailEnd;
+		double glottalSourcePosition; /*  source states at the start of begin  */
+		double noiseSeed;
+	};
+
 	struct InputData {
 		double glotPitch;
 		double glotVol;
@@ -169,14 +226,25 @@ private:
 	void initializeNasalCavity();
 	void printInfo(const char* inputFile);
 	void parseInputStream(std::istream& in);
+	void parseInputHeader(std::istream& in);
+	void parseInputTables(std::istream& in);
 	void sampleRateInterpolation();
 	void setControlRateParameters(int pos);
 	void setFricationTaps();
 	double vocalTract(double input, double frication);
 	void writeOutputToFile(const char* outputFile);
-	void synthesize();
-	float calculateMonoScale();
-	void calculateStereoScale(float& leftScale, float& rightScale);
+	void writeOutputToSegmentFile();
+	void writeScaledSamples(WAVEFileWriter& fileWriter, const float* data, std::size_t size, float leftScale, float rightScale);
+	double synthesize();
+	void writeOutputToBuffer(std::vector<float>& outputBuffer);
+	void copyConfiguration(const Tube& other);
+	bool isSilent(int pos) const;
+	void findParts(unsigned int numThreads, std::vector<Part>& partList) const;
+	void calculateSourceStates(std::vector<Part>& partList);
+	void synthesizePart(const Tube& source, const Part& part, std::vector<double>& output, std::vector<double>& tail);
+	void checkCancellation();
+	float calculateMonoScale(double maximumValue);
+	void calculateStereoScale(double maximumValue, float& leftScale, float& rightScale);
 
 	static double amplitude(double decibelLevel);
 	static double frequency(double pitch);
@@ -236,10 +304,13 @@ private:
 
 	double prevGlotAmplitude_;
 
+	double referenceSampleValue_;        /*  0 = scale by the maximum value  */
+	const CancellationToken* cancellationToken_;
 	std::vector<std::unique_ptr<InputData>> inputData_;
 	CurrentData currentData_;
 	std::size_t outputDataPos_;
 	std::vector<float> outputData_;
+	FILE* segmentFile_;                  /*  unscaled samples of the previous segments  */
 	std::unique_ptr<SampleRateConverter> srConv_;
 	std::unique_ptr<RadiationFilter> mouthRadiationFilter_;
 	std::unique_ptr<ReflectionFilter> mouthReflectionFilter_;
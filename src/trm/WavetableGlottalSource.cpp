@@ -196,6 +196,25 @@ WavetableGlottalSource::getSample(double frequency)  /*  PLAIN OSCILLATOR  */
 }
 #endif
 
+/******************************************************************************
+*
+*  function:  skipSample
+*
+*  purpose:   Increments the table position in the same steps as
+*             getSample.
+*
+******************************************************************************/
+void
+WavetableGlottalSource::skipSample(double frequency)
+{
+#if OVERSAMPLING_OSCILLATOR
+	incrementTablePosition(frequency / 2.0);
+	incrementTablePosition(frequency / 2.0);
+#else
+	incrementTablePosition(frequency);
+#endif
+}
+
 /******************************************************************************
 *
 *  function:  mod0
@@ -45,7 +45,12 @@ public:
 
 	void reset();
 	double getSample(double frequency);
+	// Advances the table position like getSample, without calculating the sample.
+	void skipSample(double frequency);
 	void updateWavetable(double amplitude);
+
+	double position() const { return currentPosition_; }
+	void setPosition(double position) { currentPosition_ = position; }
 private:
 	WavetableGlottalSource(const WavetableGlottalSource&) = delete;
 	WavetableGlottalSource& operator=(const WavetableGlottalSource&) = delete;
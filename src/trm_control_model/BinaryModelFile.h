@@ -0,0 +1,79 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef TRM_CONTROL_MODEL_BINARY_MODEL_FILE_H_
+#define TRM_CONTROL_MODEL_BINARY_MODEL_FILE_H_
+
+#include <cstddef> /* std::size_t */
+#include <cstdint>
+#include <cstring> /* memcpy */
+
+
+
+namespace GS {
+namespace TRMControlModel {
+
+/*******************************************************************************
+ * Format of the binary model cache.
+ *
+ * The file contains a header followed by the payload. The values are stored
+ * in the native byte order of the machine, so the file can't be shared
+ * between machines with different architectures (the header is used to
+ * detect this case).
+ *
+ * Header:
+ *     char[8] magic
+ *     uint32  format version
+ *     uint32  byte order tag
+ *     uint64  size of the source XML file
+ *     uint64  hash of the source XML file
+ *     uint64  payload size
+ *     uint64  payload hash
+ *
+ * The format version must be incremented when the payload is changed.
+ */
+struct BinaryModelFile {
+	enum {
+		FORMAT_VERSION = 1,
+		BYTE_ORDER_TAG = 0x01020304,
+		HEADER_SIZE = 8 + 4 + 4 + 8 + 8 + 8 + 8
+	};
+	static constexpr const char* MAGIC = "GSMODEL";     // 7 characters + '\0'
+	static constexpr const char* FILE_NAME_SUFFIX = ".cache";
+
+	// FNV-1a, applied to 64-bit words (the tail is processed byte by byte).
+	static std::uint64_t hash(const char* data, std::size_t size) {
+		std::uint64_t h = 14695981039346656037ULL;
+		std::size_t i = 0;
+		for ( ; i + 8 <= size; i += 8) {
+			std::uint64_t word;
+			std::memcpy(&word, data + i, 8);
+			h ^= word;
+			h *= 1099511628211ULL;
+		}
+		for ( ; i < size; ++i) {
+			h ^= static_cast<unsigned char>(data[i]);
+			h *= 1099511628211ULL;
+		}
+		return h;
+	}
+};
+
+} /* namespace TRMControlModel */
+} /* namespace GS */
+
+#endif /* TRM_CONTROL_MODEL_BINARY_MODEL_FILE_H_ */
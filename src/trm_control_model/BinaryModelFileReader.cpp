@@ -0,0 +1,317 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "BinaryModelFileReader.h"
+
+#include <cstring> /* memcmp, memcpy */
+
+#include "BinaryModelFile.h"
+#include "Exception.h"
+#include "MappedFile.h"
+#include "Model.h"
+
+
+
+namespace GS {
+namespace TRMControlModel {
+
+/*******************************************************************************
+ * Constructor.
+ */
+BinaryModelFileReader::BinaryModelFileReader(Model& model, const std::string& filePath)
+		: model_(model)
+		, filePath_(filePath)
+		, pos_(nullptr)
+		, end_(nullptr)
+{
+}
+
+/*******************************************************************************
+ * Destructor.
+ */
+BinaryModelFileReader::~BinaryModelFileReader()
+{
+}
+
+template<typename T>
+T
+BinaryModelFileReader::read()
+{
+	if (static_cast<std::size_t>(end_ - pos_) < sizeof(T)) {
+		THROW_EXCEPTION(EndOfBufferException, "Unexpected end of data in the file " << filePath_ << '.');
+	}
+	T value;
+	std::memcpy(&value, pos_, sizeof(T));
+	pos_ += sizeof(T);
+	return value;
+}
+
+std::string
+BinaryModelFileReader::readString()
+{
+	const std::uint32_t size = read<std::uint32_t>();
+	if (static_cast<std::size_t>(end_ - pos_) < size) {
+		THROW_EXCEPTION(EndOfBufferException, "Unexpected end of data in the file " << filePath_ << '.');
+	}
+	std::string s(pos_, size);
+	pos_ += size;
+	return s;
+}
+
+std::shared_ptr<Equation>
+BinaryModelFileReader::readEquationRef()
+{
+	const std::int32_t index = read<std::int32_t>();
+	if (index == -1) {
+		return std::shared_ptr<Equation>();
+	}
+	if (index < 0 || static_cast<std::size_t>(index) >= equationList_.size()) {
+		THROW_EXCEPTION(InvalidValueException, "Invalid equation index: " << index << '.');
+	}
+	return equationList_[index];
+}
+
+std::shared_ptr<Transition>
+BinaryModelFileReader::readTransitionRef(const std::vector<std::shared_ptr<Transition>>& transitionList)
+{
+	const std::int32_t index = read<std::int32_t>();
+	if (index == -1) {
+		return std::shared_ptr<Transition>();
+	}
+	if (index < 0 || static_cast<std::size_t>(index) >= transitionList.size()) {
+		THROW_EXCEPTION(InvalidValueException, "Invalid transition index: " << index << '.');
+	}
+	return transitionList[index];
+}
+
+void
+BinaryModelFileReader::readTransitionGroups(bool special)
+{
+	auto readPoint = [&](Transition::Point& point) {
+		const std::uint32_t type = read<std::uint32_t>();
+		if (type < Transition::Point::TYPE_DIPHONE || type > Transition::Point::TYPE_TETRAPHONE) {
+			THROW_EXCEPTION(InvalidValueException, "Invalid transition point type: " << type << '.');
+		}
+		point.type = static_cast<Transition::Point::Type>(type);
+		point.value = read<float>();
+		point.isPhantom = read<std::uint8_t>() != 0;
+		point.timeExpression = readEquationRef();
+		point.freeTime = read<float>();
+	};
+
+	std::vector<TransitionGroup>& groupList = special ? model_.specialTransitionGroupList() : model_.transitionGroupList();
+	std::vector<std::shared_ptr<Transition>>& transitionList = special ? specialTransitionList_ : transitionList_;
+
+	const std::uint32_t numGroups = read<std::uint32_t>();
+	for (std::uint32_t i = 0; i < numGroups; ++i) {
+		TransitionGroup group;
+		group.name = readString();
+		const std::uint32_t numTransitions = read<std::uint32_t>();
+		for (std::uint32_t j = 0; j < numTransitions; ++j) {
+			const std::string name = readString();
+			const std::uint32_t type = read<std::uint32_t>();
+			if (type < Transition::TYPE_DIPHONE || type > Transition::TYPE_TETRAPHONE) {
+				THROW_EXCEPTION(InvalidValueException, "Invalid transition type: " << type << '.');
+			}
+			std::shared_ptr<Transition> tr(new Transition(name, static_cast<Transition::Type>(type), special));
+			tr->setComment(readString());
+
+			const std::uint32_t numPointOrSlopes = read<std::uint32_t>();
+			for (std::uint32_t k = 0; k < numPointOrSlopes; ++k) {
+				if (read<std::uint8_t>() != 0) {
+					std::unique_ptr<Transition::SlopeRatio> slopeRatio(new Transition::SlopeRatio());
+					const std::uint32_t numPoints = read<std::uint32_t>();
+					for (std::uint32_t m = 0; m < numPoints; ++m) {
+						std::unique_ptr<Transition::Point> point(new Transition::Point());
+						readPoint(*point);
+						slopeRatio->pointList.push_back(std::move(point));
+					}
+					const std::uint32_t numSlopes = read<std::uint32_t>();
+					for (std::uint32_t m = 0; m < numSlopes; ++m) {
+						std::unique_ptr<Transition::Slope> slope(new Transition::Slope());
+						slope->slope = read<float>();
+						slope->displayTime = read<float>();
+						slopeRatio->slopeList.push_back(std::move(slope));
+					}
+					tr->pointOrSlopeList().push_back(std::move(slopeRatio));
+				} else {
+					std::unique_ptr<Transition::Point> point(new Transition::Point());
+					readPoint(*point);
+					tr->pointOrSlopeList().push_back(std::move(point));
+				}
+			}
+
+			transitionList.push_back(tr);
+			group.transitionList.push_back(tr);
+		}
+		groupList.push_back(std::move(group));
+	}
+}
+
+void
+BinaryModelFileReader::readPayload()
+{
+	// Categories.
+	const std::uint32_t numCategories = read<std::uint32_t>();
+	for (std::uint32_t i = 0; i < numCategories; ++i) {
+		std::shared_ptr<Category> newCategory(new Category(readString()));
+		newCategory->setComment(readString());
+		model_.categoryList().push_back(newCategory);
+	}
+
+	// Parameters.
+	const std::uint32_t numParameters = read<std::uint32_t>();
+	for (std::uint32_t i = 0; i < numParameters; ++i) {
+		const std::string name = readString();
+		const float minimum      = read<float>();
+		const float maximum      = read<float>();
+		const float defaultValue = read<float>();
+		const std::string comment = readString();
+		model_.parameterList().emplace_back(name, minimum, maximum, defaultValue, comment);
+	}
+
+	// Symbols.
+	const std::uint32_t numSymbols = read<std::uint32_t>();
+	for (std::uint32_t i = 0; i < numSymbols; ++i) {
+		const std::string name = readString();
+		const float minimum      = read<float>();
+		const float maximum      = read<float>();
+		const float defaultValue = read<float>();
+		const std::string comment = readString();
+		model_.symbolList().emplace_back(name, minimum, maximum, defaultValue, comment);
+	}
+
+	// Postures.
+	const std::uint32_t numPostures = read<std::uint32_t>();
+	for (std::uint32_t i = 0; i < numPostures; ++i) {
+		std::unique_ptr<Posture> posture(new Posture(readString(), numParameters, numSymbols));
+
+		const std::uint32_t numPostureCategories = read<std::uint32_t>();
+		for (std::uint32_t j = 0; j < numPostureCategories; ++j) {
+			const std::uint32_t index = read<std::uint32_t>();
+			if (index >= numCategories) {
+				THROW_EXCEPTION(InvalidValueException, "Invalid category index: " << index << '.');
+			}
+			posture->categoryList().push_back(model_.categoryList()[index]);
+		}
+		for (std::uint32_t j = 0; j < numParameters; ++j) {
+			posture->setParameterTarget(j, read<float>());
+		}
+		for (std::uint32_t j = 0; j < numSymbols; ++j) {
+			posture->setSymbolTarget(j, read<float>());
+		}
+		posture->setComment(readString());
+
+		model_.postureList().add(std::move(posture));
+	}
+
+	// Equations.
+	const std::uint32_t numEquationGroups = read<std::uint32_t>();
+	for (std::uint32_t i = 0; i < numEquationGroups; ++i) {
+		EquationGroup group;
+		group.name = readString();
+		const std::uint32_t numEquations = read<std::uint32_t>();
+		for (std::uint32_t j = 0; j < numEquations; ++j) {
+			std::shared_ptr<Equation> eq(new Equation(readString()));
+			eq->setFormula(readString());
+			eq->setComment(readString());
+			equationList_.push_back(eq);
+			group.equationList.push_back(eq);
+		}
+		model_.equationGroupList().push_back(std::move(group));
+	}
+
+	readTransitionGroups(false);
+	readTransitionGroups(true);
+
+	// Rules.
+	const std::uint32_t numRules = read<std::uint32_t>();
+	for (std::uint32_t i = 0; i < numRules; ++i) {
+		std::unique_ptr<Rule> rule(new Rule(numParameters));
+
+		std::vector<std::string> exprList(read<std::uint32_t>());
+		for (auto& expr : exprList) {
+			expr = readString();
+		}
+		rule->setBooleanExpressionList(exprList, model_);
+
+		for (std::uint32_t j = 0; j < numParameters; ++j) {
+			rule->setParamProfileTransition(j, readTransitionRef(transitionList_));
+		}
+		for (std::uint32_t j = 0; j < numParameters; ++j) {
+			rule->setSpecialProfileTransition(j, readTransitionRef(specialTransitionList_));
+		}
+		Rule::ExpressionSymbolEquations& symbolEquations = rule->exprSymbolEquations();
+		symbolEquations.ruleDuration = readEquationRef();
+		symbolEquations.beat         = readEquationRef();
+		symbolEquations.mark1        = readEquationRef();
+		symbolEquations.mark2        = readEquationRef();
+		symbolEquations.mark3        = readEquationRef();
+		rule->setComment(readString());
+
+		model_.ruleList().push_back(std::move(rule));
+	}
+
+	if (pos_ != end_) {
+		THROW_EXCEPTION(InvalidValueException, "Unexpected data at the end of the file " << filePath_ << '.');
+	}
+}
+
+/*******************************************************************************
+ *
+ */
+bool
+BinaryModelFileReader::loadModel(std::uint64_t sourceSize, std::uint64_t sourceHash)
+{
+	MappedFile file;
+	if (!file.open(filePath_)) {
+		return false;
+	}
+	if (file.size() < BinaryModelFile::HEADER_SIZE) {
+		return false;
+	}
+
+	pos_ = file.data();
+	end_ = pos_ + BinaryModelFile::HEADER_SIZE;
+	if (std::memcmp(pos_, BinaryModelFile::MAGIC, 8) != 0) {
+		return false;
+	}
+	pos_ += 8;
+	if (read<std::uint32_t>() != BinaryModelFile::FORMAT_VERSION ||
+			read<std::uint32_t>() != BinaryModelFile::BYTE_ORDER_TAG ||
+			read<std::uint64_t>() != sourceSize ||
+			read<std::uint64_t>() != sourceHash) {
+		return false;
+	}
+	const std::uint64_t payloadSize = read<std::uint64_t>();
+	const std::uint64_t payloadHash = read<std::uint64_t>();
+	if (payloadSize != file.size() - BinaryModelFile::HEADER_SIZE) {
+		THROW_EXCEPTION(InvalidFileException, "Invalid size of the file " << filePath_ << '.');
+	}
+	if (BinaryModelFile::hash(pos_, payloadSize) != payloadHash) {
+		THROW_EXCEPTION(InvalidFileException, "Corrupted file " << filePath_ << '.');
+	}
+
+	end_ = pos_ + payloadSize;
+	readPayload();
+	pos_ = end_ = nullptr;
+
+	return true;
+}
+
+} /* namespace TRMControlModel */
+} /* namespace GS */
@@ -0,0 +1,77 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef TRM_CONTROL_MODEL_BINARY_MODEL_FILE_READER_H_
+#define TRM_CONTROL_MODEL_BINARY_MODEL_FILE_READER_H_
+
+#include <cstddef> /* std::size_t */
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+
+namespace GS {
+namespace TRMControlModel {
+
+class Equation;
+class Model;
+class Transition;
+
+/*******************************************************************************
+ * Reads the binary model cache (see BinaryModelFile.h).
+ *
+ * The file is memory-mapped if the platform supports it.
+ */
+class BinaryModelFileReader {
+public:
+	BinaryModelFileReader(Model& model, const std::string& filePath);
+	~BinaryModelFileReader();
+
+	// Loads the model from the cache.
+	// Returns false if the file does not exist, or if it was not created from
+	// the source file with the specified size and hash, or if it was created
+	// by a different version of the program. Throws an exception if the file
+	// is corrupted.
+	//
+	// Precondition: the model is empty.
+	bool loadModel(std::uint64_t sourceSize, std::uint64_t sourceHash);
+private:
+	BinaryModelFileReader(const BinaryModelFileReader&) = delete;
+	BinaryModelFileReader& operator=(const BinaryModelFileReader&) = delete;
+
+	template<typename T> T read();
+	std::string readString();
+	std::shared_ptr<Equation> readEquationRef();
+	std::shared_ptr<Transition> readTransitionRef(const std::vector<std::shared_ptr<Transition>>& transitionList);
+	void readTransitionGroups(bool special);
+	void readPayload();
+
+	Model& model_;
+	std::string filePath_;
+	const char* pos_;
+	const char* end_;
+	std::vector<std::shared_ptr<Equation>> equationList_;
+	std::vector<std::shared_ptr<Transition>> transitionList_;
+	std::vector<std::shared_ptr<Transition>> specialTransitionList_;
+};
+
+} /* namespace TRMControlModel */
+} /* namespace GS */
+
+#endif /* TRM_CONTROL_MODEL_BINARY_MODEL_FILE_READER_H_ */
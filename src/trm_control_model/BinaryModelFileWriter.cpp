@@ -0,0 +1,302 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "BinaryModelFileWriter.h"
+
+#include <cerrno>
+#include <cstring> /* memcpy, strerror */
+#include <fstream>
+
+#include "BinaryModelFile.h"
+#include "Exception.h"
+#include "Model.h"
+#include "TemporaryFile.h"
+
+
+
+namespace GS {
+namespace TRMControlModel {
+
+/*******************************************************************************
+ * Constructor.
+ */
+BinaryModelFileWriter::BinaryModelFileWriter(const Model& model, const std::string& filePath)
+		: model_(model)
+		, filePath_(filePath)
+{
+}
+
+/*******************************************************************************
+ * Destructor.
+ */
+BinaryModelFileWriter::~BinaryModelFileWriter()
+{
+}
+
+template<typename T>
+void
+BinaryModelFileWriter::write(T value)
+{
+	const std::size_t pos = payload_.size();
+	payload_.resize(pos + sizeof(T));
+	std::memcpy(&payload_[pos], &value, sizeof(T));
+}
+
+void
+BinaryModelFileWriter::writeString(const std::string& s)
+{
+	write<std::uint32_t>(s.size());
+	payload_.insert(payload_.end(), s.begin(), s.end());
+}
+
+// -1: no equation.
+void
+BinaryModelFileWriter::writeEquationRef(const std::shared_ptr<Equation>& equation)
+{
+	if (!equation) {
+		write<std::int32_t>(-1);
+		return;
+	}
+	auto iter = equationIndexMap_.find(equation.get());
+	if (iter == equationIndexMap_.end()) {
+		THROW_EXCEPTION(TRMControlModelException, "The equation " << equation->name() << " does not belong to the model.");
+	}
+	write<std::int32_t>(iter->second);
+}
+
+// -1: no transition.
+void
+BinaryModelFileWriter::writeTransitionRef(const std::shared_ptr<Transition>& transition,
+						const std::unordered_map<const Transition*, std::int32_t>& indexMap)
+{
+	if (!transition) {
+		write<std::int32_t>(-1);
+		return;
+	}
+	auto iter = indexMap.find(transition.get());
+	if (iter == indexMap.end()) {
+		THROW_EXCEPTION(TRMControlModelException, "The transition " << transition->name() << " does not belong to the model.");
+	}
+	write<std::int32_t>(iter->second);
+}
+
+void
+BinaryModelFileWriter::writeTransitionGroups(const std::vector<TransitionGroup>& groupList)
+{
+	auto writePoint = [&](const Transition::Point& point) {
+		write<std::uint32_t>(point.type);
+		write<float>(point.value);
+		write<std::uint8_t>(point.isPhantom);
+		writeEquationRef(point.timeExpression);
+		write<float>(point.freeTime);
+	};
+
+	write<std::uint32_t>(groupList.size());
+	for (const auto& group : groupList) {
+		writeString(group.name);
+		write<std::uint32_t>(group.transitionList.size());
+		for (const auto& transition : group.transitionList) {
+			writeString(transition->name());
+			write<std::uint32_t>(transition->type());
+			writeString(transition->comment());
+			write<std::uint32_t>(transition->pointOrSlopeList().size());
+			for (const auto& pointOrSlope : transition->pointOrSlopeList()) {
+				if (pointOrSlope->isSlopeRatio()) {
+					const auto& slopeRatio = static_cast<const Transition::SlopeRatio&>(*pointOrSlope);
+					write<std::uint8_t>(1);
+					write<std::uint32_t>(slopeRatio.pointList.size());
+					for (const auto& point : slopeRatio.pointList) {
+						writePoint(*point);
+					}
+					write<std::uint32_t>(slopeRatio.slopeList.size());
+					for (const auto& slope : slopeRatio.slopeList) {
+						write<float>(slope->slope);
+						write<float>(slope->displayTime);
+					}
+				} else {
+					write<std::uint8_t>(0);
+					writePoint(static_cast<const Transition::Point&>(*pointOrSlope));
+				}
+			}
+		}
+	}
+}
+
+/*******************************************************************************
+ *
+ */
+void
+BinaryModelFileWriter::saveModel(std::uint64_t sourceSize, std::uint64_t sourceHash)
+{
+	payload_.clear();
+	equationIndexMap_.clear();
+	transitionIndexMap_.clear();
+	specialTransitionIndexMap_.clear();
+
+	// Categories.
+	std::unordered_map<const Category*, std::uint32_t> categoryIndexMap;
+	write<std::uint32_t>(model_.categoryList().size());
+	for (const auto& category : model_.categoryList()) {
+		const std::uint32_t index = categoryIndexMap.size();
+		categoryIndexMap[category.get()] = index;
+		writeString(category->name());
+		writeString(category->comment());
+	}
+
+	// Parameters.
+	write<std::uint32_t>(model_.parameterList().size());
+	for (const auto& parameter : model_.parameterList()) {
+		writeString(parameter.name());
+		write<float>(parameter.minimum());
+		write<float>(parameter.maximum());
+		write<float>(parameter.defaultValue());
+		writeString(parameter.comment());
+	}
+
+	// Symbols.
+	write<std::uint32_t>(model_.symbolList().size());
+	for (const auto& symbol : model_.symbolList()) {
+		writeString(symbol.name());
+		write<float>(symbol.minimum());
+		write<float>(symbol.maximum());
+		write<float>(symbol.defaultValue());
+		writeString(symbol.comment());
+	}
+
+	// Postures.
+	const PostureList& postureList = model_.postureList();
+	write<std::uint32_t>(postureList.size());
+	for (unsigned int i = 0, size = postureList.size(); i < size; ++i) {
+		const Posture& posture = postureList[i];
+		writeString(posture.name());
+
+		std::vector<std::uint32_t> categoryIndexList;
+		for (const auto& category : posture.categoryList()) {
+			if (category->native()) {
+				continue;
+			}
+			auto iter = categoryIndexMap.find(category.get());
+			if (iter == categoryIndexMap.end()) {
+				THROW_EXCEPTION(TRMControlModelException, "The category " << category->name() << " of the posture "
+						<< posture.name() << " does not belong to the model.");
+			}
+			categoryIndexList.push_back(iter->second);
+		}
+		write<std::uint32_t>(categoryIndexList.size());
+		for (std::uint32_t index : categoryIndexList) {
+			write<std::uint32_t>(index);
+		}
+
+		for (unsigned int j = 0, numParam = model_.parameterList().size(); j < numParam; ++j) {
+			write<float>(posture.getParameterTarget(j));
+		}
+		for (unsigned int j = 0, numSymb = model_.symbolList().size(); j < numSymb; ++j) {
+			write<float>(posture.getSymbolTarget(j));
+		}
+		writeString(posture.comment());
+	}
+
+	// Equations.
+	write<std::uint32_t>(model_.equationGroupList().size());
+	for (const auto& group : model_.equationGroupList()) {
+		writeString(group.name);
+		write<std::uint32_t>(group.equationList.size());
+		for (const auto& equation : group.equationList) {
+			const std::int32_t index = equationIndexMap_.size();
+			equationIndexMap_[equation.get()] = index;
+			writeString(equation->name());
+			writeString(equation->formula());
+			writeString(equation->comment());
+		}
+	}
+
+	// Transitions.
+	for (const auto& group : model_.transitionGroupList()) {
+		for (const auto& transition : group.transitionList) {
+			const std::int32_t index = transitionIndexMap_.size();
+			transitionIndexMap_[transition.get()] = index;
+		}
+	}
+	writeTransitionGroups(model_.transitionGroupList());
+
+	// Special transitions.
+	for (const auto& group : model_.specialTransitionGroupList()) {
+		for (const auto& transition : group.transitionList) {
+			const std::int32_t index = specialTransitionIndexMap_.size();
+			specialTransitionIndexMap_[transition.get()] = index;
+		}
+	}
+	writeTransitionGroups(model_.specialTransitionGroupList());
+
+	// Rules.
+	write<std::uint32_t>(model_.ruleList().size());
+	for (const auto& rule : model_.ruleList()) {
+		write<std::uint32_t>(rule->booleanExpressionList().size());
+		for (const auto& expression : rule->booleanExpressionList()) {
+			writeString(expression);
+		}
+		for (const auto& transition : rule->paramProfileTransitionList()) {
+			writeTransitionRef(transition, transitionIndexMap_);
+		}
+		for (const auto& transition : rule->specialProfileTransitionList()) {
+			writeTransitionRef(transition, specialTransitionIndexMap_);
+		}
+		const Rule::ExpressionSymbolEquations& symbolEquations = rule->exprSymbolEquations();
+		writeEquationRef(symbolEquations.ruleDuration);
+		writeEquationRef(symbolEquations.beat);
+		writeEquationRef(symbolEquations.mark1);
+		writeEquationRef(symbolEquations.mark2);
+		writeEquationRef(symbolEquations.mark3);
+		writeString(rule->comment());
+	}
+
+	// Header.
+	std::vector<char> header;
+	auto writeHeader = [&header](const void* data, std::size_t size) {
+		const char* p = static_cast<const char*>(data);
+		header.insert(header.end(), p, p + size);
+	};
+	const std::uint32_t formatVersion = BinaryModelFile::FORMAT_VERSION;
+	const std::uint32_t byteOrderTag  = BinaryModelFile::BYTE_ORDER_TAG;
+	const std::uint64_t payloadSize   = payload_.size();
+	const std::uint64_t payloadHash   = BinaryModelFile::hash(payload_.data(), payload_.size());
+	writeHeader(BinaryModelFile::MAGIC, 8);
+	writeHeader(&formatVersion, sizeof formatVersion);
+	writeHeader(&byteOrderTag , sizeof byteOrderTag);
+	writeHeader(&sourceSize   , sizeof sourceSize);
+	writeHeader(&sourceHash   , sizeof sourceHash);
+	writeHeader(&payloadSize  , sizeof payloadSize);
+	writeHeader(&payloadHash  , sizeof payloadHash);
+
+	TemporaryFile tempFile(filePath_);
+	{
+		std::ofstream out(tempFile.path(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (!out) {
+			THROW_EXCEPTION(IOException, "Could not open the file " << tempFile.path() << ": " << std::strerror(errno) << '.');
+		}
+		out.write(header.data(), header.size());
+		out.write(payload_.data(), payload_.size());
+		out.close();
+		if (!out) {
+			THROW_EXCEPTION(IOException, "Could not write the file " << tempFile.path() << '.');
+		}
+	}
+	tempFile.commit();
+}
+
+} /* namespace TRMControlModel */
+} /* namespace GS */
@@ -0,0 +1,69 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef TRM_CONTROL_MODEL_BINARY_MODEL_FILE_WRITER_H_
+#define TRM_CONTROL_MODEL_BINARY_MODEL_FILE_WRITER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace GS {
+namespace TRMControlModel {
+
+class Equation;
+class Model;
+class Transition;
+struct TransitionGroup;
+
+/*******************************************************************************
+ * Writes the binary model cache (see BinaryModelFile.h).
+ */
+class BinaryModelFileWriter {
+public:
+	BinaryModelFileWriter(const Model& model, const std::string& filePath);
+	~BinaryModelFileWriter();
+
+	// The file is written to a temporary file, which is then renamed.
+	void saveModel(std::uint64_t sourceSize, std::uint64_t sourceHash);
+private:
+	BinaryModelFileWriter(const BinaryModelFileWriter&) = delete;
+	BinaryModelFileWriter& operator=(const BinaryModelFileWriter&) = delete;
+
+	template<typename T> void write(T value);
+	void writeString(const std::string& s);
+	void writeEquationRef(const std::shared_ptr<Equation>& equation);
+	void writeTransitionRef(const std::shared_ptr<Transition>& transition,
+				const std::unordered_map<const Transition*, std::int32_t>& indexMap);
+	void writeTransitionGroups(const std::vector<TransitionGroup>& groupList);
+
+	const Model& model_;
+	std::string filePath_;
+	std::vector<char> payload_;
+	std::unordered_map<const Equation*, std::int32_t> equationIndexMap_;
+	std::unordered_map<const Transition*, std::int32_t> transitionIndexMap_;
+	std::unordered_map<const Transition*, std::int32_t> specialTransitionIndexMap_;
+};
+
+} /* namespace TRMControlModel */
+} /* namespace GS */
+
+#endif /* TRM_CONTROL_MODEL_BINARY_MODEL_FILE_WRITER_H_ */
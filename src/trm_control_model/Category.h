@@ -32,7 +32,11 @@ namespace TRMControlModel {
 
 class Category {
 public:
-	Category(const std::string& name) : name_(name), native_(false) {}
+	enum {
+		INVALID_CODE = 0xFFFFFFFFU
+	};
+
+	Category(const std::string& name) : name_(name), native_(false), code_(INVALID_CODE) {}
 
 	const std::string& name() const { return name_; }
 	void setName(const std::string& name) { name_ = name; }
@@ -42,10 +46,15 @@ public:
 
 	bool native() const { return native_; }
 	void setNative() { native_ = true; }
+
+	// Dense index of the category in the model, assigned by Model::compile().
+	unsigned int code() const { return code_; }
+	void setCode(unsigned int code) { code_ = code; }
 private:
 	std::string name_;
 	std::string comment_;
 	bool native_;
+	unsigned int code_;
 };
 
 } /* namespace TRMControlModel */
@@ -24,19 +24,30 @@
 #include <sstream>
 
 #include "Exception.h"
+#include "global.h"
 #include "Tube.h"
 
-#define TRM_CONTROL_MODEL_CONFIG_FILE_NAME "/trm_control_model.txt"
-#define TRM_CONFIG_FILE_NAME "/trm.txt"
-#define VOICE_FILE_PREFIX "/voice_"
 
 
 
 namespace GS {
 namespace TRMControlModel {
 
-Controller::Controller(const char* configDirPath, Model& model)
-		: model_(model)
+Controller::Controller(const char* configDirPath, const Model& model)
+		: configDirPath_(configDirPath)
+		, model_(model)
+		, voiceSet_(nullptr)
+		, cancellationToken_(nullptr)
+		, eventList_(configDirPath, model_)
+{
+	loadConfiguration(configDirPath);
+}
+
+Controller::Controller(const char* configDirPath, const Model& model, const VoiceSet& voiceSet)
+		: configDirPath_(configDirPath)
+		, model_(model)
+		, voiceSet_(&voiceSet)
+		, cancellationToken_(nullptr)
 		, eventList_(configDirPath, model_)
 {
 	loadConfiguration(configDirPath);
@@ -52,18 +63,31 @@ Controller::loadConfiguration(const char* configDirPath)
 	// Load TRMControlModel::Configuration.
 
 	std::ostringstream trmControlModelConfigFilePath;
-	trmControlModelConfigFilePath << configDirPath << TRM_CONTROL_MODEL_CONFIG_FILE_NAME;
+	trmControlModelConfigFilePath << configDirPath << TRM_CONTROL_MODEL_CONFIGURATION_FILE;
 	trmControlModelConfig_.load(trmControlModelConfigFilePath.str());
 
 	// Load TRM::Configuration.
 
-	std::ostringstream trmConfigFilePath;
-	trmConfigFilePath << configDirPath << TRM_CONFIG_FILE_NAME;
+	setVoice(trmControlModelConfig_.voiceName);
+}
 
-	std::ostringstream voiceFilePath;
-	voiceFilePath << configDirPath << VOICE_FILE_PREFIX << trmControlModelConfig_.voiceName << ".txt";
+void
+Controller::setVoice(const std::string& voiceName)
+{
+	const TRM::Configuration* voice = (voiceSet_ != nullptr) ? voiceSet_->voice(voiceName) : nullptr;
+	if (voice != nullptr) {
+		trmConfig_ = *voice;
+	} else {
+		VoiceSet::loadVoice(configDirPath_, voiceName, trmConfig_);
+	}
+	trmControlModelConfig_.voiceName = voiceName;
+}
 
-	trmConfig_.load(trmConfigFilePath.str(), voiceFilePath.str());
+void
+Controller::setCancellationToken(const CancellationToken* token)
+{
+	cancellationToken_ = token;
+	eventList_.setCancellationToken(token);
 }
 
 void
@@ -118,40 +142,6 @@ Controller::initUtterance(std::ostream& trmParamStream)
 		trmConfig_.mixOffset               << '\n';
 }
 
-// Chunks are separated by /c.
-// There is always one /c at the begin and another at the end of the string.
-int
-Controller::calcChunks(const char* string)
-{
-	int temp = 0, index = 0;
-	while (string[index] != '\0') {
-		if ((string[index] == '/') && (string[index + 1] == 'c')) {
-			temp++;
-			index += 2;
-		} else {
-			index++;
-		}
-	}
-	temp--;
-	if (temp < 0) temp = 0;
-	return temp;
-}
-
-// Returns the position of the next /c (the position of the /).
-int
-Controller::nextChunk(const char* string)
-{
-	int index = 0;
-	while (string[index] != '\0') {
-		if ((string[index] == '/') && (string[index + 1] == 'c')) {
-			return index;
-		} else {
-			index++;
-		}
-	}
-	return 0;
-}
-
 int
 Controller::validPosture(const char* token)
 {
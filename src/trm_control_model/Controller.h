@@ -23,7 +23,10 @@
 
 #include <cstdio>
 #include <fstream>
+#include <iostream>
 #include <istream>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #include "EventList.h"
@@ -32,6 +35,7 @@
 #include "TRMConfiguration.h"
 #include "TRMControlModelConfiguration.h"
 #include "Tube.h"
+#include "VoiceSet.h"
 
 
 
@@ -40,12 +44,35 @@ namespace TRMControlModel {
 
 class Controller {
 public:
-	Controller(const char* configDirPath, Model& model);
+	Controller(const char* configDirPath, const Model& model);
+	// The voices are copied from the voice set, instead of being loaded from the files.
+	// The voice set must not be destroyed before the controller.
+	Controller(const char* configDirPath, const Model& model, const VoiceSet& voiceSet);
 	~Controller();
 
+	// The phonetic string is converted to tokens by phoneticStringParser.tokenize.
 	template<typename T> void synthesizePhoneticString(T& phoneticStringParser, const char* phoneticString, const char* trmParamFile, const char* outputFile);
-
-	Model& model() { return model_; }
+	template<typename T, typename L> void synthesizeTokenList(T& phoneticStringParser, const L& tokenList, const char* trmParamFile, const char* outputFile);
+
+	// Synthesizes a sequence of phonetic token lists as one utterance.
+	// nextTokenList() is called until it returns nullptr, and the returned list must
+	// remain valid until the next call. Each list must contain complete chunks.
+	// The TRM parameters of each list are appended to the file and synthesized
+	// before the next list is requested, so the memory use is bounded by the
+	// largest list.
+	template<typename T, typename F> void synthesizeTokenLists(T& phoneticStringParser, F nextTokenList, const char* trmParamFile, const char* outputFile);
+	// Writes the TRM parameters to trmParamStream, and moves its read position to the start.
+	template<typename T, typename F> void synthesizeTokenLists(T& phoneticStringParser, F nextTokenList, std::iostream& trmParamStream);
+
+	// Loads the TRM configuration of another voice from the voice set or, if
+	// the voice is not in the set, from the configuration directory.
+	void setVoice(const std::string& voiceName);
+
+	// The token is checked before each chunk and each rule application.
+	// May be nullptr.
+	void setCancellationToken(const CancellationToken* token);
+
+	const Model& model() const { return model_; }
 	EventList& eventList() { return eventList_; }
 	Configuration& trmControlModelConfiguration() { return trmControlModelConfig_; }
 private:
@@ -58,17 +85,18 @@ private:
 
 	void loadConfiguration(const char* configDirPath);
 	void initUtterance(std::ostream& trmParamStream);
-	int calcChunks(const char* string);
-	int nextChunk(const char* string);
 	void printVowelTransitions();
 
 	int validPosture(const char* token);
 	void setIntonation(int intonation);
 
-	template<typename T> void synthesizePhoneticString(T& phoneticStringParser, const char* phoneticString, std::iostream& trmParamStream);
-	template<typename T> void synthesizePhoneticStringChunk(T& phoneticStringParser, const char* phoneticStringChunk, std::ostream& trmParamStream);
+	template<typename T, typename L> void synthesizeTokenListChunks(T& phoneticStringParser, const L& tokenList, std::ostream& trmParamStream);
+	template<typename T, typename L> void synthesizeTokenListChunk(T& phoneticStringParser, const L& tokenList, int chunk, std::ostream& trmParamStream);
 
-	Model& model_;
+	const std::string configDirPath_;
+	const Model& model_;
+	const VoiceSet* voiceSet_;
+	const CancellationToken* cancellationToken_;
 	EventList eventList_;
 	Configuration trmControlModelConfig_;
 	TRM::Configuration trmConfig_;
@@ -80,47 +108,109 @@ template<typename T>
 void
 Controller::synthesizePhoneticString(T& phoneticStringParser, const char* phoneticString, const char* trmParamFile, const char* outputFile)
 {
-	std::fstream trmParamStream(trmParamFile, std::ios_base::in | std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
-	if (!trmParamStream) {
+	typename T::TokenList tokenList;
+	phoneticStringParser.tokenize(phoneticString, tokenList);
+	synthesizeTokenList(phoneticStringParser, tokenList, trmParamFile, outputFile);
+}
+
+template<typename T, typename L>
+void
+Controller::synthesizeTokenList(T& phoneticStringParser, const L& tokenList, const char* trmParamFile, const char* outputFile)
+{
+	bool done = false;
+	synthesizeTokenLists(phoneticStringParser,
+		[&]() -> const L* {
+			if (done) return nullptr;
+			done = true;
+			return &tokenList;
+		},
+		trmParamFile, outputFile);
+}
+
+template<typename T, typename F>
+void
+Controller::synthesizeTokenLists(T& phoneticStringParser, F nextTokenList, const char* trmParamFile, const char* outputFile)
+{
+	std::ofstream trmParamFileStream(trmParamFile, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (!trmParamFileStream) {
 		THROW_EXCEPTION(IOException, "Could not open the file " << trmParamFile << '.');
 	}
 
-	synthesizePhoneticString(phoneticStringParser, phoneticString, trmParamStream);
-
 	TRM::Tube trm;
-	trm.synthesizeToFile(trmParamStream, outputFile);
+	trm.setCancellationToken(cancellationToken_);
+
+	// The stream contains the parameters of one token list (and the header,
+	// before the first list).
+	std::stringstream trmParamStream;
+	initUtterance(trmParamStream);
+	for (;;) {
+		const auto* tokenList = nextTokenList();
+		if (tokenList != nullptr) {
+			synthesizeTokenListChunks(phoneticStringParser, *tokenList, trmParamStream);
+		}
+
+		trmParamFileStream << trmParamStream.str();
+		trm.synthesizeSegment(trmParamStream);
+		trmParamStream.str(std::string());
+		trmParamStream.clear();
+
+		if (tokenList == nullptr) break;
+	}
+
+	if (Log::debugEnabled) {
+		eventList_.ruleEventCache().printStatistics(std::cout);
+	}
+
+	trmParamFileStream.close();
+	if (!trmParamFileStream) {
+		THROW_EXCEPTION(IOException, "Could not write the file " << trmParamFile << '.');
+	}
+
+	trm.finishSynthesisToFile(outputFile);
 }
 
-template<typename T>
+template<typename T, typename F>
 void
-Controller::synthesizePhoneticString(T& phoneticStringParser, const char* phoneticString, std::iostream& trmParamStream)
+Controller::synthesizeTokenLists(T& phoneticStringParser, F nextTokenList, std::iostream& trmParamStream)
 {
-	int chunks = calcChunks(phoneticString);
-
 	initUtterance(trmParamStream);
 
-	int index = 0;
-	while (chunks > 0) {
-		if (Log::debugEnabled) {
-			printf("Speaking \"%s\"\n", &phoneticString[index]);
-		}
-
-		synthesizePhoneticStringChunk(phoneticStringParser, &phoneticString[index], trmParamStream);
+	while (const auto* tokenList = nextTokenList()) {
+		synthesizeTokenListChunks(phoneticStringParser, *tokenList, trmParamStream);
+	}
 
-		index += nextChunk(&phoneticString[index + 2]) + 2;
-		chunks--;
+	if (Log::debugEnabled) {
+		eventList_.ruleEventCache().printStatistics(std::cout);
 	}
 
 	trmParamStream.seekg(0);
 }
 
-template<typename T>
+template<typename T, typename L>
+void
+Controller::synthesizeTokenListChunks(T& phoneticStringParser, const L& tokenList, std::ostream& trmParamStream)
+{
+	const int chunks = tokenList.numChunks();
+
+	for (int chunk = 0; chunk < chunks; ++chunk) {
+		if (cancellationToken_ != nullptr) {
+			cancellationToken_->check();
+		}
+		if (Log::debugEnabled) {
+			printf("Speaking \"%s\"\n", tokenList.chunkString(chunk));
+		}
+
+		synthesizeTokenListChunk(phoneticStringParser, tokenList, chunk, trmParamStream);
+	}
+}
+
+template<typename T, typename L>
 void
-Controller::synthesizePhoneticStringChunk(T& phoneticStringParser, const char* phoneticStringChunk, std::ostream& trmParamStream)
+Controller::synthesizeTokenListChunk(T& phoneticStringParser, const L& tokenList, int chunk, std::ostream& trmParamStream)
 {
 	eventList_.setUp();
 
-	phoneticStringParser.parseString(phoneticStringChunk);
+	phoneticStringParser.parseChunk(tokenList, chunk);
 
 	eventList_.generateEventList();
 
@@ -17,7 +17,10 @@
 
 #include "Equation.h"
 
+#include <algorithm> /* max, min */
+#include <cassert>
 #include <cctype> /* isspace */
+#include <cstring> /* memcmp */
 
 #include "Exception.h"
 #include "Log.h"
@@ -274,6 +277,257 @@ FormulaNodeParser::parse()
 namespace GS {
 namespace TRMControlModel {
 
+/*******************************************************************************
+ *
+ */
+void
+FormulaProgram::clear()
+{
+	instructionList_.clear();
+	resultIndex_ = 0;
+}
+
+/*******************************************************************************
+ * Returns the index of an identical instruction, if there is one.
+ */
+unsigned int
+FormulaProgram::add(const Instruction& instr)
+{
+	for (unsigned int i = 0, size = instructionList_.size(); i < size; ++i) {
+		const Instruction& other = instructionList_[i];
+		if (other.op == instr.op &&
+				other.operand1 == instr.operand1 &&
+				other.operand2 == instr.operand2 &&
+				std::memcmp(&other.value, &instr.value, sizeof(float)) == 0) {
+			return i;
+		}
+	}
+	instructionList_.push_back(instr);
+	return instructionList_.size() - 1U;
+}
+
+/*******************************************************************************
+ *
+ */
+unsigned int
+FormulaProgram::addConst(float value)
+{
+	Instruction instr;
+	instr.op = OP_CONST;
+	instr.operand1 = 0;
+	instr.operand2 = 0;
+	instr.value = value;
+	return add(instr);
+}
+
+/*******************************************************************************
+ *
+ */
+unsigned int
+FormulaProgram::addSymbol(FormulaSymbol::Code symbol)
+{
+	Instruction instr;
+	instr.op = OP_SYMBOL;
+	instr.operand1 = symbol;
+	instr.operand2 = 0;
+	instr.value = 0.0;
+	return add(instr);
+}
+
+/*******************************************************************************
+ *
+ */
+unsigned int
+FormulaProgram::addUnaryOp(OpCode op, unsigned int operand)
+{
+	if (op != OP_MINUS) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid unary operation: " << op << '.');
+	}
+	if (operand >= instructionList_.size()) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid operand: " << operand << '.');
+	}
+
+	const Instruction& operandInstr = instructionList_[operand];
+	if (operandInstr.op == OP_CONST) {
+		return addConst(-operandInstr.value);
+	}
+
+	Instruction instr;
+	instr.op = op;
+	instr.operand1 = operand;
+	instr.operand2 = 0;
+	instr.value = 0.0;
+	return add(instr);
+}
+
+/*******************************************************************************
+ *
+ */
+unsigned int
+FormulaProgram::addBinaryOp(OpCode op, unsigned int operand1, unsigned int operand2)
+{
+	if (operand1 >= instructionList_.size() || operand2 >= instructionList_.size()) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid operands: " << operand1 << ", " << operand2 << '.');
+	}
+
+	const Instruction& instr1 = instructionList_[operand1];
+	const Instruction& instr2 = instructionList_[operand2];
+	if (instr1.op == OP_CONST && instr2.op == OP_CONST) {
+		const float v1 = instr1.value;
+		const float v2 = instr2.value;
+		switch (op) {
+		case OP_ADD:  return addConst(v1 + v2);
+		case OP_SUB:  return addConst(v1 - v2);
+		case OP_MULT: return addConst(v1 * v2);
+		case OP_DIV:  return addConst(v1 / v2);
+		default:
+			THROW_EXCEPTION(InvalidParameterException, "Invalid binary operation: " << op << '.');
+		}
+	}
+
+	Instruction instr;
+	instr.op = op;
+	switch (op) {
+	case OP_ADD:
+	case OP_MULT:
+		// Commutative.
+		instr.operand1 = std::min(operand1, operand2);
+		instr.operand2 = std::max(operand1, operand2);
+		break;
+	case OP_SUB:
+	case OP_DIV:
+		instr.operand1 = operand1;
+		instr.operand2 = operand2;
+		break;
+	default:
+		THROW_EXCEPTION(InvalidParameterException, "Invalid binary operation: " << op << '.');
+	}
+	instr.value = 0.0;
+	return add(instr);
+}
+
+/*******************************************************************************
+ * Removes the instructions that do not contribute to the result.
+ */
+void
+FormulaProgram::finish(unsigned int resultIndex)
+{
+	if (resultIndex >= instructionList_.size()) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid result index: " << resultIndex << '.');
+	}
+
+	// The operands of an instruction always precede it.
+	std::vector<bool> used(resultIndex + 1U);
+	used[resultIndex] = true;
+	for (unsigned int i = resultIndex + 1U; i-- > 0; ) {
+		if (!used[i]) continue;
+		const Instruction& instr = instructionList_[i];
+		switch (instr.op) {
+		case OP_CONST:
+		case OP_SYMBOL:
+			break;
+		case OP_MINUS:
+			used[instr.operand1] = true;
+			break;
+		default:
+			used[instr.operand1] = true;
+			used[instr.operand2] = true;
+		}
+	}
+
+	std::vector<unsigned int> newIndex(resultIndex + 1U);
+	std::vector<Instruction> newInstructionList;
+	for (unsigned int i = 0; i <= resultIndex; ++i) {
+		if (!used[i]) continue;
+		Instruction instr = instructionList_[i];
+		switch (instr.op) {
+		case OP_CONST:
+		case OP_SYMBOL:
+			break;
+		case OP_MINUS:
+			instr.operand1 = newIndex[instr.operand1];
+			break;
+		default:
+			instr.operand1 = newIndex[instr.operand1];
+			instr.operand2 = newIndex[instr.operand2];
+		}
+		newIndex[i] = newInstructionList.size();
+		newInstructionList.push_back(instr);
+	}
+
+	std::swap(instructionList_, newInstructionList);
+	resultIndex_ = instructionList_.size() - 1U;
+}
+
+/*******************************************************************************
+ * Precondition: size() <= MAX_SIZE.
+ */
+float
+FormulaProgram::eval(const FormulaSymbolList& symbolList) const
+{
+	assert(!instructionList_.empty() && instructionList_.size() <= MAX_SIZE);
+
+	float reg[MAX_SIZE];
+	const Instruction* instr = instructionList_.data();
+	for (unsigned int i = 0, size = instructionList_.size(); i < size; ++i, ++instr) {
+		switch (instr->op) {
+		case OP_CONST:
+			reg[i] = instr->value;
+			break;
+		case OP_SYMBOL:
+			reg[i] = symbolList[instr->operand1];
+			break;
+		case OP_MINUS:
+			reg[i] = -reg[instr->operand1];
+			break;
+		case OP_ADD:
+			reg[i] = reg[instr->operand1] + reg[instr->operand2];
+			break;
+		case OP_SUB:
+			reg[i] = reg[instr->operand1] - reg[instr->operand2];
+			break;
+		case OP_MULT:
+			reg[i] = reg[instr->operand1] * reg[instr->operand2];
+			break;
+		case OP_DIV:
+			reg[i] = reg[instr->operand1] / reg[instr->operand2];
+			break;
+		}
+	}
+	return reg[resultIndex_];
+}
+
+/*******************************************************************************
+ *
+ */
+void
+FormulaProgram::print(std::ostream& out) const
+{
+	static const char* opName[] = {"const", "symbol", "minus", "add", "sub", "mult", "div"};
+
+	for (unsigned int i = 0, size = instructionList_.size(); i < size; ++i) {
+		const Instruction& instr = instructionList_[i];
+		out << "r" << i << " = " << opName[instr.op];
+		switch (instr.op) {
+		case OP_CONST:
+			out << ' ' << instr.value;
+			break;
+		case OP_SYMBOL:
+			out << ' ' << instr.operand1;
+			break;
+		case OP_MINUS:
+			out << " r" << instr.operand1;
+			break;
+		default:
+			out << " r" << instr.operand1 << " r" << instr.operand2;
+		}
+		out << '\n';
+	}
+	out << "result: r" << resultIndex_ << std::endl;
+}
+
+//==============================================================================
+
 float
 FormulaMinusUnaryOp::eval(const FormulaSymbolList& symbolList) const
 {
@@ -291,6 +545,12 @@ FormulaMinusUnaryOp::print(std::ostream& out, int level) const
 	out << prefix << "]" << std::endl;
 }
 
+unsigned int
+FormulaMinusUnaryOp::compile(FormulaProgram& program) const
+{
+	return program.addUnaryOp(FormulaProgram::OP_MINUS, child_->compile(program));
+}
+
 float
 FormulaAddBinaryOp::eval(const FormulaSymbolList& symbolList) const
 {
@@ -309,6 +569,14 @@ FormulaAddBinaryOp::print(std::ostream& out, int level) const
 	out << prefix << "]" << std::endl;
 }
 
+unsigned int
+FormulaAddBinaryOp::compile(FormulaProgram& program) const
+{
+	const unsigned int operand1 = child1_->compile(program);
+	const unsigned int operand2 = child2_->compile(program);
+	return program.addBinaryOp(FormulaProgram::OP_ADD, operand1, operand2);
+}
+
 float
 FormulaSubBinaryOp::eval(const FormulaSymbolList& symbolList) const
 {
@@ -327,6 +595,14 @@ FormulaSubBinaryOp::print(std::ostream& out, int level) const
 	out << prefix << "]" << std::endl;
 }
 
+unsigned int
+FormulaSubBinaryOp::compile(FormulaProgram& program) const
+{
+	const unsigned int operand1 = child1_->compile(program);
+	const unsigned int operand2 = child2_->compile(program);
+	return program.addBinaryOp(FormulaProgram::OP_SUB, operand1, operand2);
+}
+
 float
 FormulaMultBinaryOp::eval(const FormulaSymbolList& symbolList) const
 {
@@ -345,6 +621,14 @@ FormulaMultBinaryOp::print(std::ostream& out, int level) const
 	out << prefix << "]" << std::endl;
 }
 
+unsigned int
+FormulaMultBinaryOp::compile(FormulaProgram& program) const
+{
+	const unsigned int operand1 = child1_->compile(program);
+	const unsigned int operand2 = child2_->compile(program);
+	return program.addBinaryOp(FormulaProgram::OP_MULT, operand1, operand2);
+}
+
 float
 FormulaDivBinaryOp::eval(const FormulaSymbolList& symbolList) const
 {
@@ -363,6 +647,14 @@ FormulaDivBinaryOp::print(std::ostream& out, int level) const
 	out << prefix << "]" << std::endl;
 }
 
+unsigned int
+FormulaDivBinaryOp::compile(FormulaProgram& program) const
+{
+	const unsigned int operand1 = child1_->compile(program);
+	const unsigned int operand2 = child2_->compile(program);
+	return program.addBinaryOp(FormulaProgram::OP_DIV, operand1, operand2);
+}
+
 float
 FormulaConst::eval(const FormulaSymbolList& /*symbolList*/) const
 {
@@ -375,6 +667,12 @@ FormulaConst::print(std::ostream& out, int level) const
 	out << std::string(level * 8, ' ') << "const=" << value_ << std::endl;
 }
 
+unsigned int
+FormulaConst::compile(FormulaProgram& program) const
+{
+	return program.addConst(value_);
+}
+
 float
 FormulaSymbolValue::eval(const FormulaSymbolList& symbolList) const
 {
@@ -387,6 +685,12 @@ FormulaSymbolValue::print(std::ostream& out, int level) const
 	out << std::string(level * 8, ' ') << "symbol=" << symbol_ << std::endl;
 }
 
+unsigned int
+FormulaSymbolValue::compile(FormulaProgram& program) const
+{
+	return program.addSymbol(symbol_);
+}
+
 /*******************************************************************************
  *
  */
@@ -396,8 +700,16 @@ Equation::setFormula(const std::string& formula)
 	FormulaNodeParser p(formula);
 	FormulaNode_ptr tempFormulaRoot = p.parse();
 
+	FormulaProgram tempFormulaProgram;
+	tempFormulaProgram.finish(tempFormulaRoot->compile(tempFormulaProgram));
+	if (tempFormulaProgram.size() > FormulaProgram::MAX_SIZE) {
+		// The tree will be used.
+		tempFormulaProgram.clear();
+	}
+
 	formula_ = formula;
 	std::swap(tempFormulaRoot, formulaRoot_);
+	std::swap(tempFormulaProgram, formulaProgram_);
 }
 
 /*******************************************************************************
@@ -406,6 +718,9 @@ Equation::setFormula(const std::string& formula)
 float
 Equation::evalFormula(const FormulaSymbolList& symbolList) const
 {
+	if (!formulaProgram_.empty()) {
+		return formulaProgram_.eval(symbolList);
+	}
 	if (!formulaRoot_) {
 		THROW_EXCEPTION(InvalidStateException, "Empty formula.");
 	}
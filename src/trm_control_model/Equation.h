@@ -31,12 +31,64 @@
 namespace GS {
 namespace TRMControlModel {
 
+/*******************************************************************************
+ * Formula compiled to a sequence of instructions.
+ *
+ * The result of each instruction is stored in the register with the same
+ * index. Constant subexpressions are folded and identical subexpressions
+ * are computed only once. The operations are executed in the same order
+ * and with the same precision as in the FormulaNode tree.
+ */
+class FormulaProgram {
+public:
+	enum OpCode {
+		OP_CONST,
+		OP_SYMBOL,
+		OP_MINUS,
+		OP_ADD,
+		OP_SUB,
+		OP_MULT,
+		OP_DIV
+	};
+	enum {
+		MAX_SIZE = 64
+	};
+
+	FormulaProgram() : resultIndex_(0) {}
+
+	bool empty() const { return instructionList_.empty(); }
+	std::size_t size() const { return instructionList_.size(); }
+	void clear();
+
+	unsigned int addConst(float value);
+	unsigned int addSymbol(FormulaSymbol::Code symbol);
+	unsigned int addUnaryOp(OpCode op, unsigned int operand);
+	unsigned int addBinaryOp(OpCode op, unsigned int operand1, unsigned int operand2);
+	void finish(unsigned int resultIndex);
+
+	float eval(const FormulaSymbolList& symbolList) const;
+	void print(std::ostream& out) const;
+private:
+	struct Instruction {
+		OpCode op;
+		unsigned int operand1; // register index or symbol code
+		unsigned int operand2; // register index
+		float value;
+	};
+
+	unsigned int add(const Instruction& instr);
+
+	std::vector<Instruction> instructionList_;
+	unsigned int resultIndex_;
+};
+
 class FormulaNode {
 public:
 	virtual ~FormulaNode() {}
 
 	virtual float eval(const FormulaSymbolList& symbolList) const = 0;
 	virtual void print(std::ostream& out, int level = 0) const = 0;
+	virtual unsigned int compile(FormulaProgram& program) const = 0;
 };
 
 typedef std::unique_ptr<FormulaNode> FormulaNode_ptr;
@@ -49,6 +101,7 @@ public:
 
 	virtual float eval(const FormulaSymbolList& symbolList) const;
 	virtual void print(std::ostream& out, int level = 0) const;
+	virtual unsigned int compile(FormulaProgram& program) const;
 private:
 	FormulaNode_ptr child_;
 };
@@ -61,6 +114,7 @@ public:
 
 	virtual float eval(const FormulaSymbolList& symbolList) const;
 	virtual void print(std::ostream& out, int level = 0) const;
+	virtual unsigned int compile(FormulaProgram& program) const;
 private:
 	FormulaNode_ptr child1_;
 	FormulaNode_ptr child2_;
@@ -74,6 +128,7 @@ public:
 
 	virtual float eval(const FormulaSymbolList& symbolList) const;
 	virtual void print(std::ostream& out, int level = 0) const;
+	virtual unsigned int compile(FormulaProgram& program) const;
 private:
 	FormulaNode_ptr child1_;
 	FormulaNode_ptr child2_;
@@ -87,6 +142,7 @@ public:
 
 	virtual float eval(const FormulaSymbolList& symbolList) const;
 	virtual void print(std::ostream& out, int level = 0) const;
+	virtual unsigned int compile(FormulaProgram& program) const;
 private:
 	FormulaNode_ptr child1_;
 	FormulaNode_ptr child2_;
@@ -100,6 +156,7 @@ public:
 
 	virtual float eval(const FormulaSymbolList& symbolList) const;
 	virtual void print(std::ostream& out, int level = 0) const;
+	virtual unsigned int compile(FormulaProgram& program) const;
 private:
 	FormulaNode_ptr child1_;
 	FormulaNode_ptr child2_;
@@ -113,6 +170,7 @@ public:
 
 	virtual float eval(const FormulaSymbolList& symbolList) const;
 	virtual void print(std::ostream& out, int level = 0) const;
+	virtual unsigned int compile(FormulaProgram& program) const;
 private:
 	float value_;
 };
@@ -125,6 +183,7 @@ public:
 
 	virtual float eval(const FormulaSymbolList& symbolList) const;
 	virtual void print(std::ostream& out, int level = 0) const;
+	virtual unsigned int compile(FormulaProgram& program) const;
 private:
 	FormulaSymbol::Code symbol_;
 };
@@ -134,7 +193,11 @@ std::ostream& operator<<(std::ostream& out, const Equation& equation);
 
 class Equation {
 public:
-	explicit Equation(const std::string& name) : name_(name) {}
+	enum {
+		INVALID_INDEX = 0xFFFFFFFFU
+	};
+
+	explicit Equation(const std::string& name) : name_(name), index_(INVALID_INDEX) {}
 
 	void setName(const std::string& name) { name_ = name; }
 	const std::string& name() const { return name_; }
@@ -146,6 +209,11 @@ public:
 	const std::string& comment() const { return comment_; }
 
 	float evalFormula(const FormulaSymbolList& symbolList) const;
+	const FormulaProgram& formulaProgram() const { return formulaProgram_; }
+
+	// Dense index of the equation in the model, assigned by Model::compile().
+	unsigned int index() const { return index_; }
+	void setIndex(unsigned int index) { index_ = index; }
 
 	friend std::ostream& operator<<(std::ostream& out, const Equation& equation);
 private:
@@ -153,6 +221,8 @@ private:
 	std::string formula_;
 	std::string comment_;
 	FormulaNode_ptr formulaRoot_;
+	FormulaProgram formulaProgram_; // empty if the formula is too big
+	unsigned int index_;
 };
 
 struct EquationGroup {
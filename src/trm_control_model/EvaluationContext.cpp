@@ -0,0 +1,158 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "EvaluationContext.h"
+
+#include <algorithm> /* fill */
+
+#include "Equation.h"
+#include "Exception.h"
+
+
+
+namespace GS {
+namespace TRMControlModel {
+
+/*******************************************************************************
+ * Constructor.
+ */
+EvaluationContext::EvaluationContext()
+		: formulaSymbolListStamp_(1)
+{
+	formulaSymbolList_.fill(0.0f);
+}
+
+/*******************************************************************************
+ * Destructor.
+ */
+EvaluationContext::~EvaluationContext()
+{
+}
+
+/*******************************************************************************
+ *
+ */
+void
+EvaluationContext::clearFormulaSymbolList()
+{
+	formulaSymbolList_.fill(0.0f);
+	invalidateEquationCache();
+}
+
+/*******************************************************************************
+ *
+ */
+void
+EvaluationContext::setFormulaSymbolValue(FormulaSymbol::Code symbol, float value)
+{
+	formulaSymbolList_[symbol] = value;
+	invalidateEquationCache();
+}
+
+/*******************************************************************************
+ *
+ */
+float
+EvaluationContext::getFormulaSymbolValue(FormulaSymbol::Code symbol) const
+{
+	return formulaSymbolList_[symbol];
+}
+
+/*******************************************************************************
+ *
+ */
+void
+EvaluationContext::setDefaultFormulaSymbols(Transition::Type transitionType)
+{
+	setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION1, 33.3333f);
+	setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION2, 33.3333f);
+	setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION3, 33.3333f);
+	setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION4, 33.3333f);
+
+	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA1      , 33.3333f);
+	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA2      , 33.3333f);
+	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA3      , 33.3333f);
+	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA4      , 33.3333f);
+
+	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB1      , 33.3333f);
+	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB2      , 33.3333f);
+	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB3      , 33.3333f);
+	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB4      , 33.3333f);
+
+	setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO1, 1.0);
+	setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO2, 1.0);
+	setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO3, 1.0);
+	setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO4, 1.0);
+
+	setFormulaSymbolValue(FormulaSymbol::SYMB_BEAT ,  33.0);
+	setFormulaSymbolValue(FormulaSymbol::SYMB_MARK1, 100.0);
+	switch (transitionType) {
+	case Transition::TYPE_DIPHONE:
+		setFormulaSymbolValue(FormulaSymbol::SYMB_RD   , 100.0);
+		setFormulaSymbolValue(FormulaSymbol::SYMB_MARK2,   0.0);
+		setFormulaSymbolValue(FormulaSymbol::SYMB_MARK3,   0.0);
+		break;
+	case Transition::TYPE_TRIPHONE:
+		setFormulaSymbolValue(FormulaSymbol::SYMB_RD   , 200.0);
+		setFormulaSymbolValue(FormulaSymbol::SYMB_MARK2, 200.0);
+		setFormulaSymbolValue(FormulaSymbol::SYMB_MARK3,   0.0);
+		break;
+	case Transition::TYPE_TETRAPHONE:
+		setFormulaSymbolValue(FormulaSymbol::SYMB_RD   , 300.0);
+		setFormulaSymbolValue(FormulaSymbol::SYMB_MARK2, 200.0);
+		setFormulaSymbolValue(FormulaSymbol::SYMB_MARK3, 300.0);
+		break;
+	default:
+		THROW_EXCEPTION(TRMControlModelException, "Invalid transition type: " << transitionType << '.');
+	}
+}
+
+/*******************************************************************************
+ *
+ */
+void
+EvaluationContext::invalidateEquationCache()
+{
+	if (++formulaSymbolListStamp_ == 0) {
+		std::fill(equationCacheStamp_.begin(), equationCacheStamp_.end(), 0);
+		formulaSymbolListStamp_ = 1;
+	}
+}
+
+/*******************************************************************************
+ *
+ */
+float
+EvaluationContext::evalEquationFormula(const Equation& equation)
+{
+	const unsigned int index = equation.index();
+	if (index == Equation::INVALID_INDEX) {
+		return equation.evalFormula(formulaSymbolList_);
+	}
+	if (index >= equationCacheStamp_.size()) {
+		equationValueCache_.resize(index + 1U);
+		equationCacheStamp_.resize(index + 1U);
+	}
+	if (equationCacheStamp_[index] != formulaSymbolListStamp_) {
+		equationValueCache_[index] = equation.evalFormula(formulaSymbolList_);
+		equationCacheStamp_[index] = formulaSymbolListStamp_;
+	}
+	return equationValueCache_[index];
+}
+
+} /* namespace TRMControlModel */
+} /* namespace GS */
@@ -0,0 +1,66 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef TRM_CONTROL_MODEL_EVALUATION_CONTEXT_H_
+#define TRM_CONTROL_MODEL_EVALUATION_CONTEXT_H_
+
+#include <vector>
+
+#include "FormulaSymbol.h"
+#include "Transition.h"
+
+
+
+namespace GS {
+namespace TRMControlModel {
+
+class Equation;
+
+/*******************************************************************************
+ * Formula symbol values used in the evaluation of the equations.
+ *
+ * Each synthesis thread must use its own instance. The Model is not modified
+ * during the synthesis, so it can be shared by all the threads.
+ */
+class EvaluationContext {
+public:
+	EvaluationContext();
+	~EvaluationContext();
+
+	void clearFormulaSymbolList();
+	void setFormulaSymbolValue(FormulaSymbol::Code symbol, float value);
+	float getFormulaSymbolValue(FormulaSymbol::Code symbol) const;
+	void setDefaultFormulaSymbols(Transition::Type transitionType);
+
+	// The result is cached until a formula symbol is modified.
+	float evalEquationFormula(const Equation& equation);
+private:
+	EvaluationContext(const EvaluationContext&) = delete;
+	EvaluationContext& operator=(const EvaluationContext&) = delete;
+
+	void invalidateEquationCache();
+
+	FormulaSymbolList formulaSymbolList_;
+	unsigned int formulaSymbolListStamp_;
+	std::vector<float> equationValueCache_;        // [equation index] -> value
+	std::vector<unsigned int> equationCacheStamp_; // [equation index] -> stamp of the value
+};
+
+} /* namespace TRMControlModel */
+} /* namespace GS */
+
+#endif /* TRM_CONTROL_MODEL_EVALUATION_CONTEXT_H_ */
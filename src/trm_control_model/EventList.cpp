@@ -46,8 +46,10 @@ Event::Event() : time(0), flag(0)
 	}
 }
 
-EventList::EventList(const char* configDirPath, Model& model)
+EventList::EventList(const char* configDirPath, const Model& model)
 		: model_(model)
+		, cancellationToken_(nullptr)
+		, recordRuleEvents_(false)
 		, macroFlag_(0)
 		, microFlag_(0)
 		, driftFlag_(0)
@@ -246,19 +248,30 @@ EventList::newPostureWithObject(const Posture& p)
 	}
 	postureTempo_[currentPosture_] = 1.0;
 	postureData_[currentPosture_].ruleTempo = 1.0;
-	postureData_[currentPosture_].posture = &p;
+	setPosture(postureData_[currentPosture_], p);
 }
 
 void
 EventList::replaceCurrentPostureWith(const Posture& p)
 {
 	if (postureData_[currentPosture_].posture) {
-		postureData_[currentPosture_].posture = &p;
+		setPosture(postureData_[currentPosture_], p);
 	} else {
-		postureData_[currentPosture_ - 1].posture = &p;
+		setPosture(postureData_[currentPosture_ - 1], p);
 	}
 }
 
+// Validates the posture id, so that the target tables can be accessed without checks.
+void
+EventList::setPosture(PostureData& data, const Posture& p)
+{
+	if (!model_.isValidPostureId(p.id()) || &model_.postureList()[p.id()] != &p) {
+		THROW_EXCEPTION(InvalidParameterException, "The posture " << p.name() << " does not belong to the compiled model.");
+	}
+	data.posture = &p;
+	data.postureId = p.id();
+}
+
 void
 EventList::setCurrentToneGroupType(int type)
 {
@@ -418,33 +431,38 @@ EventList::setZeroRef(int newValue)
 
 double
 EventList::createSlopeRatioEvents(
-		const Transition::SlopeRatio& slopeRatio,
-		double baseline, double parameterDelta, double min, double max, int eventIndex)
+		const Transition& transition, const Transition::CompiledPointOrSlope& slopeRatio,
+		double baseline, double parameterDelta, double min, double max, int eventIndex,
+		EvaluationContext& context)
 {
 	double temp = 0.0, temp1 = 0.0, intervalTime = 0.0, sum = 0.0, factor = 0.0;
 	double baseTime = 0.0, endTime = 0.0, totalTime = 0.0, delta = 0.0;
 	double startValue;
 	double pointTime, pointValue;
 
-	Transition::getPointData(*slopeRatio.pointList.front(), model_, pointTime, pointValue);
+	const Transition::CompiledPoint* pointList = &transition.compiledPointList()[slopeRatio.firstPoint];
+	const float* slopeList = &transition.compiledSlopeList()[slopeRatio.firstSlope];
+	const unsigned int numPoints = slopeRatio.numPoints;
+
+	Transition::getPointData(pointList[0], context, pointTime, pointValue);
 	baseTime = pointTime;
 	startValue = pointValue;
 
-	Transition::getPointData(*slopeRatio.pointList.back(), model_, pointTime, pointValue);
+	Transition::getPointData(pointList[numPoints - 1], context, pointTime, pointValue);
 	endTime = pointTime;
 	delta = pointValue - startValue;
 
-	temp = slopeRatio.totalSlopeUnits();
+	temp = slopeRatio.totalSlopeUnits;
 	totalTime = endTime - baseTime;
 
-	int numSlopes = slopeRatio.slopeList.size();
-	std::vector<double> newPointValues(numSlopes - 1);
+	int numSlopes = slopeRatio.numSlopes;
+	slopeRatioPointValues_.resize(numSlopes - 1);
 	for (int i = 1; i < numSlopes + 1; i++) {
-		temp1 = slopeRatio.slopeList[i - 1]->slope / temp; /* Calculate normal slope */
+		temp1 = slopeList[i - 1] / temp; /* Calculate normal slope */
 
 		/* Calculate time interval */
-		intervalTime = Transition::getPointTime(*slopeRatio.pointList[i], model_)
-				- Transition::getPointTime(*slopeRatio.pointList[i - 1], model_);
+		intervalTime = Transition::getPointTime(pointList[i], context)
+				- Transition::getPointTime(pointList[i - 1], context);
 
 		/* Apply interval percentage to slope */
 		temp1 = temp1 * (intervalTime / totalTime);
@@ -454,25 +472,25 @@ EventList::createSlopeRatioEvents(
 		sum += temp1;
 
 		if (i < numSlopes) {
-			newPointValues[i - 1] = temp1;
+			slopeRatioPointValues_[i - 1] = temp1;
 		}
 	}
 	factor = delta / sum;
 	temp = startValue;
 
 	double value = 0.0;
-	for (unsigned int i = 0, size = slopeRatio.pointList.size(); i < size; i++) {
-		const Transition::Point& point = *slopeRatio.pointList[i];
+	for (unsigned int i = 0; i < numPoints; i++) {
+		const Transition::CompiledPoint& point = pointList[i];
 
-		if (i >= 1 && i < slopeRatio.pointList.size() - 1) {
-			pointTime = Transition::getPointTime(point, model_);
+		if (i >= 1 && i < numPoints - 1) {
+			pointTime = Transition::getPointTime(point, context);
 
-			pointValue = newPointValues[i - 1];
+			pointValue = slopeRatioPointValues_[i - 1];
 			pointValue *= factor;
 			pointValue += temp;
 			temp = pointValue;
 		} else {
-			Transition::getPointData(point, model_, pointTime, pointValue);
+			Transition::getPointData(point, context, pointTime, pointValue);
 		}
 
 		value = baseline + ((pointValue / 100.0) * parameterDelta);
@@ -482,26 +500,41 @@ EventList::createSlopeRatioEvents(
 			value = max;
 		}
 		if (!point.isPhantom) {
-			insertEvent(eventIndex, pointTime, value);
+			insertRuleEvent(eventIndex, pointTime, value, false);
 		}
 	}
 
 	return value;
 }
 
-// It is assumed that postureList.size() >= 2.
+// It is assumed that 2 <= numPostures <= 4.
 void
-EventList::applyRule(const Rule& rule, const std::vector<const Posture*>& postureList, const double* tempos, int postureIndex)
+EventList::applyRule(const Rule& rule, unsigned int ruleIndex, unsigned int numPostures, const double* tempos, int postureIndex,
+			EvaluationContext& context)
 {
-	int cont;
-	int currentType;
-	double currentValueDelta, value, lastValue;
 	double ruleSymbols[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
-	double tempTime;
-	double targets[4];
 	Event* tempEvent = nullptr;
 
-	rule.evaluateExpressionSymbols(tempos, postureList, model_, ruleSymbols);
+	unsigned int postureIds[4];
+	for (unsigned int i = 0; i < numPostures; ++i) {
+		postureIds[i] = postureData_[postureIndex + i].postureId;
+	}
+
+	RuleEventCache::Key cacheKey;
+	const RuleEventCache::Template* cachedTemplate = nullptr;
+	if (ruleEventCache_.enabled()) {
+		ruleEventCache_.makeKey(ruleIndex, postureIds, numPostures, tempos, postureData_[postureIndex].ruleTempo, cacheKey);
+		cachedTemplate = ruleEventCache_.find(cacheKey);
+	}
+	recordRuleEvents_ = false;
+
+	if (cachedTemplate) {
+		for (int i = 0; i < 5; ++i) {
+			ruleSymbols[i] = cachedTemplate->ruleSymbols[i];
+		}
+	} else {
+		rule.evaluateExpressionSymbols(tempos, model_, postureIds, numPostures, context, ruleSymbols);
+	}
 
 	multiplier_ = 1.0 / (double) (postureData_[postureIndex].ruleTempo);
 
@@ -517,23 +550,73 @@ EventList::applyRule(const Rule& rule, const std::vector<const Posture*>& postur
 	switch (type) {
 	/* Note: Case 4 should execute all of the below, case 3 the last two */
 	case 4:
-		if (postureList.size() == 4) {
+		if (numPostures == 4) {
 			postureData_[postureIndex + 3].onset = (double) zeroRef_ + ruleSymbols[1];
-			tempEvent = insertEvent(-1, ruleSymbols[3], 0.0);
-			if (tempEvent) tempEvent->flag = 1;
 		}
 		[[fallthrough]];
 	case 3:
-		if (postureList.size() >= 3) {
+		if (numPostures >= 3) {
 			postureData_[postureIndex + 2].onset = (double) zeroRef_ + ruleSymbols[1];
-			tempEvent = insertEvent(-1, ruleSymbols[2], 0.0);
-			if (tempEvent) tempEvent->flag = 1;
 		}
 		[[fallthrough]];
 	case 2:
 		postureData_[postureIndex + 1].onset = (double) zeroRef_ + ruleSymbols[1];
-		tempEvent = insertEvent(-1, 0.0, 0.0);
-		if (tempEvent) tempEvent->flag = 1;
+		break;
+	}
+
+	if (cachedTemplate) {
+		for (const RuleEventCache::EventCall& call : cachedTemplate->eventList) {
+			insertRuleEvent(call.number, call.time, call.value, call.setFlag);
+		}
+	} else {
+		if (ruleEventCache_.enabled()) {
+			for (int i = 0; i < 5; ++i) {
+				ruleEventTemplate_.ruleSymbols[i] = ruleSymbols[i];
+			}
+			ruleEventTemplate_.eventList.clear();
+			recordRuleEvents_ = true;
+		}
+
+		createRuleEvents(rule, numPostures, postureIds, ruleSymbols, context);
+
+		if (recordRuleEvents_) {
+			recordRuleEvents_ = false;
+			ruleEventCache_.insert(cacheKey, ruleEventTemplate_);
+		}
+	}
+
+	setZeroRef((int) (ruleSymbols[0] * multiplier_) + zeroRef_);
+	tempEvent = insertEvent(-1, 0.0, 0.0);
+	if (tempEvent) tempEvent->flag = 1;
+}
+
+// Creates the events of the rule, relative to the zero reference.
+void
+EventList::createRuleEvents(const Rule& rule, unsigned int numPostures, const unsigned int* postureIds, const double* ruleSymbols,
+				EvaluationContext& context)
+{
+	int cont;
+	int currentType;
+	double currentValueDelta, value, lastValue;
+	double tempTime;
+	double targets[4];
+
+	int type = rule.numberOfExpressions();
+
+	switch (type) {
+	/* Note: Case 4 should execute all of the below, case 3 the last two */
+	case 4:
+		if (numPostures == 4) {
+			insertRuleEvent(-1, ruleSymbols[3], 0.0, true);
+		}
+		[[fallthrough]];
+	case 3:
+		if (numPostures >= 3) {
+			insertRuleEvent(-1, ruleSymbols[2], 0.0, true);
+		}
+		[[fallthrough]];
+	case 2:
+		insertRuleEvent(-1, 0.0, 0.0, true);
 		break;
 	}
 
@@ -542,10 +625,10 @@ EventList::applyRule(const Rule& rule, const std::vector<const Posture*>& postur
 	/* Loop through the parameters */
 	for (unsigned int i = 0, size = model_.parameterList().size(); i < size; ++i) {
 		/* Get actual parameter target values */
-		targets[0] = postureList[0]->getParameterTarget(i);
-		targets[1] = postureList[1]->getParameterTarget(i);
-		targets[2] = (postureList.size() >= 3) ? postureList[2]->getParameterTarget(i) : 0.0;
-		targets[3] = (postureList.size() == 4) ? postureList[3]->getParameterTarget(i) : 0.0;
+		targets[0] = model_.postureParameterTarget(postureIds[0], i);
+		targets[1] = model_.postureParameterTarget(postureIds[1], i);
+		targets[2] = (numPostures >= 3) ? model_.postureParameterTarget(postureIds[2], i) : 0.0;
+		targets[3] = (numPostures == 4) ? model_.postureParameterTarget(postureIds[3], i) : 0.0;
 
 		/* Optimization, Don't calculate if no changes occur */
 		cont = 1;
@@ -567,7 +650,7 @@ EventList::applyRule(const Rule& rule, const std::vector<const Posture*>& postur
 			break;
 		}
 
-		insertEvent(i, 0.0, targets[0]);
+		insertRuleEvent(i, 0.0, targets[0], false);
 
 		if (cont) {
 			currentType = DIPHONE;
@@ -575,39 +658,34 @@ EventList::applyRule(const Rule& rule, const std::vector<const Posture*>& postur
 			lastValue = targets[0];
 			//lastValue = 0.0;
 
-			const std::shared_ptr<Transition> transition = rule.getParamProfileTransition(i);
+			const Transition* transition = rule.getParamProfileTransition(i).get();
 			if (!transition) {
 				THROW_EXCEPTION(UnavailableResourceException, "Rule transition not found: " << i << '.');
 			}
+			if (!transition->compiled()) {
+				THROW_EXCEPTION(InvalidStateException, "Transition not compiled: " << transition->name() << '.');
+			}
 
 			/* Apply lists to parameter */
-			for (unsigned int j = 0; j < transition->pointOrSlopeList().size(); ++j) {
-				const Transition::PointOrSlope& pointOrSlope = *transition->pointOrSlopeList()[j];
-				if (pointOrSlope.isSlopeRatio()) {
-					const auto& slopeRatio = dynamic_cast<const Transition::SlopeRatio&>(pointOrSlope);
-
-					if (slopeRatio.pointList[0]->type != currentType) { //TODO: check pointList.size() > 0
-						currentType = slopeRatio.pointList[0]->type;
-						targets[currentType - 2] = lastValue;
-						currentValueDelta = targets[currentType - 1] - lastValue;
-					}
+			const Transition::CompiledPoint* pointList = transition->compiledPointList().data();
+			for (const Transition::CompiledPointOrSlope& pointOrSlope : transition->compiledPointOrSlopeList()) {
+				const Transition::CompiledPoint& firstPoint = pointList[pointOrSlope.firstPoint];
+				if (firstPoint.type != currentType) {
+					currentType = firstPoint.type;
+					targets[currentType - 2] = lastValue;
+					currentValueDelta = targets[currentType - 1] - lastValue;
+				}
+				if (pointOrSlope.isSlopeRatio) {
 					value = createSlopeRatioEvents(
-							slopeRatio, targets[currentType - 2], currentValueDelta,
-							min_[i], max_[i], i);
+							*transition, pointOrSlope, targets[currentType - 2], currentValueDelta,
+							min_[i], max_[i], i, context);
 				} else {
-					const auto& point = dynamic_cast<const Transition::Point&>(pointOrSlope);
-
-					if (point.type != currentType) {
-						currentType = point.type;
-						targets[currentType - 2] = lastValue;
-						currentValueDelta = targets[currentType - 1] - lastValue;
-					}
 					double pointTime;
-					Transition::getPointData(point, model_,
+					Transition::getPointData(firstPoint, context,
 									targets[currentType - 2], currentValueDelta, min_[i], max_[i],
 									pointTime, value);
-					if (!point.isPhantom) {
-						insertEvent(i, pointTime, value);
+					if (!firstPoint.isPhantom) {
+						insertRuleEvent(i, pointTime, value, false);
 					}
 				}
 				lastValue = value;
@@ -620,28 +698,47 @@ EventList::applyRule(const Rule& rule, const std::vector<const Posture*>& postur
 
 	/* Special Event Profiles */
 	for (unsigned int i = 0, size = model_.parameterList().size(); i < size; ++i) {
-		const std::shared_ptr<Transition> specialTransition = rule.getSpecialProfileTransition(i);
+		const Transition* specialTransition = rule.getSpecialProfileTransition(i).get();
 		if (specialTransition) {
-			for (unsigned int j = 0; j < specialTransition->pointOrSlopeList().size(); ++j) {
-				const Transition::PointOrSlope& pointOrSlope = *specialTransition->pointOrSlopeList()[j];
-				const auto& point = dynamic_cast<const Transition::Point&>(pointOrSlope);
+			if (!specialTransition->compiled()) {
+				THROW_EXCEPTION(InvalidStateException, "Transition not compiled: " << specialTransition->name() << '.');
+			}
+			for (const Transition::CompiledPointOrSlope& pointOrSlope : specialTransition->compiledPointOrSlopeList()) {
+				if (pointOrSlope.isSlopeRatio) {
+					THROW_EXCEPTION(TRMControlModelException, "Slope ratio in special transition: " << specialTransition->name() << '.');
+				}
+				const Transition::CompiledPoint& point = specialTransition->compiledPointList()[pointOrSlope.firstPoint];
 
 				/* calculate time of event */
-				tempTime = Transition::getPointTime(point, model_);
+				tempTime = Transition::getPointTime(point, context);
 
 				/* Calculate value of event */
 				value = ((point.value / 100.0) * (max_[i] - min_[i]));
 				//maxValue = value;
 
 				/* insert event into event list */
-				insertEvent(i + 16U, tempTime, value);
+				insertRuleEvent(i + 16U, tempTime, value, false);
 			}
 		}
 	}
+}
 
-	setZeroRef((int) (ruleSymbols[0] * multiplier_) + zeroRef_);
-	tempEvent = insertEvent(-1, 0.0, 0.0);
-	if (tempEvent) tempEvent->flag = 1;
+// The call is recorded in the rule event template if requested.
+void
+EventList::insertRuleEvent(int number, double time, double value, bool setFlag)
+{
+	Event* event = insertEvent(number, time, value);
+	if (setFlag && event) {
+		event->flag = 1;
+	}
+	if (recordRuleEvents_) {
+		RuleEventCache::EventCall call;
+		call.number = number;
+		call.time = time;
+		call.value = value;
+		call.setFlag = setFlag;
+		ruleEventTemplate_.eventList.push_back(call);
+	}
 }
 
 void
@@ -692,6 +789,9 @@ EventList::generateEventList()
 		if (tempPostureList.size() < 2) {
 			break;
 		}
+		if (cancellationToken_ != nullptr) {
+			cancellationToken_->check();
+		}
 		unsigned int ruleIndex = 0;
 		const Rule* tempRule = model_.findFirstMatchingRule(tempPostureList, ruleIndex);
 		if (tempRule == nullptr) {
@@ -700,7 +800,7 @@ EventList::generateEventList()
 
 		ruleData_[currentRule_].number = ruleIndex + 1U;
 
-		applyRule(*tempRule, tempPostureList, &postureTempo_[basePostureIndex], basePostureIndex);
+		applyRule(*tempRule, ruleIndex, tempPostureList.size(), &postureTempo_[basePostureIndex], basePostureIndex, evaluationContext_);
 
 		basePostureIndex += tempRule->numberOfExpressions() - 1;
 	}
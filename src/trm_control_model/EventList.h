@@ -27,9 +27,12 @@
 #include <random>
 #include <vector>
 
+#include "CancellationToken.h"
 #include "DriftGenerator.h"
+#include "EvaluationContext.h"
 #include "IntonationPoint.h"
 #include "Model.h"
+#include "RuleEventCache.h"
 #include "Tube.h"
 
 #define TONE_GROUP_TYPE_STATEMENT    0
@@ -47,11 +50,13 @@ namespace TRMControlModel {
 
 struct PostureData {
 	const Posture* posture;
+	unsigned int postureId; // index in the target tables of the model
 	int    syllable;
 	double onset;
 	float  ruleTempo;
 	PostureData()
 		: posture(nullptr)
+		, postureId(Posture::INVALID_ID)
 		, syllable(0)
 		, onset(0.0)
 		, ruleTempo(0.0) {}
@@ -123,7 +128,7 @@ typedef std::unique_ptr<Event> Event_ptr;
 
 class EventList {
 public:
-	EventList(const char* configDirPath, Model& model);
+	EventList(const char* configDirPath, const Model& model);
 	~EventList();
 
 	const std::vector<Event_ptr>& list() const { return list_; }
@@ -165,6 +170,11 @@ public:
 	void setCurrentPostureRuleTempo(float tempo);
 	void newToneGroup();
 	void generateEventList();
+
+	// Cache of the events created by the rules. Persists across setUp() calls.
+	RuleEventCache& ruleEventCache() { return ruleEventCache_; }
+	const RuleEventCache& ruleEventCache() const { return ruleEventCache_; }
+
 	void applyIntonation();
 	void applyIntonationSmooth();
 	void generateOutput(std::ostream& trmParamStream);
@@ -181,6 +191,9 @@ public:
 	void setFixedIntonationParameters(float notionalPitch, float pretonicRange, float pretonicLift, float tonicRange, float tonicMovement);
 
 	void setRadiusCoef(const double* values);
+
+	// The token is checked before each rule application. May be nullptr.
+	void setCancellationToken(const CancellationToken* token) { cancellationToken_ = token; }
 private:
 	EventList(const EventList&) = delete;
 	EventList& operator=(const EventList&) = delete;
@@ -193,12 +206,23 @@ private:
 	void newPosture();
 	Event* insertEvent(int number, double time, double value);
 	void setZeroRef(int newValue);
-	void applyRule(const Rule& rule, const std::vector<const Posture*>& postureList, const double* tempos, int postureIndex);
+	void applyRule(const Rule& rule, unsigned int ruleIndex, unsigned int numPostures, const double* tempos, int postureIndex,
+			EvaluationContext& context);
+	void createRuleEvents(const Rule& rule, unsigned int numPostures, const unsigned int* postureIds, const double* ruleSymbols,
+				EvaluationContext& context);
+	void insertRuleEvent(int number, double time, double value, bool setFlag);
+	void setPosture(PostureData& data, const Posture& p);
 	void printDataStructures();
-	double createSlopeRatioEvents(const Transition::SlopeRatio& slopeRatio,
-			double baseline, double parameterDelta, double min, double max, int eventIndex);
+	double createSlopeRatioEvents(const Transition& transition, const Transition::CompiledPointOrSlope& slopeRatio,
+			double baseline, double parameterDelta, double min, double max, int eventIndex,
+			EvaluationContext& context);
 
-	Model& model_;
+	const Model& model_;
+	const CancellationToken* cancellationToken_;
+	EvaluationContext evaluationContext_;
+	RuleEventCache ruleEventCache_;
+	RuleEventCache::Template ruleEventTemplate_;
+	bool recordRuleEvents_;
 
 	int zeroRef_;
 	int zeroIndex_;
@@ -233,6 +257,7 @@ private:
 
 	std::vector<IntonationPoint> intonationPoints_;
 	std::vector<Event_ptr> list_;
+	std::vector<double> slopeRatioPointValues_;
 	DriftGenerator driftGenerator_;
 
 	bool tgUseRandom_;
@@ -23,9 +23,14 @@
 #include "Model.h"
 
 #include <algorithm> /* sort */
+#include <cstdint>
+#include <fstream>
 #include <iostream>
 #include <utility> /* make_pair */
 
+#include "BinaryModelFile.h"
+#include "BinaryModelFileReader.h"
+#include "BinaryModelFileWriter.h"
 #include "Log.h"
 #include "XMLConfigFileReader.h"
 #include "XMLConfigFileWriter.h"
@@ -39,6 +44,8 @@ namespace TRMControlModel {
  * Constructor.
  */
 Model::Model()
+		: binaryCacheEnabled_(false)
+		, numCompiledPostures_(0)
 {
 }
 
@@ -57,12 +64,15 @@ Model::clear()
 {
 	categoryList_.clear();
 	parameterList_.clear();
+	symbolList_.clear();
 	postureList_.clear();
 	ruleList_.clear();
 	equationGroupList_.clear();
 	transitionGroupList_.clear();
 	specialTransitionGroupList_.clear();
-	formulaSymbolList_.fill(0.0f);
+	numCompiledPostures_ = 0;
+	postureParameterTargetTable_.clear();
+	postureSymbolTargetTable_.clear();
 }
 
 /*******************************************************************************
@@ -73,17 +83,62 @@ Model::load(const char* configDirPath, const char* configFileName)
 {
 	clear();
 
-	try {
-		std::string filePath = std::string(configDirPath) + configFileName;
+	std::string filePath = std::string(configDirPath) + configFileName;
+	std::string cacheFilePath = filePath + BinaryModelFile::FILE_NAME_SUFFIX;
+
+	std::uint64_t sourceSize = 0;
+	std::uint64_t sourceHash = 0;
+	bool useCache = false;
+	if (binaryCacheEnabled_) {
+		std::ifstream in(filePath, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+		if (in) {
+			std::string source(static_cast<std::size_t>(in.tellg()), '\0');
+			in.seekg(0);
+			if (in.read(&source[0], source.size())) {
+				sourceSize = source.size();
+				sourceHash = BinaryModelFile::hash(source.data(), source.size());
+				useCache = true;
+			}
+		}
+	}
+
+	if (useCache) {
+		try {
+			LOG_DEBUG("Loading binary model cache: " << cacheFilePath);
+			BinaryModelFileReader cache(*this, cacheFilePath);
+			if (cache.loadModel(sourceSize, sourceHash)) {
+				compile();
+				return;
+			}
+			LOG_DEBUG("The binary model cache is missing or out of date.");
+		} catch (std::exception& e) {
+			LOG_ERROR("Could not load the binary model cache " << cacheFilePath << ": " << e.what());
+		}
+		clear();
+	}
 
+	try {
 		// Load the configuration file.
 		LOG_DEBUG("Loading xml configuration: " << filePath);
 		XMLConfigFileReader cfg(*this, filePath);
 		cfg.loadModel();
+
+		compile();
 	} catch (...) {
 		clear();
 		throw;
 	}
+
+	if (useCache) {
+		try {
+			LOG_DEBUG("Saving binary model cache: " << cacheFilePath);
+			BinaryModelFileWriter cache(*this, cacheFilePath);
+			cache.saveModel(sourceSize, sourceHash);
+		} catch (std::exception& e) {
+			// The directory may be read-only.
+			LOG_DEBUG("Could not save the binary model cache " << cacheFilePath << ": " << e.what());
+		}
+	}
 }
 
 /*******************************************************************************
@@ -100,6 +155,79 @@ Model::save(const char* configDirPath, const char* configFileName)
 	cfg.saveModel();
 }
 
+/*******************************************************************************
+ * Builds the data structures used during the synthesis.
+ *
+ * Must be called again after the categories, postures, equations or rules
+ * are modified. After this call, the synthesis does not modify the Model.
+ */
+void
+Model::compile()
+{
+	// Assign the category codes. The native categories of the postures
+	// are placed after the categories of the model.
+	unsigned int code = 0;
+	for (auto& category : categoryList_) {
+		category->setCode(code++);
+	}
+	for (unsigned int i = 0, size = postureList_.size(); i < size; ++i) {
+		Posture& posture = postureList_[i];
+		for (auto& category : posture.categoryList()) {
+			if (category->native()) {
+				category->setCode(code++);
+			}
+		}
+	}
+
+	for (unsigned int i = 0, size = postureList_.size(); i < size; ++i) {
+		postureList_[i].updateCategoryMask();
+	}
+
+	// Build the target tables.
+	const unsigned int numPostures = postureList_.size();
+	const unsigned int numParameters = parameterList_.size();
+	const unsigned int numSymbols = symbolList_.size();
+	if (numSymbols < 4) { // the rules use the symbols 1 to 3
+		THROW_EXCEPTION(InvalidStateException, "Invalid number of symbols: " << numSymbols << '.');
+	}
+	numCompiledPostures_ = 0;
+	postureParameterTargetTable_.assign(numPostures * numParameters, 0.0);
+	postureSymbolTargetTable_.assign(numPostures * numSymbols, 0.0);
+	for (unsigned int i = 0; i < numPostures; ++i) {
+		Posture& posture = postureList_[i];
+		for (unsigned int j = 0; j < numParameters; ++j) {
+			postureParameterTargetTable_[i * numParameters + j] = posture.getParameterTarget(j);
+		}
+		for (unsigned int j = 0; j < numSymbols; ++j) {
+			postureSymbolTargetTable_[i * numSymbols + j] = posture.getSymbolTarget(j);
+		}
+		posture.setId(i);
+	}
+	numCompiledPostures_ = numPostures;
+
+	for (auto& rule : ruleList_) {
+		rule->compileBooleanExpressions(*this);
+	}
+
+	unsigned int equationIndex = 0;
+	for (auto& group : equationGroupList_) {
+		for (auto& equation : group.equationList) {
+			equation->setIndex(equationIndex++);
+		}
+	}
+
+	for (auto& group : transitionGroupList_) {
+		for (auto& transition : group.transitionList) {
+			transition->compile();
+		}
+	}
+	for (auto& group : specialTransitionGroupList_) {
+		for (auto& transition : group.transitionList) {
+			transition->compile();
+		}
+	}
+}
+
 /*******************************************************************************
  *
  */
@@ -164,6 +292,7 @@ Model::printInfo() const
 			std::cout << "=== Equation: [" << equation->name() << "]" << std::endl;
 			std::cout << "    [" << equation->formula() << "]" << std::endl;
 			std::cout << *equation << std::endl;
+			equation->formulaProgram().print(std::cout);
 			std::cout << "*** EVAL=" << equation->evalFormula(symbolList) << std::endl;
 		}
 	}
@@ -314,91 +443,6 @@ Model::findCategoryName(const std::string& name) const
 	return false;
 }
 
-/*******************************************************************************
- *
- */
-void
-Model::clearFormulaSymbolList()
-{
-	formulaSymbolList_.fill(0.0);
-}
-
-/*******************************************************************************
- *
- */
-void
-Model::setFormulaSymbolValue(FormulaSymbol::Code symbol, float value)
-{
-	formulaSymbolList_[symbol] = value;
-}
-
-/*******************************************************************************
- *
- */
-float
-Model::getFormulaSymbolValue(FormulaSymbol::Code symbol) const
-{
-	return formulaSymbolList_[symbol];
-}
-
-/*******************************************************************************
- *
- */
-void
-Model::setDefaultFormulaSymbols(Transition::Type transitionType)
-{
-	setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION1, 33.3333f);
-	setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION2, 33.3333f);
-	setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION3, 33.3333f);
-	setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION4, 33.3333f);
-
-	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA1      , 33.3333f);
-	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA2      , 33.3333f);
-	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA3      , 33.3333f);
-	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA4      , 33.3333f);
-
-	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB1      , 33.3333f);
-	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB2      , 33.3333f);
-	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB3      , 33.3333f);
-	setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB4      , 33.3333f);
-
-	setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO1, 1.0);
-	setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO2, 1.0);
-	setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO3, 1.0);
-	setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO4, 1.0);
-
-	setFormulaSymbolValue(FormulaSymbol::SYMB_BEAT ,  33.0);
-	setFormulaSymbolValue(FormulaSymbol::SYMB_MARK1, 100.0);
-	switch (transitionType) {
-	case Transition::TYPE_DIPHONE:
-		setFormulaSymbolValue(FormulaSymbol::SYMB_RD   , 100.0);
-		setFormulaSymbolValue(FormulaSymbol::SYMB_MARK2,   0.0);
-		setFormulaSymbolValue(FormulaSymbol::SYMB_MARK3,   0.0);
-		break;
-	case Transition::TYPE_TRIPHONE:
-		setFormulaSymbolValue(FormulaSymbol::SYMB_RD   , 200.0);
-		setFormulaSymbolValue(FormulaSymbol::SYMB_MARK2, 200.0);
-		setFormulaSymbolValue(FormulaSymbol::SYMB_MARK3,   0.0);
-		break;
-	case Transition::TYPE_TETRAPHONE:
-		setFormulaSymbolValue(FormulaSymbol::SYMB_RD   , 300.0);
-		setFormulaSymbolValue(FormulaSymbol::SYMB_MARK2, 200.0);
-		setFormulaSymbolValue(FormulaSymbol::SYMB_MARK3, 300.0);
-		break;
-	default:
-		THROW_EXCEPTION(TRMControlModelException, "Invalid transition type: " << transitionType << '.');
-	}
-}
-
-/*******************************************************************************
- *
- */
-float
-Model::evalEquationFormula(const Equation& equation) const
-{
-	return equation.evalFormula(formulaSymbolList_);
-}
-
 /*******************************************************************************
  *
  */
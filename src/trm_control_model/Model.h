@@ -52,17 +52,21 @@ public:
 	~Model();
 
 	void clear();
+	// If the binary cache is enabled, the model is loaded from the file
+	// <configFileName>.cache, if it was created from the current XML file.
+	// Otherwise the XML file is loaded, and the cache is (re)created.
+	// The cache is disabled by default, because the configuration directory
+	// may be read-only or shared (see model_cache in trm_control_model.txt).
 	void load(const char* configDirPath, const char* configFileName);
 	void save(const char* configDirPath, const char* configFileName);
+	void compile();
+
+	bool binaryCacheEnabled() const { return binaryCacheEnabled_; }
+	void setBinaryCacheEnabled(bool enabled) { binaryCacheEnabled_ = enabled; }
 	void printInfo() const;
-	void clearFormulaSymbolList();
-	void setFormulaSymbolValue(FormulaSymbol::Code symbol, float value);
-	float getFormulaSymbolValue(FormulaSymbol::Code symbol) const;
-	void setDefaultFormulaSymbols(Transition::Type transitionType);
 
 	const std::vector<EquationGroup>& equationGroupList() const { return equationGroupList_; }
 	std::vector<EquationGroup>& equationGroupList() { return equationGroupList_; }
-	float evalEquationFormula(const Equation& equation) const;
 	bool findEquationGroupName(const std::string& name) const;
 	bool findEquationName(const std::string& name) const;
 	bool findEquationIndex(const std::string& name, unsigned int& groupIndex, unsigned int& index) const;
@@ -83,6 +87,16 @@ public:
 	const PostureList& postureList() const { return postureList_; }
 	PostureList& postureList() { return postureList_; }
 
+	// Target tables, built by compile().
+	// The access is unchecked, the posture id must have been validated with isValidPostureId().
+	bool isValidPostureId(unsigned int postureId) const { return postureId < numCompiledPostures_; }
+	float postureParameterTarget(unsigned int postureId, unsigned int parameterIndex) const {
+		return postureParameterTargetTable_[postureId * parameterList_.size() + parameterIndex];
+	}
+	float postureSymbolTarget(unsigned int postureId, unsigned int symbolIndex) const {
+		return postureSymbolTargetTable_[postureId * symbolList_.size() + symbolIndex];
+	}
+
 	const std::vector<TransitionGroup>& transitionGroupList() const { return transitionGroupList_; }
 	std::vector<TransitionGroup>& transitionGroupList() { return transitionGroupList_; }
 	const std::shared_ptr<Transition> findTransition(const std::string& name) const;
@@ -115,7 +129,10 @@ private:
 	std::vector<EquationGroup> equationGroupList_;
 	std::vector<TransitionGroup> transitionGroupList_;
 	std::vector<TransitionGroup> specialTransitionGroupList_;
-	FormulaSymbolList formulaSymbolList_;
+	bool binaryCacheEnabled_;
+	unsigned int numCompiledPostures_;
+	std::vector<float> postureParameterTargetTable_; // [posture id * number of parameters + parameter index]
+	std::vector<float> postureSymbolTargetTable_;    // [posture id * number of symbols + symbol index]
 };
 
 } /* namespace TRMControlModel */
@@ -23,6 +23,7 @@
 #ifndef TRM_CONTROL_MODEL_POSTURE_H_
 #define TRM_CONTROL_MODEL_POSTURE_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -38,6 +39,10 @@ namespace TRMControlModel {
 
 class Posture {
 public:
+	enum {
+		INVALID_ID = 0xFFFFFFFFU
+	};
+
 	struct Symbols {
 		float duration;
 		float transition;
@@ -50,7 +55,8 @@ public:
 	Posture(const std::string& name, unsigned int numParameters, unsigned int numSymbols)
 			: name_(name)
 			, parameterTargetList_(numParameters)
-			, symbolTargetList_(numSymbols) {
+			, symbolTargetList_(numSymbols)
+			, id_(INVALID_ID) {
 		if (numParameters == 0) {
 			THROW_EXCEPTION(InvalidParameterException, "Invalid number of parameters: 0.");
 		}
@@ -65,6 +71,10 @@ public:
 
 	const std::string& name() const { return name_; }
 
+	// Index in the target tables of the model. Assigned by Model::compile().
+	unsigned int id() const { return id_; }
+	void setId(unsigned int id) { id_ = id; }
+
 	const std::vector<std::shared_ptr<Category>>& categoryList() const { return categoryList_; }
 	std::vector<std::shared_ptr<Category>>& categoryList() { return categoryList_; }
 
@@ -100,8 +110,13 @@ public:
 	void setComment(const std::string& comment) { comment_ = comment; }
 
 	bool isMemberOfCategory(const Category& category) const;
+	bool isMemberOfCategory(unsigned int categoryCode) const;
 	const std::shared_ptr<Category> findCategory(const std::string& name) const;
 
+	// Rebuilds the category bitset from the category list.
+	// The category codes must have been assigned.
+	void updateCategoryMask();
+
 	std::unique_ptr<Posture> copy(const std::string& newName) const;
 private:
 	std::string name_; // must be immutable
@@ -109,6 +124,8 @@ private:
 	std::vector<float> parameterTargetList_;
 	std::vector<float> symbolTargetList_;
 	std::string comment_;
+	std::vector<std::uint64_t> categoryMask_; // bit [category code] is set if the posture is a member of the category
+	unsigned int id_;
 };
 
 
@@ -135,6 +152,10 @@ inline
 bool
 Posture::isMemberOfCategory(const Category& category) const
 {
+	if (!categoryMask_.empty()) {
+		return isMemberOfCategory(category.code());
+	}
+
 	for (const auto& postureCat : categoryList_) {
 		if (postureCat.get() == &category) {
 			return true;
@@ -143,6 +164,38 @@ Posture::isMemberOfCategory(const Category& category) const
 	return false;
 }
 
+/*******************************************************************************
+ * Uses only the category bitset.
+ */
+inline
+bool
+Posture::isMemberOfCategory(unsigned int categoryCode) const
+{
+	const unsigned int word = categoryCode >> 6;
+	return word < categoryMask_.size() && ((categoryMask_[word] >> (categoryCode & 63U)) & 1U);
+}
+
+/*******************************************************************************
+ *
+ */
+inline
+void
+Posture::updateCategoryMask()
+{
+	categoryMask_.clear();
+	for (const auto& category : categoryList_) {
+		const unsigned int code = category->code();
+		if (code == Category::INVALID_CODE) {
+			THROW_EXCEPTION(InvalidStateException, "Category without code: " << category->name() << '.');
+		}
+		const unsigned int word = code >> 6;
+		if (word >= categoryMask_.size()) {
+			categoryMask_.resize(word + 1U);
+		}
+		categoryMask_[word] |= std::uint64_t(1) << (code & 63U);
+	}
+}
+
 /*******************************************************************************
  *
  */
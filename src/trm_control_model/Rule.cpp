@@ -28,6 +28,7 @@
 
 #include "Category.h"
 #include "Equation.h"
+#include "EvaluationContext.h"
 #include "Model.h"
 #include "Posture.h"
 #include "Text.h"
@@ -283,6 +284,91 @@ Parser::parse()
 namespace GS {
 namespace TRMControlModel {
 
+/*******************************************************************************
+ *
+ */
+void
+RuleBooleanProgram::addCategory(unsigned int categoryCode)
+{
+	if (categoryCode == Category::INVALID_CODE) {
+		THROW_EXCEPTION(InvalidStateException, "Invalid category code.");
+	}
+	if (++stackSize_ > MAX_STACK_SIZE) {
+		THROW_EXCEPTION(TRMControlModelException, "Boolean expression is too complex.");
+	}
+	if (stackSize_ > maxStackSize_) {
+		maxStackSize_ = stackSize_;
+	}
+
+	Instruction instr;
+	instr.op = OP_CATEGORY;
+	instr.categoryCode = categoryCode;
+	instructionList_.push_back(instr);
+}
+
+/*******************************************************************************
+ *
+ */
+void
+RuleBooleanProgram::addOperation(OpCode op)
+{
+	switch (op) {
+	case OP_AND:
+	case OP_OR:
+	case OP_XOR:
+		if (stackSize_ < 2) {
+			THROW_EXCEPTION(InvalidStateException, "Missing operand in boolean program.");
+		}
+		--stackSize_;
+		break;
+	case OP_NOT:
+		if (stackSize_ < 1) {
+			THROW_EXCEPTION(InvalidStateException, "Missing operand in boolean program.");
+		}
+		break;
+	default:
+		THROW_EXCEPTION(InvalidParameterException, "Invalid boolean operation: " << op << '.');
+	}
+
+	Instruction instr;
+	instr.op = op;
+	instr.categoryCode = Category::INVALID_CODE;
+	instructionList_.push_back(instr);
+}
+
+/*******************************************************************************
+ * The top of the stack is the bit 0.
+ */
+bool
+RuleBooleanProgram::eval(const Posture& posture) const
+{
+	assert(stackSize_ == 1);
+
+	std::uint32_t stack = 0;
+	for (const Instruction& instr : instructionList_) {
+		switch (instr.op) {
+		case OP_CATEGORY:
+			stack = (stack << 1) | (posture.isMemberOfCategory(instr.categoryCode) ? 1U : 0U);
+			break;
+		case OP_AND:
+			stack = (stack >> 1) & (~std::uint32_t(1) | (stack & 1U));
+			break;
+		case OP_OR:
+			stack = (stack >> 1) | (stack & 1U);
+			break;
+		case OP_XOR:
+			stack = (stack >> 1) ^ (stack & 1U);
+			break;
+		case OP_NOT:
+			stack ^= 1U;
+			break;
+		}
+	}
+	return stack & 1U;
+}
+
+//==============================================================================
+
 /*******************************************************************************
  * Destructor.
  */
@@ -319,6 +405,16 @@ RuleBooleanAndExpression::print(std::ostream& out, int level) const
 	out << prefix << "]" << std::endl;
 }
 
+void
+RuleBooleanAndExpression::compile(const Model& model, RuleBooleanProgram& program) const
+{
+	assert(child1_.get() != 0 && child2_.get() != 0);
+
+	child1_->compile(model, program);
+	child2_->compile(model, program);
+	program.addOperation(RuleBooleanProgram::OP_AND);
+}
+
 /*******************************************************************************
  * Destructor.
  */
@@ -348,6 +444,16 @@ RuleBooleanOrExpression::print(std::ostream& out, int level) const
 	out << prefix << "]" << std::endl;
 }
 
+void
+RuleBooleanOrExpression::compile(const Model& model, RuleBooleanProgram& program) const
+{
+	assert(child1_.get() != 0 && child2_.get() != 0);
+
+	child1_->compile(model, program);
+	child2_->compile(model, program);
+	program.addOperation(RuleBooleanProgram::OP_OR);
+}
+
 /*******************************************************************************
  * Destructor.
  */
@@ -377,6 +483,16 @@ RuleBooleanXorExpression::print(std::ostream& out, int level) const
 	out << prefix << "]" << std::endl;
 }
 
+void
+RuleBooleanXorExpression::compile(const Model& model, RuleBooleanProgram& program) const
+{
+	assert(child1_.get() != 0 && child2_.get() != 0);
+
+	child1_->compile(model, program);
+	child2_->compile(model, program);
+	program.addOperation(RuleBooleanProgram::OP_XOR);
+}
+
 /*******************************************************************************
  * Destructor.
  */
@@ -405,6 +521,15 @@ RuleBooleanNotExpression::print(std::ostream& out, int level) const
 	out << prefix << "]" << std::endl;
 }
 
+void
+RuleBooleanNotExpression::compile(const Model& model, RuleBooleanProgram& program) const
+{
+	assert(child_.get() != 0);
+
+	child_->compile(model, program);
+	program.addOperation(RuleBooleanProgram::OP_NOT);
+}
+
 /*******************************************************************************
  * Destructor.
  */
@@ -433,6 +558,37 @@ RuleBooleanTerminal::print(std::ostream& out, int level) const
 	out << "]" << std::endl;
 }
 
+void
+RuleBooleanTerminal::compile(const Model& model, RuleBooleanProgram& program) const
+{
+	program.addCategory(category_->code());
+	if (matchAll_) {
+		// eval() compares the name of the posture with "<category name>'".
+		// The program tests the native category of that posture instead,
+		// which is equivalent only if the posture is its only member.
+		const std::string markedName = category_->name() + '\'';
+		const Posture* markedPosture = model.postureList().find(markedName);
+		if (markedPosture == nullptr) {
+			THROW_EXCEPTION(TRMControlModelException, "Could not compile the rule term " << category_->name()
+					<< "*: posture " << markedName << " not found.");
+		}
+		const std::shared_ptr<Category> markedCategory = markedPosture->findCategory(markedName);
+		if (!markedCategory) {
+			THROW_EXCEPTION(TRMControlModelException, "Could not compile the rule term " << category_->name()
+					<< "*: the posture " << markedName << " has no native category.");
+		}
+		const PostureList& postureList = model.postureList();
+		for (PostureList::size_type size = postureList.size(), i = 0; i < size; ++i) {
+			if (&postureList[i] != markedPosture && postureList[i].isMemberOfCategory(*markedCategory)) {
+				THROW_EXCEPTION(TRMControlModelException, "Could not compile the rule term " << category_->name()
+						<< "*: the posture " << postureList[i].name() << " is in the category " << markedName << '.');
+			}
+		}
+		program.addCategory(markedCategory->code());
+		program.addOperation(RuleBooleanProgram::OP_OR);
+	}
+}
+
 /*******************************************************************************
  *
  */
@@ -454,6 +610,15 @@ Rule::evalBooleanExpression(const std::vector<const Posture*>& postureSequence)
 	if (postureSequence.size() < booleanNodeList_.size()) return false;
 	if (booleanNodeList_.empty()) return false;
 
+	if (!booleanProgramList_.empty()) {
+		for (std::vector<RuleBooleanProgram>::size_type size = booleanProgramList_.size(), i = 0; i < size; ++i) {
+			if ( !(booleanProgramList_[i].eval(*postureSequence[i])) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
 	for (RuleBooleanNodeList::size_type size = booleanNodeList_.size(), i = 0; i < size; ++i) {
 		if ( !(booleanNodeList_[i]->eval(*postureSequence[i])) ) {
 			return false;
@@ -470,9 +635,27 @@ Rule::evalBooleanExpression(const Posture& posture, unsigned int expressionIndex
 {
 	if (expressionIndex >= booleanNodeList_.size()) return false;
 
+	if (!booleanProgramList_.empty()) {
+		return booleanProgramList_[expressionIndex].eval(posture);
+	}
 	return booleanNodeList_[expressionIndex]->eval(posture);
 }
 
+/*******************************************************************************
+ * Compiles the boolean expressions to postfix programs.
+ *
+ * The category codes and the category bitsets of the postures must be up to date.
+ */
+void
+Rule::compileBooleanExpressions(const Model& model)
+{
+	std::vector<RuleBooleanProgram> programList(booleanNodeList_.size());
+	for (RuleBooleanNodeList::size_type size = booleanNodeList_.size(), i = 0; i < size; ++i) {
+		booleanNodeList_[i]->compile(model, programList[i]);
+	}
+	std::swap(booleanProgramList_, programList);
+}
+
 /*******************************************************************************
  *
  */
@@ -485,76 +668,77 @@ Rule::numberOfExpressions() const
 // ruleSymbols: {rd, beat, mark1, mark2, mark3}
 // tempos[4]
 void
-Rule::evaluateExpressionSymbols(const double* tempos, const std::vector<const Posture*>& postures, Model& model, double* ruleSymbols) const
+Rule::evaluateExpressionSymbols(const double* tempos, const Model& model, const unsigned int* postureIds, unsigned int numPostures,
+					EvaluationContext& context, double* ruleSymbols) const
 {
 	double localTempos[4];
 
-	model.clearFormulaSymbolList();
-	if (postures.size() >= 2) {
-		const Posture& posture = *postures[0];
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION1, posture.getSymbolTarget(1 /* hardcoded */));
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA1      , posture.getSymbolTarget(2 /* hardcoded */));
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB1      , posture.getSymbolTarget(3 /* hardcoded */));
-		const Posture& posture2 = *postures[1];
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION2, posture2.getSymbolTarget(1 /* hardcoded */));
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA2      , posture2.getSymbolTarget(2 /* hardcoded */));
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB2      , posture2.getSymbolTarget(3 /* hardcoded */));
+	context.clearFormulaSymbolList();
+	if (numPostures >= 2) {
+		const unsigned int id = postureIds[0];
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION1, model.postureSymbolTarget(id, 1 /* hardcoded */));
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA1      , model.postureSymbolTarget(id, 2 /* hardcoded */));
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB1      , model.postureSymbolTarget(id, 3 /* hardcoded */));
+		const unsigned int id2 = postureIds[1];
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION2, model.postureSymbolTarget(id2, 1 /* hardcoded */));
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA2      , model.postureSymbolTarget(id2, 2 /* hardcoded */));
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB2      , model.postureSymbolTarget(id2, 3 /* hardcoded */));
 		localTempos[0] = tempos[0];
 		localTempos[1] = tempos[1];
 	} else {
 		localTempos[0] = 0.0;
 		localTempos[1] = 0.0;
 	}
-	if (postures.size() >= 3) {
-		const Posture& posture = *postures[2];
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION3, posture.getSymbolTarget(1 /* hardcoded */));
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA3      , posture.getSymbolTarget(2 /* hardcoded */));
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB3      , posture.getSymbolTarget(3 /* hardcoded */));
+	if (numPostures >= 3) {
+		const unsigned int id = postureIds[2];
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION3, model.postureSymbolTarget(id, 1 /* hardcoded */));
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA3      , model.postureSymbolTarget(id, 2 /* hardcoded */));
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB3      , model.postureSymbolTarget(id, 3 /* hardcoded */));
 		localTempos[2] = tempos[2];
 	} else {
 		localTempos[2] = 0.0;
 	}
-	if (postures.size() == 4) {
-		const Posture& posture = *postures[3];
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION4, posture.getSymbolTarget(1 /* hardcoded */));
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA4      , posture.getSymbolTarget(2 /* hardcoded */));
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB4      , posture.getSymbolTarget(3 /* hardcoded */));
+	if (numPostures == 4) {
+		const unsigned int id = postureIds[3];
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_TRANSITION4, model.postureSymbolTarget(id, 1 /* hardcoded */));
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSA4      , model.postureSymbolTarget(id, 2 /* hardcoded */));
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_QSSB4      , model.postureSymbolTarget(id, 3 /* hardcoded */));
 		localTempos[3] = tempos[3];
 	} else {
 		localTempos[3] = 0.0;
 	}
-	model.setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO1, static_cast<float>(localTempos[0]));
-	model.setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO2, static_cast<float>(localTempos[1]));
-	model.setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO3, static_cast<float>(localTempos[2]));
-	model.setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO4, static_cast<float>(localTempos[3]));
-	model.setFormulaSymbolValue(FormulaSymbol::SYMB_RD   , static_cast<float>(ruleSymbols[0]));
-	model.setFormulaSymbolValue(FormulaSymbol::SYMB_BEAT , static_cast<float>(ruleSymbols[1]));
-	model.setFormulaSymbolValue(FormulaSymbol::SYMB_MARK1, static_cast<float>(ruleSymbols[2]));
-	model.setFormulaSymbolValue(FormulaSymbol::SYMB_MARK2, static_cast<float>(ruleSymbols[3]));
-	model.setFormulaSymbolValue(FormulaSymbol::SYMB_MARK3, static_cast<float>(ruleSymbols[4]));
+	context.setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO1, static_cast<float>(localTempos[0]));
+	context.setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO2, static_cast<float>(localTempos[1]));
+	context.setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO3, static_cast<float>(localTempos[2]));
+	context.setFormulaSymbolValue(FormulaSymbol::SYMB_TEMPO4, static_cast<float>(localTempos[3]));
+	context.setFormulaSymbolValue(FormulaSymbol::SYMB_RD   , static_cast<float>(ruleSymbols[0]));
+	context.setFormulaSymbolValue(FormulaSymbol::SYMB_BEAT , static_cast<float>(ruleSymbols[1]));
+	context.setFormulaSymbolValue(FormulaSymbol::SYMB_MARK1, static_cast<float>(ruleSymbols[2]));
+	context.setFormulaSymbolValue(FormulaSymbol::SYMB_MARK2, static_cast<float>(ruleSymbols[3]));
+	context.setFormulaSymbolValue(FormulaSymbol::SYMB_MARK3, static_cast<float>(ruleSymbols[4]));
 
 	// Execute in this order.
 	if (exprSymbolEquations_.ruleDuration) {
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_RD   , model.evalEquationFormula(*exprSymbolEquations_.ruleDuration));
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_RD   , context.evalEquationFormula(*exprSymbolEquations_.ruleDuration));
 	}
 	if (exprSymbolEquations_.mark1) {
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_MARK1, model.evalEquationFormula(*exprSymbolEquations_.mark1));
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_MARK1, context.evalEquationFormula(*exprSymbolEquations_.mark1));
 	}
 	if (exprSymbolEquations_.mark2) {
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_MARK2, model.evalEquationFormula(*exprSymbolEquations_.mark2));
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_MARK2, context.evalEquationFormula(*exprSymbolEquations_.mark2));
 	}
 	if (exprSymbolEquations_.mark3) {
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_MARK3, model.evalEquationFormula(*exprSymbolEquations_.mark3));
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_MARK3, context.evalEquationFormula(*exprSymbolEquations_.mark3));
 	}
 	if (exprSymbolEquations_.beat) {
-		model.setFormulaSymbolValue(FormulaSymbol::SYMB_BEAT , model.evalEquationFormula(*exprSymbolEquations_.beat));
+		context.setFormulaSymbolValue(FormulaSymbol::SYMB_BEAT , context.evalEquationFormula(*exprSymbolEquations_.beat));
 	}
 
-	ruleSymbols[0] = model.getFormulaSymbolValue(FormulaSymbol::SYMB_RD);
-	ruleSymbols[1] = model.getFormulaSymbolValue(FormulaSymbol::SYMB_BEAT);
-	ruleSymbols[2] = model.getFormulaSymbolValue(FormulaSymbol::SYMB_MARK1);
-	ruleSymbols[3] = model.getFormulaSymbolValue(FormulaSymbol::SYMB_MARK2);
-	ruleSymbols[4] = model.getFormulaSymbolValue(FormulaSymbol::SYMB_MARK3);
+	ruleSymbols[0] = context.getFormulaSymbolValue(FormulaSymbol::SYMB_RD);
+	ruleSymbols[1] = context.getFormulaSymbolValue(FormulaSymbol::SYMB_BEAT);
+	ruleSymbols[2] = context.getFormulaSymbolValue(FormulaSymbol::SYMB_MARK1);
+	ruleSymbols[3] = context.getFormulaSymbolValue(FormulaSymbol::SYMB_MARK2);
+	ruleSymbols[4] = context.getFormulaSymbolValue(FormulaSymbol::SYMB_MARK3);
 }
 
 void
@@ -574,6 +758,7 @@ Rule::setBooleanExpressionList(const std::vector<std::string>& exprList, const M
 
 	booleanExpressionList_ = exprList;
 	std::swap(booleanNodeList_, testBooleanNodeList);
+	booleanProgramList_.clear();
 }
 
 } /* namespace TRMControlModel */
@@ -23,6 +23,7 @@
 #ifndef TRM_CONTROL_MODEL_RULE_H_
 #define TRM_CONTROL_MODEL_RULE_H_
 
+#include <cstdint>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -38,16 +39,52 @@ namespace TRMControlModel {
 
 class Category;
 class Equation;
+class EvaluationContext;
 class Model;
 class Posture;
 class Transition;
 
+/*******************************************************************************
+ * Boolean expression compiled to postfix form.
+ *
+ * The evaluation uses a stack of bits and the category bitsets of the postures.
+ */
+class RuleBooleanProgram {
+public:
+	enum OpCode {
+		OP_CATEGORY,
+		OP_AND,
+		OP_OR,
+		OP_XOR,
+		OP_NOT
+	};
+	enum {
+		MAX_STACK_SIZE = 32
+	};
+
+	RuleBooleanProgram() : stackSize_(0), maxStackSize_(0) {}
+
+	void addCategory(unsigned int categoryCode);
+	void addOperation(OpCode op);
+	bool eval(const Posture& posture) const;
+private:
+	struct Instruction {
+		OpCode op;
+		unsigned int categoryCode;
+	};
+
+	std::vector<Instruction> instructionList_;
+	unsigned int stackSize_;
+	unsigned int maxStackSize_;
+};
+
 class RuleBooleanNode {
 public:
 	virtual ~RuleBooleanNode();
 
 	virtual bool eval(const Posture& posture) const = 0;
 	virtual void print(std::ostream& out, int level = 0) const = 0;
+	virtual void compile(const Model& model, RuleBooleanProgram& program) const = 0;
 };
 
 typedef std::unique_ptr<RuleBooleanNode> RuleBooleanNode_ptr;
@@ -62,6 +99,7 @@ public:
 
 	virtual bool eval(const Posture& posture) const;
 	virtual void print(std::ostream& out, int level = 0) const;
+	virtual void compile(const Model& model, RuleBooleanProgram& program) const;
 private:
 	RuleBooleanNode_ptr child1_;
 	RuleBooleanNode_ptr child2_;
@@ -75,6 +113,7 @@ public:
 
 	virtual bool eval(const Posture& posture) const;
 	virtual void print(std::ostream& out, int level = 0) const;
+	virtual void compile(const Model& model, RuleBooleanProgram& program) const;
 private:
 	RuleBooleanNode_ptr child1_;
 	RuleBooleanNode_ptr child2_;
@@ -88,6 +127,7 @@ public:
 
 	virtual bool eval(const Posture& posture) const;
 	virtual void print(std::ostream& out, int level = 0) const;
+	virtual void compile(const Model& model, RuleBooleanProgram& program) const;
 private:
 	RuleBooleanNode_ptr child1_;
 	RuleBooleanNode_ptr child2_;
@@ -101,6 +141,7 @@ public:
 
 	virtual bool eval(const Posture& posture) const;
 	virtual void print(std::ostream& out, int level = 0) const;
+	virtual void compile(const Model& model, RuleBooleanProgram& program) const;
 private:
 	RuleBooleanNode_ptr child_;
 };
@@ -113,6 +154,7 @@ public:
 
 	virtual bool eval(const Posture& posture) const;
 	virtual void print(std::ostream& out, int level = 0) const;
+	virtual void compile(const Model& model, RuleBooleanProgram& program) const;
 private:
 	const std::shared_ptr<Category> category_;
 	bool matchAll_;
@@ -138,6 +180,7 @@ public:
 	bool evalBooleanExpression(const std::vector<const Posture*>& postureSequence) const;
 	bool evalBooleanExpression(const Posture& posture, unsigned int expressionIndex) const;
 	void printBooleanNodeTree() const;
+	void compileBooleanExpressions(const Model& model);
 
 	ExpressionSymbolEquations& exprSymbolEquations() { return exprSymbolEquations_; }
 	const ExpressionSymbolEquations& exprSymbolEquations() const { return exprSymbolEquations_; }
@@ -172,7 +215,9 @@ public:
 		specialProfileTransitionList_[parameterIndex] = transition;
 	}
 
-	void evaluateExpressionSymbols(const double* tempos, const std::vector<const Posture*>& postures, Model& model, double* ruleSymbols) const;
+	// The posture ids must be valid (see Model::isValidPostureId()).
+	void evaluateExpressionSymbols(const double* tempos, const Model& model, const unsigned int* postureIds, unsigned int numPostures,
+					EvaluationContext& context, double* ruleSymbols) const;
 
 	const std::vector<std::string>& booleanExpressionList() const { return booleanExpressionList_; }
 	void setBooleanExpressionList(const std::vector<std::string>& exprList, const Model& model);
@@ -192,6 +237,7 @@ private:
 	ExpressionSymbolEquations exprSymbolEquations_;
 	std::string comment_;
 	RuleBooleanNodeList booleanNodeList_;
+	std::vector<RuleBooleanProgram> booleanProgramList_; // empty if the expressions have not been compiled
 };
 
 } /* namespace TRMControlModel */
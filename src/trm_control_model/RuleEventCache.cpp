@@ -0,0 +1,229 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "RuleEventCache.h"
+
+#include <cmath> /* llround */
+#include <cstring> /* memcpy */
+#include <iterator> /* prev */
+
+#include "Exception.h"
+
+
+
+namespace GS {
+namespace TRMControlModel {
+
+/*******************************************************************************
+ *
+ */
+bool
+RuleEventCache::Key::operator==(const Key& other) const
+{
+	if (ruleIndex != other.ruleIndex || numPostures != other.numPostures || ruleTempo != other.ruleTempo) {
+		return false;
+	}
+	for (unsigned int i = 0; i < numPostures; ++i) {
+		if (postureIds[i] != other.postureIds[i] || tempos[i] != other.tempos[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*******************************************************************************
+ * FNV-1a.
+ */
+std::size_t
+RuleEventCache::KeyHash::operator()(const Key& key) const
+{
+	std::uint64_t h = 14695981039346656037ULL;
+	auto add = [&h](std::uint64_t value) {
+		h ^= value;
+		h *= 1099511628211ULL;
+	};
+	add(key.ruleIndex);
+	add(key.numPostures);
+	add(key.ruleTempo);
+	for (unsigned int i = 0; i < key.numPostures; ++i) {
+		add(key.postureIds[i]);
+		add(key.tempos[i]);
+	}
+	return static_cast<std::size_t>(h);
+}
+
+/*******************************************************************************
+ * Constructor.
+ */
+RuleEventCache::RuleEventCache(unsigned int maxSize, double tempoQuantum)
+		: maxSize_(maxSize)
+		, tempoQuantum_(0.0)
+{
+	setTempoQuantum(tempoQuantum);
+}
+
+/*******************************************************************************
+ * Destructor.
+ */
+RuleEventCache::~RuleEventCache()
+{
+}
+
+/*******************************************************************************
+ *
+ */
+void
+RuleEventCache::setMaxSize(unsigned int maxSize)
+{
+	maxSize_ = maxSize;
+	while (map_.size() > maxSize_) {
+		map_.erase(entryList_.back().key);
+		entryList_.pop_back();
+		++statistics_.evictions;
+	}
+}
+
+/*******************************************************************************
+ * The cache is cleared, because the keys depend on the quantum.
+ */
+void
+RuleEventCache::setTempoQuantum(double tempoQuantum)
+{
+	if (!(tempoQuantum >= 0.0)) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid tempo quantum: " << tempoQuantum << '.');
+	}
+	tempoQuantum_ = tempoQuantum;
+	clear();
+}
+
+/*******************************************************************************
+ *
+ */
+std::int64_t
+RuleEventCache::quantizeTempo(double tempo) const
+{
+	if (tempoQuantum_ == 0.0) {
+		std::int64_t bits;
+		std::memcpy(&bits, &tempo, sizeof bits);
+		return bits;
+	}
+	return std::llround(tempo / tempoQuantum_);
+}
+
+/*******************************************************************************
+ *
+ */
+void
+RuleEventCache::makeKey(unsigned int ruleIndex, const unsigned int* postureIds, unsigned int numPostures,
+			const double* tempos, float ruleTempo, Key& key) const
+{
+	if (numPostures > MAX_POSTURES) {
+		THROW_EXCEPTION(InvalidParameterException, "Invalid number of postures: " << numPostures << '.');
+	}
+	key.ruleIndex = ruleIndex;
+	key.numPostures = numPostures;
+	for (unsigned int i = 0; i < numPostures; ++i) {
+		key.postureIds[i] = postureIds[i];
+		key.tempos[i] = quantizeTempo(tempos[i]);
+	}
+	key.ruleTempo = quantizeTempo(ruleTempo);
+}
+
+/*******************************************************************************
+ *
+ */
+const RuleEventCache::Template*
+RuleEventCache::find(const Key& key)
+{
+	++statistics_.lookups;
+
+	auto iter = map_.find(key);
+	if (iter == map_.end()) {
+		return nullptr;
+	}
+	++statistics_.hits;
+	entryList_.splice(entryList_.begin(), entryList_, iter->second);
+	return &iter->second->value;
+}
+
+/*******************************************************************************
+ * The node of the least recently used entry is reused when the cache is full.
+ */
+void
+RuleEventCache::insert(const Key& key, const Template& value)
+{
+	if (maxSize_ == 0) {
+		return;
+	}
+
+	auto iter = map_.find(key);
+	if (iter != map_.end()) {
+		iter->second->value = value;
+		entryList_.splice(entryList_.begin(), entryList_, iter->second);
+		return;
+	}
+
+	if (map_.size() >= maxSize_) {
+		map_.erase(entryList_.back().key);
+		entryList_.splice(entryList_.begin(), entryList_, std::prev(entryList_.end()));
+		++statistics_.evictions;
+	} else {
+		entryList_.emplace_front();
+	}
+	Entry& entry = entryList_.front();
+	entry.key = key;
+	entry.value = value;
+	map_[key] = entryList_.begin();
+}
+
+/*******************************************************************************
+ *
+ */
+void
+RuleEventCache::clear()
+{
+	map_.clear();
+	entryList_.clear();
+}
+
+/*******************************************************************************
+ *
+ */
+double
+RuleEventCache::hitRate() const
+{
+	if (statistics_.lookups == 0) {
+		return 0.0;
+	}
+	return static_cast<double>(statistics_.hits) / statistics_.lookups;
+}
+
+/*******************************************************************************
+ *
+ */
+void
+RuleEventCache::printStatistics(std::ostream& out) const
+{
+	out << "Rule event cache: lookups=" << statistics_.lookups
+		<< " hits=" << statistics_.hits
+		<< " hit_rate=" << hitRate()
+		<< " evictions=" << statistics_.evictions
+		<< " size=" << map_.size() << '/' << maxSize_ << std::endl;
+}
+
+} /* namespace TRMControlModel */
+} /* namespace GS */
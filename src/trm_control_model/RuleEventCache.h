@@ -0,0 +1,126 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef TRM_CONTROL_MODEL_RULE_EVENT_CACHE_H_
+#define TRM_CONTROL_MODEL_RULE_EVENT_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+
+
+namespace GS {
+namespace TRMControlModel {
+
+/*******************************************************************************
+ * Memoization of the events created by the application of a rule.
+ *
+ * The key is formed by the rule index, the posture ids and the tempos. If the
+ * tempo quantum is zero, the tempos are compared exactly and a cached template
+ * produces the same events as the evaluation of the rule. Otherwise the tempos
+ * are quantized, and the template of the first application in each quantum is
+ * reused.
+ *
+ * The least recently used template is discarded when the cache is full.
+ */
+class RuleEventCache {
+public:
+	enum {
+		DEFAULT_MAX_SIZE = 4096,
+		MAX_POSTURES = 4
+	};
+
+	struct Key {
+		unsigned int ruleIndex;
+		unsigned int numPostures;
+		unsigned int postureIds[MAX_POSTURES];
+		std::int64_t tempos[MAX_POSTURES];
+		std::int64_t ruleTempo;
+
+		bool operator==(const Key& other) const;
+	};
+	// Arguments of one call to EventList::insertEvent.
+	struct EventCall {
+		int number;
+		double time; // relative to the zero reference, not multiplied by the rule tempo
+		double value;
+		bool setFlag;
+	};
+	struct Template {
+		double ruleSymbols[5];
+		std::vector<EventCall> eventList;
+	};
+	struct Statistics {
+		unsigned long long lookups;
+		unsigned long long hits;
+		unsigned long long evictions;
+
+		Statistics() : lookups(0), hits(0), evictions(0) {}
+	};
+
+	explicit RuleEventCache(unsigned int maxSize = DEFAULT_MAX_SIZE, double tempoQuantum = 0.0);
+	~RuleEventCache();
+
+	// maxSize = 0 disables the cache.
+	void setMaxSize(unsigned int maxSize);
+	unsigned int maxSize() const { return maxSize_; }
+	void setTempoQuantum(double tempoQuantum);
+	double tempoQuantum() const { return tempoQuantum_; }
+	bool enabled() const { return maxSize_ > 0; }
+
+	void makeKey(unsigned int ruleIndex, const unsigned int* postureIds, unsigned int numPostures,
+			const double* tempos, float ruleTempo, Key& key) const;
+	// Returns nullptr if the key is not in the cache.
+	// The pointer is valid until the next call to insert() or clear().
+	const Template* find(const Key& key);
+	void insert(const Key& key, const Template& value);
+	void clear();
+	unsigned int size() const { return map_.size(); }
+
+	const Statistics& statistics() const { return statistics_; }
+	void resetStatistics() { statistics_ = Statistics(); }
+	double hitRate() const;
+	void printStatistics(std::ostream& out) const;
+private:
+	struct KeyHash {
+		std::size_t operator()(const Key& key) const;
+	};
+	struct Entry {
+		Key key;
+		Template value;
+	};
+	typedef std::list<Entry> EntryList;
+
+	RuleEventCache(const RuleEventCache&) = delete;
+	RuleEventCache& operator=(const RuleEventCache&) = delete;
+
+	std::int64_t quantizeTempo(double tempo) const;
+
+	unsigned int maxSize_;
+	double tempoQuantum_;
+	EntryList entryList_; // the most recently used entry is at the front
+	std::unordered_map<Key, EntryList::iterator, KeyHash> map_;
+	Statistics statistics_;
+};
+
+} /* namespace TRMControlModel */
+} /* namespace GS */
+
+#endif /* TRM_CONTROL_MODEL_RULE_EVENT_CACHE_H_ */
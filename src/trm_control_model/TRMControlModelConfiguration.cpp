@@ -39,6 +39,7 @@ Configuration::Configuration()
 		, pretonicLift(0.0)
 		, tonicRange(0.0)
 		, tonicMovement(0.0)
+		, modelCacheEnabled(false)
 {
 }
 
@@ -80,6 +81,13 @@ Configuration::load(const std::string& configFilePath)
 	dictionary1File = reader.value<std::string>("dictionary_1_file");
 	dictionary2File = reader.value<std::string>("dictionary_2_file");
 	dictionary3File = reader.value<std::string>("dictionary_3_file");
+	// Optional, for the configurations created before the key was added.
+	if (reader.hasKey("pronunciation_cache_file")) {
+		pronunciationCacheFile = reader.value<std::string>("pronunciation_cache_file");
+	} else {
+		pronunciationCacheFile = "none";
+	}
+	modelCacheEnabled = reader.hasKey("model_cache") && reader.value<int>("model_cache") != 0;
 }
 
 } /* namespace TRMControlModel */
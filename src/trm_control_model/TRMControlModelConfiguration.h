@@ -60,6 +60,8 @@ struct Configuration {
 	std::string dictionary1File;
 	std::string dictionary2File;
 	std::string dictionary3File;
+	std::string pronunciationCacheFile;
+	bool modelCacheEnabled; // see Model::setBinaryCacheEnabled
 };
 
 } /* namespace TRMControlModel */
@@ -22,7 +22,9 @@
 
 #include "Transition.h"
 
-#include "Model.h"
+#include <utility> /* swap */
+
+#include "EvaluationContext.h"
 
 
 
@@ -39,38 +41,94 @@ Transition::SlopeRatio::totalSlopeUnits() const
 	return temp;
 }
 
+/*******************************************************************************
+ * Builds the flat representation of the point/slope list.
+ *
+ * The equations are referenced by raw pointers, so they must not be
+ * removed from the model while the compiled data is in use.
+ */
+void
+Transition::compile()
+{
+	std::vector<CompiledPointOrSlope> pointOrSlopeList;
+	std::vector<CompiledPoint> pointList;
+	std::vector<float> slopeList;
+
+	auto addPoint = [&](const Point& point) {
+		CompiledPoint p;
+		p.type = point.type;
+		p.isPhantom = point.isPhantom;
+		p.value = point.value;
+		p.freeTime = point.freeTime;
+		p.timeExpression = point.timeExpression.get();
+		pointList.push_back(p);
+	};
+
+	for (const auto& pointOrSlope : pointOrSlopeList_) {
+		CompiledPointOrSlope item;
+		item.firstPoint = pointList.size();
+		item.firstSlope = slopeList.size();
+		if (pointOrSlope->isSlopeRatio()) {
+			const auto& slopeRatio = static_cast<const SlopeRatio&>(*pointOrSlope);
+			if (slopeRatio.pointList.size() < 2 || slopeRatio.slopeList.size() + 1U != slopeRatio.pointList.size()) {
+				THROW_EXCEPTION(TRMControlModelException, "Invalid slope ratio in transition " << name_ << '.');
+			}
+			for (const auto& point : slopeRatio.pointList) {
+				addPoint(*point);
+			}
+			for (const auto& slope : slopeRatio.slopeList) {
+				slopeList.push_back(slope->slope);
+			}
+			item.isSlopeRatio = true;
+			item.totalSlopeUnits = slopeRatio.totalSlopeUnits();
+		} else {
+			addPoint(static_cast<const Point&>(*pointOrSlope));
+			item.isSlopeRatio = false;
+			item.totalSlopeUnits = 0.0;
+		}
+		item.numPoints = pointList.size() - item.firstPoint;
+		item.numSlopes = slopeList.size() - item.firstSlope;
+		pointOrSlopeList.push_back(item);
+	}
+
+	std::swap(compiledPointOrSlopeList_, pointOrSlopeList);
+	std::swap(compiledPointList_, pointList);
+	std::swap(compiledSlopeList_, slopeList);
+	compiled_ = true;
+}
+
 double
-Transition::getPointTime(const Transition::Point& point, const Model& model)
+Transition::getPointTime(const Transition::CompiledPoint& point, EvaluationContext& context)
 {
 	if (!point.timeExpression) {
 		return point.freeTime;
 	} else {
-		return model.evalEquationFormula(*point.timeExpression);
+		return context.evalEquationFormula(*point.timeExpression);
 	}
 }
 
 void
-Transition::getPointData(const Transition::Point& point, const Model& model,
+Transition::getPointData(const Transition::CompiledPoint& point, EvaluationContext& context,
 				double& time, double& value)
 {
 	if (!point.timeExpression) {
 		time = point.freeTime;
 	} else {
-		time = model.evalEquationFormula(*point.timeExpression);
+		time = context.evalEquationFormula(*point.timeExpression);
 	}
 
 	value = point.value;
 }
 
 void
-Transition::getPointData(const Transition::Point& point, const Model& model,
+Transition::getPointData(const Transition::CompiledPoint& point, EvaluationContext& context,
 				double baseline, double delta, double min, double max,
 				double& time, double& value)
 {
 	if (!point.timeExpression) {
 		time = point.freeTime;
 	} else {
-		time = model.evalEquationFormula(*point.timeExpression);
+		time = context.evalEquationFormula(*point.timeExpression);
 	}
 
 	value = baseline + ((point.value / 100.0) * delta);
@@ -35,7 +35,7 @@
 namespace GS {
 namespace TRMControlModel {
 
-class Model;
+class EvaluationContext;
 
 class Transition {
 public:
@@ -128,6 +128,23 @@ public:
 		SlopeRatio& operator=(const SlopeRatio&) = delete;
 	};
 
+	// Flat representation of the point/slope list, built by compile().
+	struct CompiledPoint {
+		Point::Type type;
+		bool isPhantom;
+		float value;
+		float freeTime;
+		const Equation* timeExpression; // if null, time = freeTime
+	};
+	struct CompiledPointOrSlope {
+		bool isSlopeRatio;
+		unsigned int firstPoint; // index in the compiled point list
+		unsigned int numPoints;  // 1 if this is a point
+		unsigned int firstSlope; // index in the compiled slope list
+		unsigned int numSlopes;  // 0 if this is a point
+		double totalSlopeUnits;
+	};
+
 	Transition(
 		const std::string& name,
 		Type type,
@@ -135,6 +152,7 @@ public:
 			: name_(name)
 			, type_(type)
 			, special_(special)
+			, compiled_(false)
 	{
 	}
 
@@ -146,6 +164,10 @@ public:
 		, special_(o.special_)
 		, pointOrSlopeList_(std::move(o.pointOrSlopeList_))
 		, comment_(std::move(o.comment_))
+		, compiled_(o.compiled_)
+		, compiledPointOrSlopeList_(std::move(o.compiledPointOrSlopeList_))
+		, compiledPointList_(std::move(o.compiledPointList_))
+		, compiledSlopeList_(std::move(o.compiledSlopeList_))
 	{}
 	Transition& operator=(Transition&& o) {
 		if (this != &o) {
@@ -154,6 +176,10 @@ public:
 			this->special_ = o.special_;
 			this->pointOrSlopeList_ = std::move(o.pointOrSlopeList_);
 			this->comment_ = std::move(o.comment_);
+			this->compiled_ = o.compiled_;
+			this->compiledPointOrSlopeList_ = std::move(o.compiledPointOrSlopeList_);
+			this->compiledPointList_ = std::move(o.compiledPointList_);
+			this->compiledSlopeList_ = std::move(o.compiledSlopeList_);
 		}
 		return *this;
 	}
@@ -173,10 +199,17 @@ public:
 	std::vector<PointOrSlope_ptr>& pointOrSlopeList() { return pointOrSlopeList_; }
 	const std::vector<PointOrSlope_ptr>& pointOrSlopeList() const { return pointOrSlopeList_; }
 
-	static double getPointTime(const Transition::Point& point, const Model& model);
-	static void getPointData(const Transition::Point& point, const Model& model,
+	// Must be called again after the point/slope list is modified.
+	void compile();
+	bool compiled() const { return compiled_; }
+	const std::vector<CompiledPointOrSlope>& compiledPointOrSlopeList() const { return compiledPointOrSlopeList_; }
+	const std::vector<CompiledPoint>& compiledPointList() const { return compiledPointList_; }
+	const std::vector<float>& compiledSlopeList() const { return compiledSlopeList_; }
+
+	static double getPointTime(const Transition::CompiledPoint& point, EvaluationContext& context);
+	static void getPointData(const Transition::CompiledPoint& point, EvaluationContext& context,
 					double& time, double& value);
-	static void getPointData(const Transition::Point& point, const Model& model,
+	static void getPointData(const Transition::CompiledPoint& point, EvaluationContext& context,
 					double baseline, double delta, double min, double max,
 					double& time, double& value);
 	static Type getTypeFromName(const std::string& typeName) {
@@ -210,6 +243,10 @@ private:
 	bool special_;
 	std::vector<PointOrSlope_ptr> pointOrSlopeList_;
 	std::string comment_;
+	bool compiled_;
+	std::vector<CompiledPointOrSlope> compiledPointOrSlopeList_;
+	std::vector<CompiledPoint> compiledPointList_;
+	std::vector<float> compiledSlopeList_;
 };
 
 struct TransitionGroup {
@@ -0,0 +1,82 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include "VoiceSet.h"
+
+#include <fstream>
+#include <sstream>
+
+#define TRM_CONFIG_FILE_NAME "/trm.txt"
+#define VOICE_FILE_PREFIX "/voice_"
+
+
+
+namespace {
+
+const char* standardVoiceNames[] = {
+	"male",
+	"female",
+	"large_child",
+	"small_child",
+	"baby"
+};
+
+} /* namespace */
+
+namespace GS {
+namespace TRMControlModel {
+
+VoiceSet::VoiceSet(const char* configDirPath)
+{
+	for (const char* voiceName : standardVoiceNames) {
+		std::ostringstream voiceFilePath;
+		voiceFilePath << configDirPath << VOICE_FILE_PREFIX << voiceName << ".txt";
+		if (!std::ifstream(voiceFilePath.str())) {
+			continue;
+		}
+		loadVoice(configDirPath, voiceName, voiceMap_[voiceName]);
+	}
+}
+
+VoiceSet::~VoiceSet()
+{
+}
+
+const TRM::Configuration*
+VoiceSet::voice(const std::string& voiceName) const
+{
+	auto iter = voiceMap_.find(voiceName);
+	if (iter == voiceMap_.end()) {
+		return nullptr;
+	}
+	return &iter->second;
+}
+
+void
+VoiceSet::loadVoice(const std::string& configDirPath, const std::string& voiceName, TRM::Configuration& config)
+{
+	std::ostringstream trmConfigFilePath;
+	trmConfigFilePath << configDirPath << TRM_CONFIG_FILE_NAME;
+
+	std::ostringstream voiceFilePath;
+	voiceFilePath << configDirPath << VOICE_FILE_PREFIX << voiceName << ".txt";
+
+	config.load(trmConfigFilePath.str(), voiceFilePath.str());
+}
+
+} /* namespace TRMControlModel */
+} /* namespace GS */
@@ -0,0 +1,57 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#ifndef TRM_CONTROL_MODEL_VOICE_SET_H_
+#define TRM_CONTROL_MODEL_VOICE_SET_H_
+
+#include <map>
+#include <string>
+
+#include "TRMConfiguration.h"
+
+
+
+namespace GS {
+namespace TRMControlModel {
+
+/*******************************************************************************
+ * The TRM configurations of the standard voices, loaded once from the
+ * configuration directory. The set is not modified after the construction, so
+ * it may be shared by many controllers, used by different threads.
+ */
+class VoiceSet {
+public:
+	// The voices whose files do not exist are not loaded.
+	explicit VoiceSet(const char* configDirPath);
+	~VoiceSet();
+
+	// Returns nullptr if the voice is not in the set.
+	const TRM::Configuration* voice(const std::string& voiceName) const;
+
+	// Loads trm.txt and the file of the voice.
+	static void loadVoice(const std::string& configDirPath, const std::string& voiceName, TRM::Configuration& config);
+private:
+	VoiceSet(const VoiceSet&) = delete;
+	VoiceSet& operator=(const VoiceSet&) = delete;
+
+	std::map<std::string, TRM::Configuration> voiceMap_;
+};
+
+} /* namespace TRMControlModel */
+} /* namespace GS */
+
+#endif /* TRM_CONTROL_MODEL_VOICE_SET_H_ */
@@ -0,0 +1,165 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <algorithm> /* all_of, equal */
+#include <cstddef> /* std::size_t */
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.h"
+#include "en/RealTimeSynthesizer.h"
+#include "en/Synthesizer.h"
+#include "en/text_parser/TextParser.h"
+#include "Exception.h"
+#include "global.h"
+#include "Model.h"
+#include "TRMControlModelConfiguration.h"
+#include "VoiceSet.h"
+
+
+
+namespace {
+
+const char* const TEXT = "Hello world. The quick brown fox jumps over the lazy dog! Is this the right way?";
+const std::size_t BLOCK_FRAMES = 256;
+const double BUFFER_SECONDS = 0.25; // less than a sentence, so the worker must wait for the consumer
+
+int failures = 0;
+
+void
+check(bool condition, const char* message)
+{
+	if (!condition) {
+		std::cerr << "Failed: " << message << std::endl;
+		++failures;
+	}
+}
+
+// A push blocked on a full queue must return when the queue is closed.
+void
+testClosedQueue()
+{
+	GS::BoundedQueue<int> queue(1);
+	check(queue.push(1), "push to an open queue");
+	bool pushed = true;
+	std::thread producer([&]() { pushed = queue.push(2); });
+	queue.close();
+	producer.join();
+	check(!pushed, "push to a closed queue");
+}
+
+} /* namespace */
+
+/*******************************************************************************
+ * Drives RealTimeSynthesizer::pull from a simulated clock. Before each block,
+ * the consumer waits until the block is available or the synthesis has ended,
+ * so the clock never gets ahead of the synthesis and the result does not
+ * depend on the speed of the machine. The pulled samples must be the samples
+ * of Synthesizer::synthesizeSegments, without underruns.
+ */
+int
+main(int argc, char* argv[])
+{
+	if (argc != 2) {
+		std::cerr << "Usage: " << argv[0] << " config_dir" << std::endl;
+		return 1;
+	}
+	const std::string configDirPath = argv[1];
+
+	try {
+		testClosedQueue();
+
+		GS::TRMControlModel::Model model;
+		model.setBinaryCacheEnabled(false); // do not write to the configuration directory
+		model.load(configDirPath.c_str(), TRM_CONTROL_MODEL_CONFIG_FILE);
+
+		GS::TRMControlModel::Configuration config;
+		config.load(configDirPath + "/trm_control_model.txt");
+		GS::En::TextParser textParser(configDirPath.c_str(),
+						config.dictionary1File,
+						config.dictionary2File,
+						config.dictionary3File);
+		textParser.setModel(model);
+		const GS::TRMControlModel::VoiceSet voiceSet(configDirPath.c_str());
+
+		// The random intonation would make the outputs different.
+		GS::En::Synthesizer synthesizer(configDirPath.c_str(), model, textParser, voiceSet);
+		GS::En::Synthesizer::Parameters parameters = synthesizer.defaultParameters();
+		parameters.intonation &= ~(GS::TRMControlModel::Configuration::INTONATION_DRIFT |
+						GS::TRMControlModel::Configuration::INTONATION_RANDOMIZE);
+		synthesizer.setParameters(parameters);
+
+		std::vector<float> expected;
+		std::vector<float> buffer;
+		synthesizer.synthesizeSegments(TEXT, buffer,
+			[&](const std::vector<float>& segment) -> bool {
+				expected.insert(expected.end(), segment.begin(), segment.end());
+				return true;
+			});
+
+		GS::En::RealTimeSynthesizer realTimeSynthesizer(configDirPath.c_str(), model, textParser, voiceSet,
+									parameters, BUFFER_SECONDS);
+		const int channels = realTimeSynthesizer.channels();
+		std::vector<float> block(BLOCK_FRAMES * channels);
+
+		// Nothing to synthesize: silence, but not an underrun.
+		realTimeSynthesizer.pull(block.data(), BLOCK_FRAMES);
+		check(std::all_of(block.begin(), block.end(), [](float s) { return s == 0.0f; }), "silence before speak");
+
+		std::vector<float> output;
+		unsigned long clockFrames = BLOCK_FRAMES;
+		realTimeSynthesizer.speak(TEXT);
+		while (!realTimeSynthesizer.idle()) {
+			while (realTimeSynthesizer.availableFrames() < BLOCK_FRAMES && realTimeSynthesizer.synthesizing()) {
+				std::this_thread::yield();
+			}
+			realTimeSynthesizer.pull(block.data(), BLOCK_FRAMES);
+			output.insert(output.end(), block.begin(), block.end());
+			clockFrames += BLOCK_FRAMES;
+		}
+
+		const GS::En::RealTimeSynthesizer::Statistics statistics = realTimeSynthesizer.statistics();
+		check(statistics.errors == 0, "no errors");
+		check(statistics.underruns == 0 && statistics.underrunFrames == 0, "no underruns");
+		check(statistics.texts == 1, "one text");
+		check(statistics.pulledFrames == clockFrames, "pulled frames");
+		check(output.size() >= expected.size() && output.size() - expected.size() < BLOCK_FRAMES * channels,
+			"output size");
+		check(std::equal(expected.begin(), expected.end(), output.begin()), "output samples");
+		check(std::all_of(output.begin() + std::min(expected.size(), output.size()), output.end(),
+					[](float s) { return s == 0.0f; }), "silence after the text");
+
+		realTimeSynthesizer.stop();
+		try {
+			realTimeSynthesizer.speak(TEXT);
+			check(false, "speak after stop");
+		} catch (GS::InvalidStateException&) {
+		}
+		check(realTimeSynthesizer.idle(), "idle after stop");
+
+		std::cout << "Pulled " << clockFrames << " frames (" << clockFrames / realTimeSynthesizer.outputRate()
+			<< " s simulated) in blocks of " << BLOCK_FRAMES << " frames." << std::endl;
+	} catch (std::exception& e) {
+		std::cerr << "Caught an exception: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+/***************************************************************************
+ *  Copyright 2014 Marcelo Y. Matuda                                       *
+ *                                                                         *
+ *  This program is free software: you can redistribute it and/or modify   *
+ *  it under the terms of the GNU General Public License as published by   *
+ *  the Free Software Foundation, either version 3 of the License, or      *
+ *  (at your option) any later version.                                    *
+ *                                                                         *
+ *  This program is distributed in the hope that it will be useful,        *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of         *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          *
+ *  GNU General Public License for more details.                           *
+ *                                                                         *
+ *  You should have received a copy of the GNU General Public License      *
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.  *
+ ***************************************************************************/
+
+#include <atomic>
+#include <cstdlib> /* free, malloc */
+#include <exception>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "en/phonetic_string_parser/PhoneticTokenList.h"
+#include "en/text_parser/TextParser.h"
+#include "global.h"
+#include "Model.h"
+#include "TRMControlModelConfiguration.h"
+
+
+
+namespace {
+
+std::atomic<bool> countAllocations(false);
+std::atomic<unsigned long> numAllocations(0);
+
+void*
+allocate(std::size_t size)
+{
+	if (countAllocations) {
+		++numAllocations;
+	}
+	void* p = std::malloc(size > 0 ? size : 1);
+	if (p == nullptr) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+// The inputs cover words from the dictionary and from the letter-to-sound
+// rules, numbers, abbreviations, letters, modes and long sentences.
+const char* const inputList[] = {
+	"Hello world.",
+	"The quick brown fox jumps over the lazy dog!",
+	"Is this the right way to the station?",
+	"Dr. Smith paid $1,234.56 on Jan. 3rd, 1999, at 10:45 a.m. for 12.5% of 3/4 of the shares.",
+	"Call 555-1234 or write to P.O. Box 42, e.g. the U.S.A. office.",
+	"Zyxwvut qwerplk snarfblat grommeting flibbertigibbets.",
+	"A B C D E F G, and x, y, z.",
+	"Dearest creature in creation, study English pronunciation. I will teach you in my verse "
+		"sounds like corpse, corps, horse, and worse; I will keep you, Suzy, busy, "
+		"make your head with heat grow dizzy.",
+	"She said: \"Don't stop -- keep going\" (quietly); then, after 3 or 4 seconds, she left...",
+	"The year 2024 had 366 days, and the 21st century began on 1/1/2001.",
+};
+
+} /* namespace */
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return std::malloc(size > 0 ? size : 1); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return std::malloc(size > 0 ? size : 1); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+
+
+/*******************************************************************************
+ * Checks that TextParser::parseText does not allocate memory, with or without
+ * the conversion to tokens, after the context buffers, the token list and the
+ * pronunciation cache have been filled.
+ */
+int
+main(int argc, char* argv[])
+{
+	if (argc != 2) {
+		std::cerr << "Usage: " << argv[0] << " config_dir" << std::endl;
+		return 1;
+	}
+	const std::string configDirPath = argv[1];
+
+	try {
+		GS::TRMControlModel::Model model;
+		model.setBinaryCacheEnabled(false); // do not write to the configuration directory
+		model.load(configDirPath.c_str(), TRM_CONTROL_MODEL_CONFIG_FILE);
+
+		GS::TRMControlModel::Configuration config;
+		config.load(configDirPath + "/trm_control_model.txt");
+		GS::En::TextParser textParser(configDirPath.c_str(),
+						config.dictionary1File,
+						config.dictionary2File,
+						config.dictionary3File);
+		textParser.setModel(model);
+		GS::En::TextParser::Context context;
+		GS::En::PhoneticTokenList tokenList;
+
+		// The first pass inserts the words in the pronunciation cache, and
+		// both passes grow the buffers.
+		for (int pass = 0; pass < 2; ++pass) {
+			for (const char* input : inputList) {
+				textParser.parseText(input, context, tokenList);
+			}
+		}
+
+		int failures = 0;
+		for (const char* input : inputList) {
+			for (int withTokens = 0; withTokens < 2; ++withTokens) {
+				numAllocations = 0;
+				countAllocations = true;
+				if (withTokens) {
+					textParser.parseText(input, context, tokenList);
+				} else {
+					textParser.parseText(input, context);
+				}
+				countAllocations = false;
+				if (numAllocations != 0) {
+					std::cerr << "Allocations: " << numAllocations << " Tokens: " << withTokens
+						<< " Input: [" << input << ']' << std::endl;
+					++failures;
+				}
+			}
+		}
+		if (failures > 0) {
+			return 1;
+		}
+	} catch (std::exception& e) {
+		std::cerr << "Caught an exception: " << e.what() << std::endl;
+		return 1;
+	}
+
+	std::cout << "No allocations in " << sizeof inputList / sizeof inputList[0] << " warm parses." << std::endl;
+	return 0;
+}